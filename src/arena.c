@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "enhanced_ds.h"
+
+// ==========================================================
+//   TYPED SLAB POOLS
+//
+//   Each pool hands out records of one fixed size. Records are
+//   carved from large blocks by bumping an index; freed records
+//   go on an intrusive free list and are reused first. Releasing
+//   a pool frees its blocks, never individual records.
+// ==========================================================
+
+struct SlabBlock {
+    struct SlabBlock* next;
+    max_align_t items[];  // items_per_block records of item_size bytes
+};
+
+void poolInit(SlabPool* pool, size_t itemSize, int itemsPerBlock) {
+    size_t align = _Alignof(max_align_t);
+    if (itemSize < sizeof(void*)) itemSize = sizeof(void*);
+    pool->item_size = (itemSize + align - 1) & ~(align - 1);
+    pool->items_per_block = itemsPerBlock;
+    pool->blocks = NULL;
+    pool->block_used = itemsPerBlock;  // Forces a block on first use
+    pool->free_list = NULL;
+    pool->block_count = 0;
+    pool->live = 0;
+    pool->allocations = 0;
+    pool->frees = 0;
+}
+
+void* poolAlloc(SlabPool* pool) {
+    void* item;
+    if (pool->free_list != NULL) {
+        item = pool->free_list;
+        pool->free_list = *(void**)item;
+    } else {
+        if (pool->block_used == pool->items_per_block) {
+            SlabBlock* block = (SlabBlock*)malloc(sizeof(SlabBlock) +
+                                                  pool->item_size * pool->items_per_block);
+            if (block == NULL) return NULL;
+            block->next = pool->blocks;
+            pool->blocks = block;
+            pool->block_used = 0;
+            pool->block_count++;
+        }
+        item = (char*)pool->blocks->items + pool->item_size * pool->block_used++;
+    }
+    pool->live++;
+    pool->allocations++;
+    return item;
+}
+
+void poolFree(SlabPool* pool, void* item) {
+    if (item == NULL) return;
+    *(void**)item = pool->free_list;
+    pool->free_list = item;
+    pool->live--;
+    pool->frees++;
+}
+
+void poolRelease(SlabPool* pool) {
+    SlabBlock* block = pool->blocks;
+    while (block != NULL) {
+        SlabBlock* temp = block;
+        block = block->next;
+        free(temp);
+    }
+    poolInit(pool, pool->item_size, pool->items_per_block);
+}
+
+// One status row: live records against reserved slots. Idle slots are the
+// free list plus the unused tail of the newest block.
+void poolReport(const SlabPool* pool, const char* label) {
+    long reserved = (long)pool->block_count * pool->items_per_block;
+    double reservedKb = reserved * (double)pool->item_size / 1024.0;
+    double idle = reserved > 0 ? 100.0 * (reserved - pool->live) / reserved : 0.0;
+
+    printf("%-14s %10ld %10ld %7d %12.1f %7.1f%% %12ld %10ld\n",
+           label, pool->live, reserved, pool->block_count,
+           reservedKb, idle, pool->allocations, pool->frees);
+}
@@ -0,0 +1,901 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "enhanced_ds.h"
+
+// ==========================================================
+//   HEADLESS BATCH MODE
+//
+//   Input: one student per line, comma or tab separated
+//     reg_number, name, rank, dob, aadhar, preferences
+//   where preferences is a list of program numbers from the
+//   college list (1-8 with the built-in catalog) separated by
+//   ';', '|' or spaces, e.g.
+//     DC201,Asha Rao,17,14-02-2006,1234-5678-9012,3;1;4
+//   An optional seventh field lists the seat pools of the
+//   catalog the student qualifies for besides general merit,
+//   e.g. KQ;SC. Blank lines and lines starting with '#' are ignored, and a
+//   leading header line is skipped.
+//
+//   With --rounds N, rounds 2..N are run after the allotment.
+//   The optional responses file has one line per response:
+//     round, reg_number, accept | float | exit
+//   and a response given in round r takes effect in round r + 1.
+//
+//   --cutoffs writes the closing rank of every program and pool
+//   of the final allotment. --rank-queries reads lines of
+//     rank [, seat pools]
+//   and --rank-answers gets one line per query with the choice
+//   numbers that still had a seat at that rank, e.g.
+//     52000,GM;KQ,3,2;5;8
+//
+//   --what-if reads lines of
+//     reg_number, preferences
+//   and simulates each list against the round 1 allotment
+//   without applying it; --what-if-out gets the seat each
+//   student would get and how many others would move.
+//
+//   --snapshot saves the final session (catalog, students,
+//   allotment) to a file the interactive program can reopen.
+//
+//   --engine deferred allots by deferred acceptance instead of
+//   in rank order; --priorities then reads lines of
+//     reg_number, choice, priority [, seat pool]
+//   where a lower priority wins that program's seats, e.g.
+//     DC201,3,1,KQ
+// ==========================================================
+
+#define BATCH_READ_BUFFER  (1 << 20)
+#define BATCH_FIELD_COUNT  6
+#define BATCH_MAX_REPORTED 20
+#define BATCH_VALIDATE_BLOCK 4096  // Records whose fields are validated together
+
+// Single buffered reader: the file is pulled in large chunks and
+// split into lines in place, so there are no per-field stdio calls.
+typedef struct {
+    FILE* fp;
+    char* buf;
+    size_t len;  // Bytes currently held in buf
+    size_t pos;  // Start of the next unread line
+    bool eof;
+} LineReader;
+
+static char* readLine(LineReader* r) {
+    while (1) {
+        char* start = r->buf + r->pos;
+        char* nl = memchr(start, '\n', r->len - r->pos);
+        if (nl != NULL) {
+            *nl = '\0';
+            r->pos = (size_t)(nl - r->buf) + 1;
+            return start;
+        }
+
+        if (r->eof) {
+            if (r->pos == r->len) return NULL;
+            // Last line without a trailing newline
+            r->buf[r->len] = '\0';
+            r->pos = r->len;
+            return start;
+        }
+
+        // Move the partial line to the front and refill behind it
+        size_t remaining = r->len - r->pos;
+        if (remaining == BATCH_READ_BUFFER) {
+            // Overlong line: hand it back as is, it will fail validation
+            r->buf[r->len] = '\0';
+            r->pos = r->len;
+            return start;
+        }
+        memmove(r->buf, start, remaining);
+        r->len = remaining;
+        r->pos = 0;
+
+        size_t got = fread(r->buf + r->len, 1, BATCH_READ_BUFFER - r->len, r->fp);
+        r->len += got;
+        if (got == 0) r->eof = true;
+    }
+}
+
+static char* trimField(char* field) {
+    while (*field == ' ' || *field == '\t') field++;
+    char* end = field + strlen(field);
+    while (end > field && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r'))
+        end--;
+    *end = '\0';
+
+    // Allow simple "quoted" fields so names may contain the delimiter
+    if (end - field >= 2 && field[0] == '"' && end[-1] == '"') {
+        end[-1] = '\0';
+        field++;
+        // A doubled quote inside stands for one quote
+        char* out = field;
+        for (char* in = field; *in != '\0'; in++) {
+            *out++ = *in;
+            if (in[0] == '"' && in[1] == '"') in++;
+        }
+        *out = '\0';
+    }
+    return field;
+}
+
+// Splits line in place; returns the field count, or maxFields + 1 if
+// there are more fields than that
+int splitFields(char* line, char delim, char** fields, int maxFields) {
+    int count = 0;
+    char* p = line;
+
+    while (count < maxFields) {
+        char* start = p;
+        bool quoted = false;
+        while (*p != '\0' && (quoted || *p != delim)) {
+            if (*p == '"') quoted = !quoted;
+            p++;
+        }
+        bool last = (*p == '\0');
+        *p = '\0';
+        fields[count++] = trimField(start);
+        if (last) return count;
+        p++;
+    }
+    // Too many fields
+    return maxFields + 1;
+}
+
+bool parseRank(const char* text, int* rank) {
+    char* end;
+    long value = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || value < 1 || value > 2147483647L)
+        return false;
+    *rank = (int)value;
+    return true;
+}
+
+// Parses menu choices into ids, which must hold MAX_PREFERENCES entries.
+// Returns NULL on success or the reason the list was refused.
+const char* parsePreferences(char* text, uint16_t* ids, int* count) {
+    *count = 0;
+    char* save = NULL;
+    char* token = strtok_r(text, ";| ", &save);
+
+    while (token != NULL) {
+        char* end;
+        long choice = strtol(token, &end, 10);
+        if (end == token || *end != '\0' || choice < 1 || choice > programCount)
+            return "preference is not a program in the catalog";
+        if (*count >= MAX_PREFERENCES)
+            return "too many preferences";
+
+        ids[(*count)++] = (uint16_t)(choice - 1);
+        token = strtok_r(NULL, ";| ", &save);
+    }
+
+    if (*count == 0)
+        return "no preferences given";
+    return NULL;
+}
+
+// Validates one record with the same rules as interactive registration;
+// checks holds the block results for its reg number, DOB and Aadhar.
+// Returns NULL on success or a short reason for rejecting the line.
+static const char* parseStudentLine(Queue* q, char** fields, int count, const uint8_t* checks,
+                                    StudentId student, uint16_t* prefScratch) {
+    if (count != BATCH_FIELD_COUNT && count != BATCH_FIELD_COUNT + 1)
+        return "expected 6 or 7 fields";
+    if (checks[0] != FIELD_OK)
+        return "invalid registration number";
+    if (fields[1][0] == '\0' || strlen(fields[1]) >= MAX_NAME_LENGTH)
+        return "invalid name";
+
+    int rank;
+    if (!parseRank(fields[2], &rank))
+        return "invalid rank";
+    if (checks[1] != FIELD_OK)
+        return "invalid date of birth";
+    if (checks[2] != FIELD_OK)
+        return "invalid Aadhar number";
+    if (findVerificationByReg(fields[0]) != NULL || findStudentByReg(fields[0]) != NO_STUDENT)
+        return "duplicate registration number";
+    if (findVerificationByAadhar(fields[4]) != NULL)
+        return "duplicate Aadhar number";
+
+    uint8_t categories = POOL_GENERAL;
+    if (count > BATCH_FIELD_COUNT && !parsePoolList(fields[BATCH_FIELD_COUNT], &categories))
+        return "unknown seat pool";
+
+    int prefCount;
+    const char* prefError = parsePreferences(fields[5], prefScratch, &prefCount);
+    if (prefError != NULL)
+        return prefError;
+    setStudentPreferences(q, student, prefScratch, prefCount);
+
+    StudentStore* store = &q->students;
+    strcpy(store->reg_number[student], fields[0]);
+    setStudentName(q, student, fields[1]);
+    store->rank[student] = rank;
+    store->flags[student] = STUDENT_VERIFIED;
+    store->categories[student] = categories;
+    store->allocated_program[student] = PROGRAM_NOT_ALLOCATED;
+    store->next[student] = NO_STUDENT;
+    return NULL;
+}
+
+// Records held back until their fields are validated together. The
+// reader reuses its buffer, so lines are copied into text, and fields
+// are kept as offsets since text may move as it grows.
+typedef struct {
+    long line_no;
+    int count;                             // As returned by splitFields
+    size_t field[BATCH_FIELD_COUNT + 1];
+} BlockRecord;
+
+typedef struct {
+    char* text;
+    size_t used;
+    size_t capacity;
+    int count;
+    BlockRecord records[BATCH_VALIDATE_BLOCK];
+    char regs[BATCH_VALIDATE_BLOCK * VALID_FIELD_WIDTH];
+    char dobs[BATCH_VALIDATE_BLOCK * VALID_FIELD_WIDTH];
+    char aadhars[BATCH_VALIDATE_BLOCK * VALID_FIELD_WIDTH];
+    uint8_t checks[3][BATCH_VALIDATE_BLOCK];  // Reg number, DOB, Aadhar
+} RecordBlock;
+
+typedef struct {
+    Queue* q;
+    CalendarDate today;  // Reference date for every DOB in the file
+    StudentId spare;
+    uint16_t* prefScratch;
+    // Valid records are collected and handed to the bulk loader at the end
+    StudentId* pending;
+    int pendingCount;
+    int pendingCapacity;
+    long rejected;
+} Ingest;
+
+// Records the field offsets of a line already copied into the block
+// and packs the fields the block validates together
+static void holdRecord(RecordBlock* block, char** fields, int count, long lineNo) {
+    BlockRecord* r = &block->records[block->count];
+    r->line_no = lineNo;
+    r->count = count;
+    int stored = (count <= BATCH_FIELD_COUNT + 1) ? count : BATCH_FIELD_COUNT + 1;
+    for (int f = 0; f < stored; f++)
+        r->field[f] = (size_t)(fields[f] - block->text);
+
+    size_t slot = (size_t)block->count * VALID_FIELD_WIDTH;
+    packField(block->regs + slot, fields[0]);
+    packField(block->dobs + slot, count > 3 ? fields[3] : "");
+    packField(block->aadhars + slot, count > 4 ? fields[4] : "");
+    block->count++;
+}
+
+static void ingestBlock(Ingest* ingest, RecordBlock* block) {
+    validateRegNumbers(block->regs, block->count, block->checks[0]);
+    validateDates(block->dobs, block->count, &ingest->today, block->checks[1]);
+    validateAadhars(block->aadhars, block->count, block->checks[2]);
+
+    Queue* q = ingest->q;
+    for (int i = 0; i < block->count; i++) {
+        const BlockRecord* r = &block->records[i];
+        char* fields[BATCH_FIELD_COUNT + 1];
+        int stored = (r->count <= BATCH_FIELD_COUNT + 1) ? r->count : BATCH_FIELD_COUNT + 1;
+        for (int f = 0; f < stored; f++)
+            fields[f] = block->text + r->field[f];
+        uint8_t checks[3] = { block->checks[0][i], block->checks[1][i], block->checks[2][i] };
+
+        if (ingest->spare == NO_STUDENT) ingest->spare = allocStudent(q);
+        const char* error = parseStudentLine(q, fields, r->count, checks, ingest->spare, ingest->prefScratch);
+        if (error != NULL) {
+            if (ingest->rejected < BATCH_MAX_REPORTED)
+                fprintf(stderr, "%sLine %ld rejected: %s%s\n",
+                        COLOR_RED, r->line_no, error, COLOR_RESET);
+            ingest->rejected++;
+            continue;
+        }
+
+        // Registered like an interactive student; rolled back below if
+        // the bulk loader rejects the rank
+        addToVerificationData(fields[0], fields[1], fields[3], fields[4]);
+
+        if (ingest->pendingCount == ingest->pendingCapacity) {
+            ingest->pendingCapacity *= 2;
+            ingest->pending = (StudentId*)realloc(ingest->pending,
+                                                  ingest->pendingCapacity * sizeof(StudentId));
+        }
+        ingest->pending[ingest->pendingCount++] = ingest->spare;
+        ingest->spare = NO_STUDENT;
+    }
+    block->count = 0;
+    block->used = 0;
+}
+
+static long ingestStudents(FILE* in, Queue* q, long* rejected) {
+    LineReader reader = { in, malloc(BATCH_READ_BUFFER + 1), 0, 0, false };
+    RecordBlock* block = (RecordBlock*)calloc(1, sizeof(RecordBlock));
+    char* fields[BATCH_FIELD_COUNT + 2];
+    char delim = 0;
+    long lineNo = 0;
+    bool firstRecord = true;
+
+    Ingest ingest = { q, { 0, 0, 0 }, NO_STUDENT, NULL, NULL, 0, 1024, 0 };
+    calendarToday(&ingest.today);
+    ingest.prefScratch = (uint16_t*)malloc(MAX_PREFERENCES * sizeof(uint16_t));
+    ingest.pending = (StudentId*)malloc(ingest.pendingCapacity * sizeof(StudentId));
+
+    char* line;
+    while ((line = readLine(&reader)) != NULL) {
+        lineNo++;
+        char* p = line;
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p == '\0' || *p == '\r' || *p == '#') continue;
+
+        // The first record decides between CSV and TSV
+        if (delim == 0) delim = (strchr(line, '\t') != NULL) ? '\t' : ',';
+
+        size_t length = strlen(line) + 1;
+        if (block->used + length > block->capacity) {
+            block->capacity = block->capacity ? block->capacity * 2 : BATCH_READ_BUFFER;
+            while (block->capacity < block->used + length) block->capacity *= 2;
+            block->text = (char*)realloc(block->text, block->capacity);
+        }
+        char* copy = block->text + block->used;
+        memcpy(copy, line, length);
+
+        int count = splitFields(copy, delim, fields, BATCH_FIELD_COUNT + 1);
+        // Only a first line with neither a registration number nor a rank
+        // is a header; anything else is validated and counted
+        if (firstRecord) {
+            firstRecord = false;
+            int rank;
+            if (!isValidRegNumber(fields[0]) && (count < 3 || !parseRank(fields[2], &rank)))
+                continue;  // Header line
+        }
+        block->used += length;
+        holdRecord(block, fields, count, lineNo);
+        if (block->count == BATCH_VALIDATE_BLOCK)
+            ingestBlock(&ingest, block);
+    }
+    ingestBlock(&ingest, block);
+    if (ingest.spare != NO_STUDENT) releaseStudent(q, ingest.spare);
+    free(ingest.prefScratch);
+    free(block->text);
+    free(block);
+    free(reader.buf);
+
+    // Sort once and link everything into the queue
+    StudentId* pending = ingest.pending;
+    int pendingCount = ingest.pendingCount;
+    *rejected = ingest.rejected;
+    int accepted = enqueueBulk(q, pending, pendingCount);
+    StudentStore* store = &q->students;
+    for (int i = accepted; i < pendingCount; i++) {
+        if (*rejected < BATCH_MAX_REPORTED)
+            fprintf(stderr, "%sRecord %s rejected: duplicate rank %d%s\n",
+                    COLOR_RED, store->reg_number[pending[i]], store->rank[pending[i]], COLOR_RESET);
+        (*rejected)++;
+        removeFromVerificationData(store->reg_number[pending[i]]);
+        releaseStudent(q, pending[i]);
+    }
+    free(pending);
+
+    if (*rejected > BATCH_MAX_REPORTED)
+        fprintf(stderr, "%s... %ld more records rejected%s\n",
+                COLOR_RED, *rejected - BATCH_MAX_REPORTED, COLOR_RESET);
+    return accepted;
+}
+
+typedef struct {
+    int round;
+    StudentId student;
+    RoundResponse response;
+} BatchResponse;
+
+static bool parseResponse(const char* text, RoundResponse* response) {
+    if (strcasecmp(text, "accept") == 0 || strcasecmp(text, "a") == 0) {
+        *response = ROUND_ACCEPT;
+    } else if (strcasecmp(text, "float") == 0 || strcasecmp(text, "f") == 0) {
+        *response = ROUND_FLOAT;
+    } else if (strcasecmp(text, "exit") == 0 || strcasecmp(text, "e") == 0) {
+        *response = ROUND_EXIT;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Reads the responses file against the queued students. Returns NULL if the
+// file cannot be opened.
+static BatchResponse* loadResponses(const char* path, int rounds, long* count, long* rejected) {
+    FILE* in = fopen(path, "r");
+    if (in == NULL) return NULL;
+
+    LineReader reader = { in, malloc(BATCH_READ_BUFFER + 1), 0, 0, false };
+    char* fields[4];
+    long capacity = 1024;
+    BatchResponse* responses = (BatchResponse*)malloc(capacity * sizeof(BatchResponse));
+    long lineNo = 0;
+    bool firstRecord = true;
+
+    *count = 0;
+    *rejected = 0;
+    char* line;
+    while ((line = readLine(&reader)) != NULL) {
+        lineNo++;
+        char* p = line;
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p == '\0' || *p == '\r' || *p == '#') continue;
+
+        char delim = (strchr(line, '\t') != NULL) ? '\t' : ',';
+        int fieldCount = splitFields(line, delim, fields, 3);
+        int round;
+        if (firstRecord) {
+            firstRecord = false;
+            if (!parseRank(fields[0], &round)) continue;  // Header line
+        }
+
+        const char* error = NULL;
+        BatchResponse r;
+        if (fieldCount != 3 || !parseRank(fields[0], &round) || round >= rounds) {
+            error = "expected round (below the round count), reg_number, response";
+        } else if ((r.student = findStudentByReg(fields[1])) == NO_STUDENT) {
+            error = "unknown registration number";
+        } else if (!parseResponse(fields[2], &r.response)) {
+            error = "response must be accept, float or exit";
+        }
+        if (error != NULL) {
+            if (*rejected < BATCH_MAX_REPORTED)
+                fprintf(stderr, "%sResponse line %ld rejected: %s%s\n",
+                        COLOR_RED, lineNo, error, COLOR_RESET);
+            (*rejected)++;
+            continue;
+        }
+
+        r.round = round;
+        if (*count == capacity) {
+            capacity *= 2;
+            responses = (BatchResponse*)realloc(responses, capacity * sizeof(BatchResponse));
+        }
+        responses[(*count)++] = r;
+    }
+    free(reader.buf);
+    fclose(in);
+    return responses;
+}
+
+// Runs rounds 2..options->rounds, applying each round's responses first
+static bool runRounds(Queue* q, const BatchOptions* options) {
+    BatchResponse* responses = NULL;
+    long responseCount = 0, rejected = 0;
+    if (options->responsesPath != NULL) {
+        responses = loadResponses(options->responsesPath, options->rounds, &responseCount, &rejected);
+        if (responses == NULL) {
+            printf("%sError: Cannot open responses file %s%s\n",
+                   COLOR_RED, options->responsesPath, COLOR_RESET);
+            return false;
+        }
+    }
+
+    for (int round = 1; round < options->rounds; round++) {
+        for (long i = 0; i < responseCount; i++) {
+            if (responses[i].round != round) continue;
+            if (!recordRoundResponse(q, responses[i].student, responses[i].response)) {
+                if (rejected < BATCH_MAX_REPORTED)
+                    fprintf(stderr, "%sResponse of %s in round %d rejected%s\n",
+                            COLOR_RED, q->students.reg_number[responses[i].student], round, COLOR_RESET);
+                rejected++;
+            }
+        }
+        if (runNextRound(q) == NULL) {
+            free(responses);
+            return false;
+        }
+    }
+
+    if (rejected > BATCH_MAX_REPORTED)
+        fprintf(stderr, "%s... %ld more responses rejected%s\n",
+                COLOR_RED, rejected - BATCH_MAX_REPORTED, COLOR_RESET);
+    free(responses);
+    displayRoundSummary(q);
+    return true;
+}
+
+// Answers each rank query from the cutoff index. Returns the number of
+// queries answered, or -1 if a file cannot be opened.
+static long answerRankQueries(Queue* q, const BatchOptions* options, long* rejected, double* seconds) {
+    FILE* in = fopen(options->rankQueriesPath, "r");
+    if (in == NULL) return -1;
+    FILE* out = fopen(options->rankAnswersPath, "w");
+    if (out == NULL) {
+        fclose(in);
+        return -1;
+    }
+    setvbuf(out, NULL, _IOFBF, BATCH_READ_BUFFER);
+    fprintf(out, "rank,pools,open_programs,choices\n");
+
+    const CutoffTable* table = q->allocation->cutoffs;
+    LineReader reader = { in, malloc(BATCH_READ_BUFFER + 1), 0, 0, false };
+    uint16_t* reachable = (uint16_t*)malloc(programCount * sizeof(uint16_t));
+    char* fields[3];
+    long answered = 0, lineNo = 0;
+    bool firstRecord = true;
+    double elapsed = 0;
+
+    *rejected = 0;
+    char* line;
+    while ((line = readLine(&reader)) != NULL) {
+        lineNo++;
+        char* p = line;
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p == '\0' || *p == '\r' || *p == '#') continue;
+
+        char delim = (strchr(line, '\t') != NULL) ? '\t' : ',';
+        int fieldCount = splitFields(line, delim, fields, 2);
+        int rank;
+        if (firstRecord) {
+            firstRecord = false;
+            if (!parseRank(fields[0], &rank)) continue;  // Header line
+        }
+
+        uint8_t categories = POOL_GENERAL;
+        const char* error = NULL;
+        if (fieldCount > 2 || !parseRank(fields[0], &rank)) {
+            error = "expected rank and optional seat pools";
+        } else if (fieldCount == 2 && !parsePoolList(fields[1], &categories)) {
+            error = "unknown seat pool";
+        }
+        if (error != NULL) {
+            if (*rejected < BATCH_MAX_REPORTED)
+                fprintf(stderr, "%sRank query line %ld rejected: %s%s\n",
+                        COLOR_RED, lineNo, error, COLOR_RESET);
+            (*rejected)++;
+            continue;
+        }
+
+        double t0 = monotonicSeconds();
+        int count = reachablePrograms(table, rank, categories, reachable);
+        elapsed += monotonicSeconds() - t0;
+
+        fprintf(out, "%d,", rank);
+        for (int k = 0, first = 1; k < seatPoolCount; k++) {
+            if (!(categories & (1u << k))) continue;
+            fprintf(out, "%s%s", first ? "" : ";", seatPoolName(k));
+            first = 0;
+        }
+        fprintf(out, ",%d,", count);
+        for (int i = 0; i < count; i++)
+            fprintf(out, "%s%d", i > 0 ? ";" : "", reachable[i] + 1);
+        fputc('\n', out);
+        answered++;
+    }
+
+    if (*rejected > BATCH_MAX_REPORTED)
+        fprintf(stderr, "%s... %ld more rank queries rejected%s\n",
+                COLOR_RED, *rejected - BATCH_MAX_REPORTED, COLOR_RESET);
+    free(reachable);
+    free(reader.buf);
+    fclose(in);
+    *seconds = elapsed;
+    return fclose(out) == 0 ? answered : -1;
+}
+
+// Simulates every hypothetical list in the what-if file. Returns false if
+// a file cannot be opened; the counts and timing are reported by the caller.
+static bool runWhatIf(Queue* q, const BatchOptions* options, long* simulated, long* rejected,
+                      long* evaluated, double* seconds) {
+    FILE* in = fopen(options->whatIfPath, "r");
+    if (in == NULL) return false;
+
+    LineReader reader = { in, malloc(BATCH_READ_BUFFER + 1), 0, 0, false };
+    long capacity = 1024;
+    WhatIfEdit* edits = (WhatIfEdit*)malloc(capacity * sizeof(WhatIfEdit));
+    size_t* starts = (size_t*)malloc(capacity * sizeof(size_t));  // Lists move as ids grows
+    size_t idsUsed = 0, idsCapacity = 16384;
+    uint16_t* ids = (uint16_t*)malloc(idsCapacity * sizeof(uint16_t));
+    uint16_t* prefScratch = (uint16_t*)malloc(MAX_PREFERENCES * sizeof(uint16_t));
+    char* fields[3];
+    long count = 0, lineNo = 0;
+    bool firstRecord = true;
+
+    *rejected = 0;
+    char* line;
+    while ((line = readLine(&reader)) != NULL) {
+        lineNo++;
+        char* p = line;
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p == '\0' || *p == '\r' || *p == '#') continue;
+
+        char delim = (strchr(line, '\t') != NULL) ? '\t' : ',';
+        int fieldCount = splitFields(line, delim, fields, 2);
+        StudentId student = NO_STUDENT;
+        int prefCount = 0;
+        // Only a first line with neither a registration number nor a
+        // preference list is a header
+        if (firstRecord) {
+            firstRecord = false;
+            if (!isValidRegNumber(fields[0]) &&
+                (fieldCount != 2 || parsePreferences(fields[1], prefScratch, &prefCount) != NULL))
+                continue;  // Header line
+        }
+
+        const char* error = NULL;
+        if (fieldCount != 2) {
+            error = "expected reg_number, preferences";
+        } else if ((student = findStudentByReg(fields[0])) == NO_STUDENT) {
+            error = "unknown registration number";
+        } else {
+            error = parsePreferences(fields[1], prefScratch, &prefCount);
+        }
+        if (error != NULL) {
+            if (*rejected < BATCH_MAX_REPORTED)
+                fprintf(stderr, "%sWhat-if line %ld rejected: %s%s\n",
+                        COLOR_RED, lineNo, error, COLOR_RESET);
+            (*rejected)++;
+            continue;
+        }
+
+        if (count == capacity) {
+            capacity *= 2;
+            edits = (WhatIfEdit*)realloc(edits, capacity * sizeof(WhatIfEdit));
+            starts = (size_t*)realloc(starts, capacity * sizeof(size_t));
+        }
+        while (idsUsed + prefCount > idsCapacity) idsCapacity *= 2;
+        ids = (uint16_t*)realloc(ids, idsCapacity * sizeof(uint16_t));
+        memcpy(ids + idsUsed, prefScratch, prefCount * sizeof(uint16_t));
+        edits[count].student = student;
+        starts[count] = idsUsed;
+        edits[count].count = prefCount;
+        idsUsed += prefCount;
+        count++;
+    }
+    free(prefScratch);
+    free(reader.buf);
+    fclose(in);
+    if (*rejected > BATCH_MAX_REPORTED)
+        fprintf(stderr, "%s... %ld more what-if lines rejected%s\n",
+                COLOR_RED, *rejected - BATCH_MAX_REPORTED, COLOR_RESET);
+    for (long i = 0; i < count; i++)
+        edits[i].preferences = ids + starts[i];
+    free(starts);
+
+    AllocationSnapshot* snap = takeAllocationSnapshot(q);
+    WhatIfOutcome* outcomes = (WhatIfOutcome*)malloc((count ? count : 1) * sizeof(WhatIfOutcome));
+    *seconds = simulateWhatIf(snap, edits, outcomes, (int)count);
+    releaseAllocationSnapshot(snap);
+
+    FILE* out = fopen(options->whatIfOutPath, "w");
+    bool written = (out != NULL);
+    *simulated = count;
+    *evaluated = 0;
+    if (written) {
+        setvbuf(out, NULL, _IOFBF, BATCH_READ_BUFFER);
+        bool pooled = (seatPoolCount > 1);
+        fprintf(out, "reg_number,rank,current_college,current_branch,college,branch%s,displaced,evaluated\n",
+                pooled ? ",pool" : "");
+        for (long i = 0; i < count; i++) {
+            const WhatIfOutcome* o = &outcomes[i];
+            const char* current = programCollegeName(o->previous_program);
+            const char* college = programCollegeName(o->program_id);
+            const char* cq = (strchr(current, ',') != NULL) ? "\"" : "";
+            const char* nq = (strchr(college, ',') != NULL) ? "\"" : "";
+            fprintf(out, "%s,%d,%s%s%s,%s,%s%s%s,%s", q->students.reg_number[edits[i].student],
+                    q->students.rank[edits[i].student], cq, current, cq, programBranchName(o->previous_program),
+                    nq, college, nq, programBranchName(o->program_id));
+            if (pooled)
+                fprintf(out, ",%s", o->program_id >= 0 ? seatPoolName(o->pool) : "");
+            fprintf(out, ",%d,%d\n", o->displaced, o->evaluated);
+            *evaluated += o->evaluated;
+        }
+        written = (fclose(out) == 0);
+    }
+
+    free(outcomes);
+    free(ids);
+    free(edits);
+    return written;
+}
+
+int runBatchMode(const BatchOptions* options) {
+    const char* inputPath = options->inputPath;
+    const char* outputPath = options->outputPath;
+    int totalSeats = options->totalSeats;
+
+    // Rounds and what-if edits build on the serial allotment
+    if (options->engine == ALLOCATION_DEFERRED && (options->rounds > 1 || options->whatIfPath != NULL)) {
+        printf("%sError: --rounds and --what-if need the serial engine%s\n", COLOR_RED, COLOR_RESET);
+        return 1;
+    }
+
+    FILE* in = fopen(inputPath, "r");
+    if (in == NULL) {
+        printf("%sError: Cannot open input file %s%s\n", COLOR_RED, inputPath, COLOR_RESET);
+        return 1;
+    }
+
+    if (options->catalogPath != NULL && !loadCatalog(options->catalogPath)) {
+        fclose(in);
+        return 1;
+    }
+    initializeColleges(totalSeats);
+    setWorkerThreads(options->threads);
+    setAllocationEngine(options->engine);
+
+    // A preference list in the file may name every program
+    MAX_PREFERENCES = programCount;
+    Queue* q = createQueue();
+    if (options->oplogPath != NULL && !opLogOpenFile(q->operation_log, options->oplogPath)) {
+        printf("%sWarning: Cannot open operation log %s%s\n",
+               COLOR_YELLOW, options->oplogPath, COLOR_RESET);
+    }
+
+    long rejected;
+    double t0 = monotonicSeconds();
+    long accepted = ingestStudents(in, q, &rejected);
+    double t1 = monotonicSeconds();
+    fclose(in);
+
+    // With a claim file, only students with a matching claim are verified
+    ClaimSummary claims;
+    if (options->claimsPath != NULL) {
+        StudentStore* store = &q->students;
+        for (StudentId s = 0; s < store->count; s++)
+            store->flags[s] &= (uint8_t)~STUDENT_VERIFIED;
+        if (!verifyClaimFile(q, options->claimsPath, options->claimsReportPath, &claims)) {
+            printf("%sError: Cannot read %s or write %s%s\n", COLOR_RED, options->claimsPath,
+                   options->claimsReportPath != NULL ? options->claimsReportPath : "the claim report",
+                   COLOR_RESET);
+            cleanupQueue(q);
+            return 1;
+        }
+    }
+
+    long prioritiesLoaded = 0, prioritiesRejected = 0;
+    if (options->prioritiesPath != NULL &&
+        !loadCollegePriorities(q, options->prioritiesPath, &prioritiesLoaded, &prioritiesRejected)) {
+        printf("%sError: Cannot open priorities file %s%s\n", COLOR_RED, options->prioritiesPath, COLOR_RESET);
+        cleanupQueue(q);
+        return 1;
+    }
+
+    // Without --seats the catalog's seat counts apply, or one seat per
+    // accepted student over the built-in catalog
+    if (totalSeats == 0 && options->catalogPath == NULL)
+        distributeSeats((int)accepted);
+
+    // Demand is taken from the lists as registered, before any allotment
+    long demandListed = 0;
+    int demandThreads = 0, oversubscribed = 0;
+    double demandTime = 0;
+    if (options->demandPath != NULL) {
+        DemandReport* demand = analyzeDemand(q);
+        bool written = writeDemandJson(demand, options->demandPath);
+        for (int p = 0; p < demand->programs; p++)
+            oversubscribed += oversubscription(demand, p) > 1.0;
+        demandListed = demand->listed;
+        demandThreads = demand->threads;
+        demandTime = demand->seconds;
+        releaseDemandReport(demand);
+        if (!written) {
+            printf("%sError: Cannot write demand file %s%s\n", COLOR_RED, options->demandPath, COLOR_RESET);
+            cleanupQueue(q);
+            return 1;
+        }
+    }
+
+    double t2 = monotonicSeconds();
+    processAllocation(q);
+    double t3 = monotonicSeconds();
+
+    // What-if lists are simulated against the round 1 allotment
+    long simulated = 0, whatIfRejected = 0, replayed = 0;
+    double whatIfTime = 0;
+    if (options->whatIfPath != NULL &&
+        !runWhatIf(q, options, &simulated, &whatIfRejected, &replayed, &whatIfTime)) {
+        printf("%sError: Cannot read %s or write %s%s\n", COLOR_RED,
+               options->whatIfPath, options->whatIfOutPath, COLOR_RESET);
+        cleanupQueue(q);
+        return 1;
+    }
+
+    if (options->rounds > 1 && !runRounds(q, options)) {
+        cleanupQueue(q);
+        return 1;
+    }
+
+    // Result files go through the exporter, all in the same format
+    const struct { ExportTable table; const char* path; const char* what; } exports[] = {
+        { EXPORT_ALLOTMENT, outputPath, "output" },
+        { EXPORT_CUTOFFS, options->cutoffsPath, "cutoff" },
+        { EXPORT_SEATS, options->seatMatrixPath, "seat matrix" }
+    };
+    ExportStats exported = { 0, 0, 0 };
+    int exportedFiles = 0;
+    for (int i = 0; i < 3; i++) {
+        if (exports[i].path == NULL) continue;
+        ExportStats stats;
+        if (!exportResults(q, exports[i].table, options->format, &options->filter, exports[i].path, &stats)) {
+            printf("%sError: Cannot write %s file %s%s\n", COLOR_RED, exports[i].what, exports[i].path, COLOR_RESET);
+            cleanupQueue(q);
+            return 1;
+        }
+        exported.rows += stats.rows;
+        exported.bytes += stats.bytes;
+        exported.seconds += stats.seconds;
+        exportedFiles++;
+    }
+
+    long queries = 0, queriesRejected = 0;
+    double queryTime = 0;
+    if (options->rankQueriesPath != NULL) {
+        queries = answerRankQueries(q, options, &queriesRejected, &queryTime);
+        if (queries < 0) {
+            printf("%sError: Cannot read %s or write %s%s\n", COLOR_RED,
+                   options->rankQueriesPath, options->rankAnswersPath, COLOR_RESET);
+            cleanupQueue(q);
+            return 1;
+        }
+    }
+
+    double snapshotTime = 0;
+    if (options->snapshotPath != NULL) {
+        double s0 = monotonicSeconds();
+        if (!saveSnapshot(q, options->snapshotPath)) {
+            cleanupQueue(q);
+            return 1;
+        }
+        snapshotTime = monotonicSeconds() - s0;
+    }
+
+    double ingestTime = t1 - t0;
+    double allocTime = t3 - t2;
+    printf("\n%sBatch Summary%s\n", COLOR_BLUE, COLOR_RESET);
+    printf("=============\n");
+    printf("Records accepted : %ld\n", accepted);
+    printf("Records rejected : %ld\n", rejected);
+    printf("Ingest           : %.3f s (%.0f records/sec)\n",
+           ingestTime, ingestTime > 0 ? (accepted + rejected) / ingestTime : 0.0);
+    printf("Allocation       : %.3f s (%.0f records/sec)\n",
+           allocTime, allocTime > 0 ? accepted / allocTime : 0.0);
+    if (options->engine == ALLOCATION_DEFERRED) {
+        const DeferredStats* da = &q->allocation->deferred;
+        printf("Deferred         : %ld proposal(s) by %ld student(s), %ld rejected, %ld displaced\n",
+               da->proposals, da->proposers, da->rejections, da->displaced);
+        if (options->prioritiesPath != NULL)
+            printf("Priorities       : %ld line(s) loaded, %ld rejected\n", prioritiesLoaded, prioritiesRejected);
+    }
+    if (options->claimsPath != NULL) {
+        printf("Claims           : %ld checked, %ld verified in %.3f s (%.0f claims/sec) on %d thread(s)\n",
+               claims.claims, claims.counts[CLAIM_VERIFIED], claims.seconds,
+               claims.seconds > 0 ? claims.claims / claims.seconds : 0.0, workerThreadCount());
+        for (int r = CLAIM_VERIFIED + 1; r < CLAIM_RESULT_COUNT; r++)
+            if (claims.counts[r] > 0)
+                printf("  %-15s: %ld\n", claimResultName((ClaimResult)r), claims.counts[r]);
+    }
+    if (options->demandPath != NULL)
+        printf("Demand           : %ld choice(s), %d of %d program(s) oversubscribed, in %.3f s "
+               "on %d thread(s)\n", demandListed, oversubscribed, programCount, demandTime, demandThreads);
+    double exportedMb = exported.bytes / (1024.0 * 1024.0);
+    printf("Export           : %d file(s), %ld rows, %.2f MB in %.3f s (%.1f MB/s)\n",
+           exportedFiles, exported.rows, exportedMb, exported.seconds,
+           exported.seconds > 0 ? exportedMb / exported.seconds : 0.0);
+    if (options->whatIfPath != NULL)
+        printf("What-if          : %ld simulated, %ld rejected in %.3f s (%.0f edits/sec, "
+               "%.1f students replayed each) on %d thread(s)\n",
+               simulated, whatIfRejected, whatIfTime, whatIfTime > 0 ? simulated / whatIfTime : 0.0,
+               simulated > 0 ? (double)replayed / simulated : 0.0, workerThreadCount());
+    if (options->rankQueriesPath != NULL)
+        printf("Rank queries     : %ld answered, %ld rejected (%.2f us/query)\n",
+               queries, queriesRejected, queries > 0 ? queryTime * 1e6 / queries : 0.0);
+    if (options->snapshotPath != NULL)
+        printf("Snapshot         : %s saved in %.3f s\n", options->snapshotPath, snapshotTime);
+    printf("%sResults written to %s%s\n", COLOR_GREEN, outputPath, COLOR_RESET);
+
+    // Written last so the cleanup span is in it
+    cleanupQueue(q);
+    if (options->metricsPath != NULL && !writeMetricsJson(options->metricsPath)) {
+        printf("%sError: Cannot write metrics file %s%s\n", COLOR_RED, options->metricsPath, COLOR_RESET);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,1069 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "enhanced_ds.h"
+
+// ==========================================================
+//   BENCHMARK SUITE
+//
+//   Usage: bench [--sizes 1000,10000,...] [--lookups M]
+//                [--updates K] [--seat-ratio R] [--seed S]
+//                [--catalog file] [--max-prefs P]
+//                [--threads T] [--json results.jsonl]
+//                [--snapshot file] [--journal file]
+//                [--socket path]
+//
+//   Generates N candidates with unique ranks, valid DOB and
+//   Aadhar numbers and Zipf-skewed preferences, then times each
+//   phase of a counselling run, plus cutoff queries and what-if
+//   edits against the resulting allotment. A claim file for the
+//   cohort is verified at 1, 2, 4, ... worker threads up to the
+//   configured count, to show scaling. With --snapshot the
+//   session is also saved to that file and mapped back. With
+//   --journal the registrations are also written to a journal by
+//   BENCH_JOURNAL_CLIENTS concurrent clients, each waiting until
+//   its record is durable, and the journal is finally replayed
+//   into an empty session. With --socket the session is served
+//   on that Unix socket to BENCH_SERVE_CLIENTS concurrent clients
+//   sending a mix of VERIFY, QUERY, REGISTER and UPDATE requests;
+//   every new registration is sent by two clients at once and
+//   exactly one of them must be accepted. The allotment is
+//   also made by deferred acceptance on the same input, once
+//   without priorities (it must agree with the serial one) and
+//   once with one candidate in BENCH_PRIORITY_ODDS given a
+//   priority at their first choice. With a
+//   seat-pool catalog each candidate qualifies for every
+//   reserved pool with probability 1/BENCH_POOL_ODDS. Every
+//   size runs in its own child process so peak RSS is reported
+//   per size. With --json, one JSON object per phase is
+//   appended per line.
+// ==========================================================
+
+#define BENCH_MAX_SIZES   16
+#define BENCH_MAX_SAMPLES 100000
+#define BENCH_ZIPF_S      1.1
+#define BENCH_MAX_PREFS   256
+#define BENCH_POOL_ODDS   4
+#define BENCH_JOURNAL_CLIENTS 32
+#define BENCH_SERVE_CLIENTS   16    // Even: clients pair up on registrations
+#define BENCH_SERVE_MAX       1000000
+#define BENCH_VALIDATE_BLOCK  4096  // Same block size as batch ingest
+#define BENCH_CLAIM_STEPS     8     // Thread counts 1, 2, 4, ... up to MAX_WORKER_THREADS
+#define BENCH_PRIORITY_ODDS   4     // One candidate in 4 has a college-side priority
+#define BENCH_PRIORITY_LEVELS 100
+
+typedef struct {
+    long sizes[BENCH_MAX_SIZES];
+    int sizeCount;
+    long lookups;
+    long updates;
+    double seatRatio;
+    uint64_t seed;
+    int maxPrefs;
+    int threads;
+    const char* catalogPath;
+    const char* jsonPath;
+    const char* snapshotPath;  // NULL = no save/load phases
+    const char* journalPath;   // NULL = no journal/recover phases
+    const char* socketPath;    // NULL = no serve phase
+} BenchConfig;
+
+typedef struct {
+    uint64_t state;
+} Rng;
+
+// Latencies of every stride-th operation of a phase
+typedef struct {
+    double* samples;
+    int count;
+    long stride;
+} Sampler;
+
+typedef struct {
+    const char* name;
+    long ops;
+    double seconds;
+    double p50_us;
+    double p99_us;
+    double max_us;
+    bool sampled;
+} PhaseResult;
+
+// Generated candidates, kept apart from the queue so that the
+// registration and enqueue phases can be timed separately
+typedef struct {
+    long count;
+    StudentId* students;
+    char (*dob)[11];
+    char (*aadhar)[15];
+} Cohort;
+
+static uint64_t rngNext(Rng* rng) {
+    // xorshift64*
+    rng->state ^= rng->state >> 12;
+    rng->state ^= rng->state << 25;
+    rng->state ^= rng->state >> 27;
+    return rng->state * 0x2545F4914F6CDD1DULL;
+}
+
+static double rngUniform(Rng* rng) {
+    return (rngNext(rng) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// ==========================================================
+//                 SYNTHETIC CANDIDATE GENERATOR
+// ==========================================================
+
+// Zipf weights over programs, in a seed-dependent popularity order
+static double* buildZipfCdf(Rng* rng, int* order, int programs) {
+    double* cdf = (double*)malloc(programs * sizeof(double));
+    for (int i = 0; i < programs; i++) order[i] = i;
+    for (int i = programs - 1; i > 0; i--) {
+        int j = (int)(rngNext(rng) % (uint64_t)(i + 1));
+        int t = order[i]; order[i] = order[j]; order[j] = t;
+    }
+
+    double total = 0;
+    for (int k = 0; k < programs; k++) {
+        total += 1.0 / pow(k + 1, BENCH_ZIPF_S);
+        cdf[k] = total;
+    }
+    for (int k = 0; k < programs; k++) cdf[k] /= total;
+    return cdf;
+}
+
+static int sampleZipf(Rng* rng, const double* cdf, const int* order, int programs) {
+    double u = rngUniform(rng);
+    int lo = 0, hi = programs - 1;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (cdf[mid] < u) lo = mid + 1;
+        else hi = mid;
+    }
+    return order[lo];
+}
+
+// Between 3 and MAX_PREFERENCES distinct programs, popular ones first
+static int drawPreferences(Rng* rng, const double* cdf, const int* order, uint16_t* ids) {
+    int low = MAX_PREFERENCES < 3 ? MAX_PREFERENCES : 3;
+    int wanted = low + (int)(rngNext(rng) % (uint64_t)(MAX_PREFERENCES - low + 1));
+
+    int count = 0;
+    for (int attempts = 0; count < wanted && attempts < wanted * 8; attempts++) {
+        int p = sampleZipf(rng, cdf, order, programCount);
+        bool seen = false;
+        for (int i = 0; i < count && !seen; i++)
+            seen = (ids[i] == p);
+        if (!seen) ids[count++] = (uint16_t)p;
+    }
+    return count;
+}
+
+static void generatePreferences(Queue* q, Rng* rng, StudentId s, const double* cdf, const int* order) {
+    uint16_t ids[BENCH_MAX_PREFS];
+    int count = drawPreferences(rng, cdf, order, ids);
+    setStudentPreferences(q, s, ids, count);
+}
+
+static void generateCohort(Queue* q, Cohort* cohort, long n, Rng* rng, const double* cdf, const int* order) {
+    cohort->count = n;
+    cohort->students = (StudentId*)malloc(n * sizeof(StudentId));
+    cohort->dob = malloc(n * sizeof(*cohort->dob));
+    cohort->aadhar = malloc(n * sizeof(*cohort->aadhar));
+
+    for (long i = 0; i < n; i++) {
+        StudentId s = allocStudent(q);
+        char name[MAX_NAME_LENGTH];
+        snprintf(q->students.reg_number[s], MAX_REG_LENGTH, "DC%07d", (int)(i % 10000000L));
+        snprintf(name, MAX_NAME_LENGTH, "Candidate %ld", i);
+        setStudentName(q, s, name);
+        q->students.rank[s] = (int)(i + 1);
+        q->students.flags[s] = STUDENT_VERIFIED;
+        for (int k = 1; k < seatPoolCount; k++)
+            if (rngNext(rng) % BENCH_POOL_ODDS == 0)
+                q->students.categories[s] |= (uint8_t)(1u << k);
+        generatePreferences(q, rng, s, cdf, order);
+        cohort->students[i] = s;
+
+        snprintf(cohort->dob[i], 11, "%02d-%02d-%04d",
+                 1 + (int)(rngNext(rng) % 28), 1 + (int)(rngNext(rng) % 12),
+                 2004 + (int)(rngNext(rng) % 4));
+
+        // i -> i * 1000003 + 12345 (mod 10^12) is a bijection, so Aadhars are unique
+        uint64_t v = ((uint64_t)i * 1000003ULL + 12345ULL) % 1000000000000ULL;
+        snprintf(cohort->aadhar[i], 15, "%04d-%04d-%04d",
+                 (int)(v / 100000000ULL), (int)(v / 10000ULL % 10000ULL), (int)(v % 10000ULL));
+    }
+
+    // Candidates register in random order, not rank order
+    for (long i = n - 1; i > 0; i--) {
+        long j = (long)(rngNext(rng) % (uint64_t)(i + 1));
+        StudentId t = cohort->students[i];
+        cohort->students[i] = cohort->students[j];
+        cohort->students[j] = t;
+        char d[11], a[15];
+        memcpy(d, cohort->dob[i], 11); memcpy(cohort->dob[i], cohort->dob[j], 11); memcpy(cohort->dob[j], d, 11);
+        memcpy(a, cohort->aadhar[i], 15); memcpy(cohort->aadhar[i], cohort->aadhar[j], 15); memcpy(cohort->aadhar[j], a, 15);
+    }
+}
+
+// ==========================================================
+//                     TIMING HELPERS
+// ==========================================================
+
+static void samplerInit(Sampler* sampler, long ops) {
+    sampler->stride = ops / BENCH_MAX_SAMPLES + 1;
+    sampler->samples = (double*)malloc((ops / sampler->stride + 1) * sizeof(double));
+    sampler->count = 0;
+}
+
+static int compareDoubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static void finishPhase(PhaseResult* r, const char* name, long ops, double seconds, Sampler* sampler) {
+    r->name = name;
+    r->ops = ops;
+    r->seconds = seconds;
+    r->sampled = (sampler != NULL && sampler->count > 0);
+    if (r->sampled) {
+        qsort(sampler->samples, sampler->count, sizeof(double), compareDoubles);
+        r->p50_us = sampler->samples[sampler->count / 2] * 1e6;
+        r->p99_us = sampler->samples[(int)(sampler->count * 0.99)] * 1e6;
+        r->max_us = sampler->samples[sampler->count - 1] * 1e6;
+    }
+    if (sampler != NULL) free(sampler->samples);
+}
+
+// processAllocation and friends print progress; keep it out of the report
+static int silenceStdout(void) {
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    int devnull = open("/dev/null", O_WRONLY);
+    dup2(devnull, STDOUT_FILENO);
+    close(devnull);
+    return saved;
+}
+
+static void restoreStdout(int saved) {
+    fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+}
+
+// One registration client: journals every clients-th registration of
+// the cohort and waits for each to be durable before the next
+typedef struct {
+    Journal* journal;
+    Queue* q;
+    const Cohort* cohort;
+    int client;
+    int clients;
+    Sampler sampler;
+    bool failed;
+} JournalClient;
+
+static void* journalClientMain(void* arg) {
+    JournalClient* c = (JournalClient*)arg;
+    long done = 0;
+    for (long i = c->client; i < c->cohort->count; i += c->clients, done++) {
+        double s0 = monotonicSeconds();
+        uint64_t sequence = journalRegistration(c->journal, c->q, c->cohort->students[i],
+                                                c->cohort->dob[i], c->cohort->aadhar[i]);
+        if (!journalSync(c->journal, sequence)) c->failed = true;
+        if (done % c->sampler.stride == 0)
+            c->sampler.samples[c->sampler.count++] = monotonicSeconds() - s0;
+    }
+    return NULL;
+}
+
+// Writes a priority file to path (a mkstemp template) that ranks one
+// candidate in BENCH_PRIORITY_ODDS at their first choice, in every pool
+static bool writeBenchPriorities(Queue* q, const Cohort* cohort, Rng* rng, char* path) {
+    int fd = mkstemp(path);
+    if (fd < 0) return false;
+    FILE* out = fdopen(fd, "w");
+    const StudentStore* store = &q->students;
+    for (long i = 0; i < cohort->count; i++) {
+        StudentId s = cohort->students[i];
+        if (rngNext(rng) % BENCH_PRIORITY_ODDS != 0 || store->num_preferences[s] == 0) continue;
+        fprintf(out, "%s,%d,%d\n", store->reg_number[s], STUDENT_PREFS(q, s)[0] + 1,
+                1 + (int)(rngNext(rng) % BENCH_PRIORITY_LEVELS));
+    }
+    return fclose(out) == 0;
+}
+
+// Journals the cohort's registrations into a new journal at path and
+// returns the seconds taken; the merged latencies end up in sampler
+static double journalCohort(Queue* q, const Cohort* cohort, const char* path,
+                            Sampler* sampler, long* syncs) {
+    unlink(path);
+    JournalRecovery recovery;
+    Journal* journal = journalOpen(q, path, &recovery);
+    if (journal == NULL) return -1;
+
+    JournalClient clients[BENCH_JOURNAL_CLIENTS];
+    pthread_t threads[BENCH_JOURNAL_CLIENTS];
+    // Each client rounds its own share up, so leave room for one extra sample each
+    samplerInit(sampler, cohort->count);
+    sampler->samples = (double*)realloc(sampler->samples,
+        (cohort->count / sampler->stride + 1 + BENCH_JOURNAL_CLIENTS) * sizeof(double));
+    double t0 = monotonicSeconds();
+    for (int c = 0; c < BENCH_JOURNAL_CLIENTS; c++) {
+        clients[c] = (JournalClient){ journal, q, cohort, c, BENCH_JOURNAL_CLIENTS, { 0 }, false };
+        samplerInit(&clients[c].sampler, cohort->count / BENCH_JOURNAL_CLIENTS + 1);
+        clients[c].sampler.stride = sampler->stride;
+        pthread_create(&threads[c], NULL, journalClientMain, &clients[c]);
+    }
+    bool failed = false;
+    for (int c = 0; c < BENCH_JOURNAL_CLIENTS; c++) {
+        pthread_join(threads[c], NULL);
+        memcpy(sampler->samples + sampler->count, clients[c].sampler.samples,
+               clients[c].sampler.count * sizeof(double));
+        sampler->count += clients[c].sampler.count;
+        failed |= clients[c].failed;
+        free(clients[c].sampler.samples);
+    }
+    double seconds = monotonicSeconds() - t0;
+
+    long records;
+    journalStats(journal, &records, syncs);
+    journalClose(journal);
+    if (failed) {
+        free(sampler->samples);
+        return -1;
+    }
+    return seconds;
+}
+
+// One service client: sends its share of the request mix over its own
+// connection and waits for each reply before the next request
+typedef struct {
+    const char* path;
+    long n;                            // Cohort size
+    char (*regs)[MAX_REG_LENGTH];      // Copied; the store grows while serving
+    const Cohort* cohort;
+    int client;
+    long requests;
+    Sampler sampler;
+    long registerAttempts;
+    long registered;
+    long duplicates;                   // Registrations refused as duplicates
+    long refused;                      // Other ERR replies
+    bool failed;
+} ServeClient;
+
+static bool sendRequest(int fd, const char* request, size_t len, char* reply, size_t capacity) {
+    while (len > 0) {
+        ssize_t sent = write(fd, request, len);
+        if (sent <= 0) return false;
+        request += sent;
+        len -= (size_t)sent;
+    }
+    size_t used = 0;
+    while (used == 0 || reply[used - 1] != '\n') {
+        ssize_t got = read(fd, reply + used, capacity - 1 - used);
+        if (got <= 0 || used + (size_t)got >= capacity - 1) return false;
+        used += (size_t)got;
+    }
+    reply[used] = '\0';
+    return true;
+}
+
+// Up to three consecutive programs starting at a random one, as choice numbers
+static void formatChoices(Rng* rng, char* out, size_t len) {
+    int count = MAX_PREFERENCES < 3 ? MAX_PREFERENCES : 3;
+    int first = (int)(rngNext(rng) % (uint64_t)programCount);
+    int used = 0;
+    for (int i = 0; i < count; i++)
+        used += snprintf(out + used, len - used, "%s%d", i > 0 ? ";" : "",
+                         (first + i) % programCount + 1);
+}
+
+static void* serveClientMain(void* arg) {
+    ServeClient* c = (ServeClient*)arg;
+    Rng rng = { 0x2545F4914F6CDD1DULL * (uint64_t)(c->client + 1) };
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, c->path, sizeof(addr.sun_path) - 1);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        c->failed = true;
+        if (fd >= 0) close(fd);
+        return NULL;
+    }
+
+    char request[512], reply[8192], choices[32];
+    int pair = c->client / 2;
+    for (long i = 0; i < c->requests; i++) {
+        uint64_t roll = rngNext(&rng) % 100;
+        long k = (long)(rngNext(&rng) % (uint64_t)c->n);
+        bool registering = false;
+        int len;
+        if (roll < 50) {
+            len = snprintf(request, sizeof(request), "VERIFY %s,%s,%s\n",
+                           c->regs[k], c->cohort->dob[k], c->cohort->aadhar[k]);
+        } else if (roll < 75) {
+            len = snprintf(request, sizeof(request), "QUERY %s\n", c->regs[k]);
+        } else if (roll < 95) {
+            // Both clients of a pair walk the same list of walk-in candidates
+            long m = pair + c->registerAttempts++ * (BENCH_SERVE_CLIENTS / 2);
+            uint64_t v = ((uint64_t)(c->n + m) * 1000003ULL + 12345ULL) % 1000000000000ULL;
+            formatChoices(&rng, choices, sizeof(choices));
+            len = snprintf(request, sizeof(request),
+                           "REGISTER DC%06ld,Walk-in %ld,%ld,15-06-2005,%04d-%04d-%04d,%s\n",
+                           m, m, c->n + m + 1, (int)(v / 100000000ULL),
+                           (int)(v / 10000ULL % 10000ULL), (int)(v % 10000ULL), choices);
+            registering = true;
+        } else {
+            formatChoices(&rng, choices, sizeof(choices));
+            len = snprintf(request, sizeof(request), "UPDATE %s,%s,%s,%s\n",
+                           c->regs[k], c->cohort->dob[k], c->cohort->aadhar[k], choices);
+        }
+
+        double s0 = monotonicSeconds();
+        if (!sendRequest(fd, request, (size_t)len, reply, sizeof(reply))) {
+            c->failed = true;
+            break;
+        }
+        if (i % c->sampler.stride == 0)
+            c->sampler.samples[c->sampler.count++] = monotonicSeconds() - s0;
+
+        if (strncmp(reply, "OK", 2) == 0) {
+            if (registering) c->registered++;
+        } else if (registering && strncmp(reply, "ERR duplicate", 13) == 0) {
+            c->duplicates++;
+        } else {
+            c->refused++;
+        }
+    }
+    close(fd);
+    return NULL;
+}
+
+// Serves q on path to BENCH_SERVE_CLIENTS clients sending requests in
+// total and returns the seconds taken. Fails if a cohort student is missing
+// from the student index, or unless every new candidate was registered
+// exactly once and nothing else was refused.
+static double serveCohort(Queue* q, const Cohort* cohort, const BenchConfig* config, long requests,
+                          Sampler* sampler, long* registered, long* duplicates) {
+    long n = cohort->count;
+    char (*regs)[MAX_REG_LENGTH] = malloc(n * sizeof(*regs));
+    for (long i = 0; i < n; i++) {
+        memcpy(regs[i], q->students.reg_number[cohort->students[i]], MAX_REG_LENGTH);
+        // QUERY and UPDATE find students through the reg index
+        if (findStudentByReg(regs[i]) != cohort->students[i]) {
+            printf("%sError: %s is not in the student index; QUERY and UPDATE would be refused%s\n",
+                   COLOR_RED, regs[i], COLOR_RESET);
+            free(regs);
+            return -1;
+        }
+    }
+    int before = q->students.live;
+
+    Server* server = serverStart(q, config->socketPath, config->threads);
+    if (server == NULL) {
+        free(regs);
+        return -1;
+    }
+
+    ServeClient clients[BENCH_SERVE_CLIENTS];
+    pthread_t threads[BENCH_SERVE_CLIENTS];
+    samplerInit(sampler, requests);
+    sampler->samples = (double*)realloc(sampler->samples,
+        (requests / sampler->stride + 1 + BENCH_SERVE_CLIENTS) * sizeof(double));
+    double t0 = monotonicSeconds();
+    for (int c = 0; c < BENCH_SERVE_CLIENTS; c++) {
+        clients[c] = (ServeClient){ config->socketPath, n, regs, cohort, c,
+                                    requests / BENCH_SERVE_CLIENTS + (c < requests % BENCH_SERVE_CLIENTS),
+                                    { 0 }, 0, 0, 0, 0, false };
+        samplerInit(&clients[c].sampler, clients[c].requests);
+        clients[c].sampler.stride = sampler->stride;
+        pthread_create(&threads[c], NULL, serveClientMain, &clients[c]);
+    }
+    bool failed = false;
+    long unique = 0, refused = 0;
+    *registered = *duplicates = 0;
+    for (int c = 0; c < BENCH_SERVE_CLIENTS; c++) {
+        pthread_join(threads[c], NULL);
+        memcpy(sampler->samples + sampler->count, clients[c].sampler.samples,
+               clients[c].sampler.count * sizeof(double));
+        sampler->count += clients[c].sampler.count;
+        failed |= clients[c].failed;
+        *registered += clients[c].registered;
+        *duplicates += clients[c].duplicates;
+        refused += clients[c].refused;
+        free(clients[c].sampler.samples);
+    }
+    double seconds = monotonicSeconds() - t0;
+
+    // A pair's candidates are those of its busier client
+    for (int c = 0; c < BENCH_SERVE_CLIENTS; c += 2)
+        unique += clients[c].registerAttempts > clients[c + 1].registerAttempts ?
+                  clients[c].registerAttempts : clients[c + 1].registerAttempts;
+    serverReport(server);
+    serverStop(server);
+    free(regs);
+
+    if (failed || refused > 0 || *registered != unique || q->students.live != before + unique) {
+        printf("%sError: %ld of %ld new candidates registered, %ld other refusals%s\n",
+               COLOR_RED, *registered, unique, refused, COLOR_RESET);
+        free(sampler->samples);
+        return -1;
+    }
+    return seconds;
+}
+
+// Times loadSnapshot on path in a child process and returns the seconds
+// taken, or -1 unless it reopens live students. Loading installs the
+// snapshot's catalog and verification store and dropping the queue clears
+// the student index, so doing it here would wreck the session under test.
+static double timeSnapshotLoad(const char* path, int live) {
+    int fds[2];
+    if (pipe(fds) != 0) return -1;
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        double t0 = monotonicSeconds();
+        Queue* reopened = loadSnapshot(path);
+        double seconds = monotonicSeconds() - t0;
+        if (reopened == NULL || reopened->students.live != live) seconds = -1;
+        cleanupQueue(reopened);
+        releaseSnapshot();
+        ssize_t written = write(fds[1], &seconds, sizeof(seconds));
+        fflush(stdout);
+        _exit(written == (ssize_t)sizeof(seconds) ? 0 : 1);
+    }
+    close(fds[1]);
+
+    double seconds = -1;
+    if (pid < 0 || read(fds[0], &seconds, sizeof(seconds)) != (ssize_t)sizeof(seconds))
+        seconds = -1;
+    close(fds[0]);
+    if (pid > 0) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) seconds = -1;
+    }
+    return seconds;
+}
+
+// ==========================================================
+//                      ONE BENCHMARK SIZE
+// ==========================================================
+
+static void reportSize(long n, PhaseResult* phases, int count, long peakRssKb, const char* jsonPath) {
+    printf("\n%sN = %ld%s  (peak RSS %.1f MB)\n", COLOR_BLUE, n, COLOR_RESET, peakRssKb / 1024.0);
+    printf("%-10s %10s %10s %14s %10s %10s %10s\n",
+           "Phase", "Ops", "Time(s)", "Ops/sec", "p50(us)", "p99(us)", "max(us)");
+    printf("--------------------------------------------------------------------------------\n");
+    for (int i = 0; i < count; i++) {
+        PhaseResult* r = &phases[i];
+        printf("%-10s %10ld %10.4f %14.0f", r->name, r->ops, r->seconds,
+               r->seconds > 0 ? r->ops / r->seconds : 0.0);
+        if (r->sampled)
+            printf(" %10.2f %10.2f %10.2f\n", r->p50_us, r->p99_us, r->max_us);
+        else
+            printf(" %10s %10s %10s\n", "-", "-", "-");
+    }
+    fflush(stdout);
+
+    if (jsonPath == NULL) return;
+    FILE* json = fopen(jsonPath, "a");
+    if (json == NULL) return;
+    for (int i = 0; i < count; i++) {
+        PhaseResult* r = &phases[i];
+        fprintf(json, "{\"n\":%ld,\"phase\":\"%s\",\"ops\":%ld,\"seconds\":%.6f,"
+                      "\"ops_per_sec\":%.1f,\"peak_rss_kb\":%ld",
+                n, r->name, r->ops, r->seconds,
+                r->seconds > 0 ? r->ops / r->seconds : 0.0, peakRssKb);
+        if (r->sampled)
+            fprintf(json, ",\"p50_us\":%.3f,\"p99_us\":%.3f,\"max_us\":%.3f",
+                    r->p50_us, r->p99_us, r->max_us);
+        fprintf(json, "}\n");
+    }
+    fclose(json);
+}
+
+static void runSize(const BenchConfig* config, long n) {
+    PhaseResult phases[32];
+    int phaseCount = 0;
+    Sampler sampler;
+    Rng rng = { config->seed ^ (uint64_t)n ^ 0x9E3779B97F4A7C15ULL };
+
+    int saved = silenceStdout();
+    initializeColleges((int)(n * config->seatRatio) + 1);
+    restoreStdout(saved);
+    MAX_PREFERENCES = config->maxPrefs < programCount ? config->maxPrefs : programCount;
+
+    // Generate; records come from the queue's student pool
+    Queue* q = createQueue();
+    int* order = (int*)malloc(programCount * sizeof(int));
+    double t0 = monotonicSeconds();
+    double* cdf = buildZipfCdf(&rng, order, programCount);
+    Cohort cohort;
+    generateCohort(q, &cohort, n, &rng, cdf, order);
+    finishPhase(&phases[phaseCount++], "generate", n, monotonicSeconds() - t0, NULL);
+
+    // Field validation in batch-sized blocks, packing included
+    {
+        char* regs = (char*)malloc(BENCH_VALIDATE_BLOCK * VALID_FIELD_WIDTH);
+        char* dobs = (char*)malloc(BENCH_VALIDATE_BLOCK * VALID_FIELD_WIDTH);
+        char* aadhars = (char*)malloc(BENCH_VALIDATE_BLOCK * VALID_FIELD_WIDTH);
+        uint8_t* checks = (uint8_t*)malloc(3 * BENCH_VALIDATE_BLOCK);
+        StudentStore* store = &q->students;
+        long invalid = 0;
+        t0 = monotonicSeconds();
+        CalendarDate today;
+        calendarToday(&today);
+        for (long base = 0; base < n; base += BENCH_VALIDATE_BLOCK) {
+            int count = (n - base < BENCH_VALIDATE_BLOCK) ? (int)(n - base) : BENCH_VALIDATE_BLOCK;
+            for (int i = 0; i < count; i++) {
+                packField(regs + (size_t)i * VALID_FIELD_WIDTH, store->reg_number[cohort.students[base + i]]);
+                packField(dobs + (size_t)i * VALID_FIELD_WIDTH, cohort.dob[base + i]);
+                packField(aadhars + (size_t)i * VALID_FIELD_WIDTH, cohort.aadhar[base + i]);
+            }
+            validateRegNumbers(regs, count, checks);
+            validateDates(dobs, count, &today, checks + BENCH_VALIDATE_BLOCK);
+            validateAadhars(aadhars, count, checks + 2 * BENCH_VALIDATE_BLOCK);
+            for (int i = 0; i < count; i++)
+                invalid += (checks[i] | checks[BENCH_VALIDATE_BLOCK + i] | checks[2 * BENCH_VALIDATE_BLOCK + i]) != FIELD_OK;
+        }
+        finishPhase(&phases[phaseCount++], "validate", n, monotonicSeconds() - t0, NULL);
+        if (invalid > 0)
+            printf("%sError: %ld generated records failed validation%s\n", COLOR_RED, invalid, COLOR_RESET);
+        free(regs);
+        free(dobs);
+        free(aadhars);
+        free(checks);
+    }
+
+    // Register in the verification store
+    samplerInit(&sampler, n);
+    t0 = monotonicSeconds();
+    StudentStore* store = &q->students;
+    for (long i = 0; i < n; i++) {
+        StudentId s = cohort.students[i];
+        if (i % sampler.stride == 0) {
+            double s0 = monotonicSeconds();
+            addToVerificationData(store->reg_number[s], STUDENT_NAME(store, s), cohort.dob[i], cohort.aadhar[i]);
+            sampler.samples[sampler.count++] = monotonicSeconds() - s0;
+        } else {
+            addToVerificationData(store->reg_number[s], STUDENT_NAME(store, s), cohort.dob[i], cohort.aadhar[i]);
+        }
+    }
+    finishPhase(&phases[phaseCount++], "register", n, monotonicSeconds() - t0, &sampler);
+
+    // Enqueue one at a time, in registration order
+    samplerInit(&sampler, n);
+    t0 = monotonicSeconds();
+    for (long i = 0; i < n; i++) {
+        if (i % sampler.stride == 0) {
+            double s0 = monotonicSeconds();
+            enqueue(q, cohort.students[i]);
+            sampler.samples[sampler.count++] = monotonicSeconds() - s0;
+        } else {
+            enqueue(q, cohort.students[i]);
+        }
+    }
+    finishPhase(&phases[phaseCount++], "enqueue", n, monotonicSeconds() - t0, &sampler);
+
+    // The same registrations through the journal, acknowledged once durable
+    long journalSyncs = 0;
+    if (config->journalPath != NULL) {
+        double seconds = journalCohort(q, &cohort, config->journalPath, &sampler, &journalSyncs);
+        if (seconds < 0)
+            printf("%sError: Journal phase failed%s\n", COLOR_RED, COLOR_RESET);
+        else
+            finishPhase(&phases[phaseCount++], "journal", n, seconds, &sampler);
+    }
+
+    // Verification lookups; one claim in ten carries a wrong DOB
+    long lookups = config->lookups < n ? config->lookups : n;
+    long verified = 0;
+    samplerInit(&sampler, lookups);
+    t0 = monotonicSeconds();
+    for (long i = 0; i < lookups; i++) {
+        long k = (long)(rngNext(&rng) % (uint64_t)n);
+        const char* dob = (i % 10 == 9) ? "31-12-1999" : cohort.dob[k];
+        if (i % sampler.stride == 0) {
+            double s0 = monotonicSeconds();
+            verified += checkVerificationClaim(store->reg_number[cohort.students[k]], dob, cohort.aadhar[k]) == VERIFY_OK;
+            sampler.samples[sampler.count++] = monotonicSeconds() - s0;
+        } else {
+            verified += checkVerificationClaim(store->reg_number[cohort.students[k]], dob, cohort.aadhar[k]) == VERIFY_OK;
+        }
+    }
+    finishPhase(&phases[phaseCount++], "verify", lookups, monotonicSeconds() - t0, &sampler);
+
+    // A claim file for the whole cohort, checked on 1, 2, 4, ... worker
+    // threads up to the configured count; the same one in ten wrong DOBs
+    static char claimPhases[BENCH_CLAIM_STEPS][16];
+    long claimsVerified = 0;
+    {
+        char* text = (char*)malloc((size_t)n * 48 + 1);
+        size_t size = 0;
+        for (long i = 0; i < n; i++)
+            size += sprintf(text + size, "%s,%s,%s\n", store->reg_number[cohort.students[i]],
+                            (i % 10 == 9) ? "31-12-1999" : cohort.dob[i], cohort.aadhar[i]);
+        int maxThreads = workerThreadCount();
+        for (int threads = 1, k = 0; k < BENCH_CLAIM_STEPS; k++) {
+            setWorkerThreads(threads);
+            ClaimSummary summary;
+            verifyClaims(q, text, size, NULL, &summary);
+            snprintf(claimPhases[k], sizeof(claimPhases[k]), "claims/%d", workerThreadCount());
+            finishPhase(&phases[phaseCount++], claimPhases[k], summary.claims, summary.seconds, NULL);
+            claimsVerified = summary.counts[CLAIM_VERIFIED];
+            if (threads >= maxThreads) break;
+            threads = (threads * 2 < maxThreads) ? threads * 2 : maxThreads;
+        }
+        setWorkerThreads(config->threads);
+        free(text);
+    }
+
+    // Deferred acceptance with college-side priorities, then without
+    long displacedByPriority = -1;
+    char priorityPath[] = "/tmp/comedk_benchXXXXXX";
+    long priorityLines, priorityRejected;
+    if (writeBenchPriorities(q, &cohort, &rng, priorityPath) &&
+        loadCollegePriorities(q, priorityPath, &priorityLines, &priorityRejected)) {
+        setAllocationEngine(ALLOCATION_DEFERRED);
+        saved = silenceStdout();
+        t0 = monotonicSeconds();
+        processAllocation(q);
+        double seconds = monotonicSeconds() - t0;
+        restoreStdout(saved);
+        finishPhase(&phases[phaseCount++], "prio-da", n, seconds, NULL);
+        displacedByPriority = q->allocation->deferred.displaced;
+        releaseCollegePriorities(q->priorities);
+        q->priorities = NULL;
+    }
+    unlink(priorityPath);
+
+    setAllocationEngine(ALLOCATION_DEFERRED);
+    saved = silenceStdout();
+    t0 = monotonicSeconds();
+    processAllocation(q);
+    double deferredTime = monotonicSeconds() - t0;
+    restoreStdout(saved);
+    finishPhase(&phases[phaseCount++], "deferred", n, deferredTime, NULL);
+    int* deferredOutcome = (int*)malloc(n * sizeof(int));
+    for (long i = 0; i < n; i++)
+        deferredOutcome[i] = q->students.allocated_program[cohort.students[i]];
+    setAllocationEngine(ALLOCATION_SERIAL);
+
+    // Full allocation
+    saved = silenceStdout();
+    t0 = monotonicSeconds();
+    processAllocation(q);
+    double allocTime = monotonicSeconds() - t0;
+    restoreStdout(saved);
+    finishPhase(&phases[phaseCount++], "allocate", n, allocTime, NULL);
+    long engineMismatches = 0;
+    for (long i = 0; i < n; i++)
+        engineMismatches += deferredOutcome[i] != q->students.allocated_program[cohort.students[i]];
+    free(deferredOutcome);
+    if (engineMismatches > 0)
+        printf("%sError: Deferred acceptance without priorities differs from the serial allotment "
+               "for %ld candidate(s)%s\n", COLOR_RED, engineMismatches, COLOR_RESET);
+
+    // Preference edits followed by an incremental refresh
+    long updates = config->updates < n ? config->updates : n;
+    long evaluated = 0;
+    samplerInit(&sampler, updates);
+    t0 = monotonicSeconds();
+    for (long i = 0; i < updates; i++) {
+        StudentId s = cohort.students[rngNext(&rng) % (uint64_t)n];
+        double s0 = monotonicSeconds();
+        generatePreferences(q, &rng, s, cdf, order);
+        evaluated += commitPreferenceUpdate(q, s);
+        if (i % sampler.stride == 0)
+            sampler.samples[sampler.count++] = monotonicSeconds() - s0;
+    }
+    finishPhase(&phases[phaseCount++], "update", updates, monotonicSeconds() - t0, &sampler);
+
+    // Cutoff queries: programs open at a random rank, then one closing rank
+    const CutoffTable* cutoffs = q->allocation->cutoffs;
+    uint16_t* reachable = (uint16_t*)malloc(programCount * sizeof(uint16_t));
+    uint8_t allPools = (uint8_t)((1u << seatPoolCount) - 1);
+    long openTotal = 0;
+    samplerInit(&sampler, lookups);
+    t0 = monotonicSeconds();
+    for (long i = 0; i < lookups; i++) {
+        int rank = 1 + (int)(rngNext(&rng) % (uint64_t)n);
+        int program_id = (int)(rngNext(&rng) % (uint64_t)programCount);
+        double s0 = monotonicSeconds();
+        openTotal += reachablePrograms(cutoffs, rank, allPools, reachable);
+        openTotal += closingRank(cutoffs, program_id, allPools) > rank;
+        if (i % sampler.stride == 0)
+            sampler.samples[sampler.count++] = monotonicSeconds() - s0;
+    }
+    finishPhase(&phases[phaseCount++], "cutoff", lookups, monotonicSeconds() - t0, &sampler);
+    free(reachable);
+
+    // Preference flow: one program-to-program weight and the cached next
+    // choices of a random program
+    long nextTotal = 0, linked = 0;
+    samplerInit(&sampler, lookups);
+    t0 = monotonicSeconds();
+    for (long i = 0; i < lookups; i++) {
+        int from = (int)(rngNext(&rng) % (uint64_t)programCount);
+        int to = (int)(rngNext(&rng) % (uint64_t)programCount);
+        uint16_t top[COPREF_TOP];
+        uint32_t weights[COPREF_TOP];
+        double s0 = monotonicSeconds();
+        linked += preferenceFlow(q, from, to) > 0;
+        nextTotal += topCoPreferred(q, from, top, weights);
+        if (i % sampler.stride == 0)
+            sampler.samples[sampler.count++] = monotonicSeconds() - s0;
+    }
+    finishPhase(&phases[phaseCount++], "flow", lookups, monotonicSeconds() - t0, &sampler);
+
+    // Demand analytics: one scan of every student's list on the workers
+    DemandReport* demand = analyzeDemand(q);
+    int oversubscribed = 0;
+    for (int p = 0; p < demand->programs; p++)
+        oversubscribed += oversubscription(demand, p) > 1.0;
+    finishPhase(&phases[phaseCount++], "demand", n, demand->seconds, NULL);
+    releaseDemandReport(demand);
+
+    // Export: the whole allotment as CSV, formatted and written to /dev/null
+    ExportStats exported = { 0, 0, 0 };
+    if (exportResults(q, EXPORT_ALLOTMENT, EXPORT_CSV, NULL, "/dev/null", &exported))
+        finishPhase(&phases[phaseCount++], "export", exported.rows, exported.seconds, NULL);
+
+    // What-if edits against a snapshot, evaluated together on the workers
+    long displaced = -1;  // Stays -1 unless the phase runs
+    AllocationSnapshot* snap = takeAllocationSnapshot(q);
+    if (snap != NULL && updates > 0) {
+        WhatIfEdit* edits = (WhatIfEdit*)malloc(updates * sizeof(WhatIfEdit));
+        WhatIfOutcome* outcomes = (WhatIfOutcome*)malloc(updates * sizeof(WhatIfOutcome));
+        uint16_t* lists = (uint16_t*)malloc((size_t)updates * BENCH_MAX_PREFS * sizeof(uint16_t));
+        for (long i = 0; i < updates; i++) {
+            edits[i].student = cohort.students[rngNext(&rng) % (uint64_t)n];
+            edits[i].preferences = lists + (size_t)i * BENCH_MAX_PREFS;
+            edits[i].count = drawPreferences(&rng, cdf, order, lists + (size_t)i * BENCH_MAX_PREFS);
+        }
+        double seconds = simulateWhatIf(snap, edits, outcomes, (int)updates);
+        finishPhase(&phases[phaseCount++], "what-if", updates, seconds, NULL);
+        displaced = 0;
+        for (long i = 0; i < updates; i++) displaced += outcomes[i].displaced;
+        free(lists);
+        free(outcomes);
+        free(edits);
+    }
+    releaseAllocationSnapshot(snap);
+
+    // Save the session and map it back
+    double snapshotMb = -1;
+    if (config->snapshotPath != NULL) {
+        t0 = monotonicSeconds();
+        bool saved = saveSnapshot(q, config->snapshotPath);
+        finishPhase(&phases[phaseCount++], "save", n, monotonicSeconds() - t0, NULL);
+        struct stat st;
+        if (saved && stat(config->snapshotPath, &st) == 0) {
+            snapshotMb = st.st_size / (1024.0 * 1024.0);
+            double seconds = timeSnapshotLoad(config->snapshotPath, q->students.live);
+            if (seconds < 0)
+                printf("%sError: Load phase failed%s\n", COLOR_RED, COLOR_RESET);
+            else
+                finishPhase(&phases[phaseCount++], "load", n, seconds, NULL);
+        }
+    }
+
+    // Second counselling round: 5% exit and 15% accept after round 1
+    // (rounds are not available with seat pools)
+    int roundExits = -1;
+    if (seatPoolCount == 1) {
+        for (long i = 0; i < n; i++) {
+            uint64_t roll = rngNext(&rng) % 100;
+            if (roll < 5) recordRoundResponse(q, cohort.students[i], ROUND_EXIT);
+            else if (roll < 20) recordRoundResponse(q, cohort.students[i], ROUND_ACCEPT);
+        }
+        const RoundSnapshot* second = runNextRound(q);
+        finishPhase(&phases[phaseCount++], "round", second->touched, second->seconds, NULL);
+        roundExits = second->exits;
+    }
+
+    // Concurrent clients over the registration service
+    long serveRegistered = 0, serveDuplicates = 0;
+    bool served = false;
+    if (config->socketPath != NULL) {
+        long requests = lookups < BENCH_SERVE_MAX ? lookups : BENCH_SERVE_MAX;
+        double seconds = serveCohort(q, &cohort, config, requests, &sampler,
+                                     &serveRegistered, &serveDuplicates);
+        served = (seconds >= 0);
+        if (!served)
+            printf("%sError: Serve phase failed%s\n", COLOR_RED, COLOR_RESET);
+        else
+            finishPhase(&phases[phaseCount++], "serve", requests, seconds, &sampler);
+    }
+
+    // Cleanup
+    t0 = monotonicSeconds();
+    cleanupQueue(q);
+    finishPhase(&phases[phaseCount++], "cleanup", n, monotonicSeconds() - t0, NULL);
+
+    // Recovery: the journal replayed into an empty verification store and queue
+    long recovered = -1;
+    if (config->journalPath != NULL && journalSyncs > 0) {
+        HashIndexImage empty = { NULL, 0, 0, 0 };
+        adoptVerificationData(NULL, 0, &empty, &empty);
+        Queue* fresh = createQueue();
+        JournalRecovery recovery;
+        fresh->journal = journalOpen(fresh, config->journalPath, &recovery);
+        if (fresh->journal != NULL) {
+            finishPhase(&phases[phaseCount++], "recover", recovery.replayed, recovery.seconds, NULL);
+            recovered = fresh->students.live;
+        }
+        cleanupQueue(fresh);
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    reportSize(n, phases, phaseCount, usage.ru_maxrss, config->jsonPath);
+    // Phases that did not run are left out rather than shown as zeros
+    printf("verified %ld/%ld claims, %ld/%ld file claims", verified, lookups, claimsVerified, n);
+    if (updates > 0)
+        printf(", %.1f students re-evaluated per edit", (double)evaluated / updates);
+    if (lookups > 0)
+        printf(", %.1f programs open per cutoff query, "
+               "%.1f next choices per flow query (%.0f%% of pairs linked)",
+               (double)openTotal / lookups, (double)nextTotal / lookups, 100.0 * linked / lookups);
+    printf(", %d program(s) oversubscribed", oversubscribed);
+    if (exported.seconds > 0)
+        printf(", %.0f MB/s allotment export", exported.bytes / (1024.0 * 1024.0) / exported.seconds);
+    if (allocTime > 0)
+        printf(", deferred acceptance at %.2fx the serial time", deferredTime / allocTime);
+    if (displacedByPriority >= 0)
+        printf(", %.1f displaced per 1000 with priorities", 1000.0 * displacedByPriority / n);
+    if (displaced >= 0)
+        printf(", %.1f students displaced per what-if", (double)displaced / updates);
+    if (snapshotMb >= 0)
+        printf(", %.1f MB snapshot", snapshotMb);
+    if (journalSyncs > 0)
+        printf(", %.1f registrations per journal sync", (double)n / journalSyncs);
+    if (recovered >= 0)
+        printf(", %ld recovered", recovered);
+    if (roundExits >= 0)
+        printf(", round 2 refilled %d exits", roundExits);
+    if (served)
+        printf(", %ld walk-ins registered over the socket, %ld duplicate(s) refused",
+               serveRegistered, serveDuplicates);
+    printf(", %d seat pool(s) on %d thread(s)\n", seatPoolCount, workerThreadCount());
+
+    free(cdf);
+    free(order);
+    free(cohort.students);
+    free(cohort.dob);
+    free(cohort.aadhar);
+}
+
+// ==========================================================
+//                          DRIVER
+// ==========================================================
+
+static bool parseSizes(BenchConfig* config, char* list) {
+    config->sizeCount = 0;
+    for (char* tok = strtok(list, ","); tok != NULL; tok = strtok(NULL, ",")) {
+        long n = atol(tok);
+        if (n <= 0 || n > 10000000L || config->sizeCount == BENCH_MAX_SIZES)
+            return false;
+        config->sizes[config->sizeCount++] = n;
+    }
+    return config->sizeCount > 0;
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig config = { { 1000, 10000, 100000, 1000000 }, 4,
+                           1000000, 1000, 0.5, 42, 8, 0, NULL, NULL, NULL, NULL, NULL };
+    bool valid = true;
+
+    for (int i = 1; i < argc && valid; i++) {
+        if (strcmp(argv[i], "--sizes") == 0 && i + 1 < argc) {
+            valid = parseSizes(&config, argv[++i]);
+        } else if (strcmp(argv[i], "--lookups") == 0 && i + 1 < argc) {
+            config.lookups = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--updates") == 0 && i + 1 < argc) {
+            config.updates = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--seat-ratio") == 0 && i + 1 < argc) {
+            config.seatRatio = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            config.seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--max-prefs") == 0 && i + 1 < argc) {
+            config.maxPrefs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            config.threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--catalog") == 0 && i + 1 < argc) {
+            config.catalogPath = argv[++i];
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            config.jsonPath = argv[++i];
+        } else if (strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc) {
+            config.snapshotPath = argv[++i];
+        } else if (strcmp(argv[i], "--journal") == 0 && i + 1 < argc) {
+            config.journalPath = argv[++i];
+        } else if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            config.socketPath = argv[++i];
+        } else {
+            valid = false;
+        }
+    }
+    if (!valid || config.lookups < 0 || config.updates < 0 || config.seatRatio <= 0 ||
+        config.maxPrefs < 1 || config.maxPrefs > BENCH_MAX_PREFS || config.threads < 0) {
+        printf("Usage: %s [--sizes 1000,10000,...] [--lookups M] [--updates K]\n"
+               "          [--seat-ratio R] [--seed S] [--catalog file] [--max-prefs P]\n"
+               "          [--threads T] [--json results.jsonl] [--snapshot file]\n"
+               "          [--journal file] [--socket path]\n"
+               "Sizes range from 1 to 10000000 candidates, P from 1 to %d.\n",
+               argv[0], BENCH_MAX_PREFS);
+        return 1;
+    }
+
+    // Each child starts its own worker threads
+    setWorkerThreads(config.threads);
+
+    // Loaded once; every child inherits it and spreads its own seat count
+    if (config.catalogPath != NULL && !loadCatalog(config.catalogPath))
+        return 1;
+
+    // Start a fresh results file for this run
+    if (config.jsonPath != NULL) {
+        FILE* json = fopen(config.jsonPath, "w");
+        if (json == NULL) {
+            printf("%sError: Cannot write %s%s\n", COLOR_RED, config.jsonPath, COLOR_RESET);
+            return 1;
+        }
+        fclose(json);
+    }
+
+    for (int i = 0; i < config.sizeCount; i++) {
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid == 0) {
+            runSize(&config, config.sizes[i]);
+            fflush(stdout);
+            _exit(0);
+        }
+
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            printf("%sN = %ld failed (status %d)%s\n",
+                   COLOR_RED, config.sizes[i], status, COLOR_RESET);
+        }
+    }
+    return 0;
+}
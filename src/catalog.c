@@ -0,0 +1,434 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "enhanced_ds.h"
+
+// ==========================================================
+//   COLLEGE / BRANCH CATALOG
+//
+//   The catalog file has one program per line:
+//     college, branch, seats
+//   e.g.  RV College of Engineering,CSE,120
+//   Comma or tab separated; blank lines and lines starting with
+//   '#' are ignored, and a leading header line is skipped.
+//   Programs are grouped by college in order of first
+//   appearance and numbered in file order within a college;
+//   the number shown in the college list is program id + 1.
+//   Without a file the built-in catalog below is used and the
+//   seats are split evenly.
+//
+//   A header naming several seat columns splits every program
+//   into seat pools, e.g.
+//     college,branch,GM,KQ,SC
+//     RV College of Engineering,CSE,60,40,20
+//   The first seat column is general merit, open to everyone.
+// ==========================================================
+
+#define CATALOG_LINE_LENGTH 512
+
+College* colleges = NULL;
+int collegeCount = 0;
+Branch* branches = NULL;
+int branchCount = 0;
+Program* programs = NULL;
+int programCount = 0;
+int* programCapacity = NULL;
+int* programSeats = NULL;
+int seatPoolCount = 1;
+char seatPoolNames[MAX_SEAT_POOLS][POOL_NAME_LENGTH] = { "GM" };
+int* poolCapacity = NULL;
+int* poolSeats = NULL;
+
+static int collegeCapacity = 0;
+static int branchCapacity = 0;
+static int programCapacityLength = 0;
+static int* loadedPoolSeats = NULL;  // Program-major while a file is read
+
+static const char* defaultColleges[] = {
+    "PES University",
+    "RV College of Engineering",
+    "BMS College of Engineering",
+    "MS Ramaiah Institute of Technology"
+};
+static const char* defaultBranches[] = { "CSE", "ECE" };
+
+// Frees the catalog and seat matrix, leaving an empty one with a single pool
+void releaseCatalog(void) {
+    snapshotFree(colleges);
+    snapshotFree(branches);
+    snapshotFree(programs);
+    snapshotFree(programCapacity);
+    snapshotFree(programSeats);
+    snapshotFree(poolCapacity);
+    snapshotFree(poolSeats);
+    free(loadedPoolSeats);
+    colleges = NULL;
+    branches = NULL;
+    programs = NULL;
+    programCapacity = NULL;
+    programSeats = NULL;
+    poolCapacity = NULL;
+    poolSeats = NULL;
+    loadedPoolSeats = NULL;
+    collegeCount = branchCount = programCount = 0;
+    collegeCapacity = branchCapacity = programCapacityLength = 0;
+    seatPoolCount = 1;
+    strcpy(seatPoolNames[0], "GM");
+}
+
+// Catalogs hold a few hundred names, so a linear scan is fast enough
+static int internCollege(const char* name) {
+    for (int i = 0; i < collegeCount; i++)
+        if (strcmp(colleges[i].name, name) == 0) return i;
+
+    if (collegeCount == collegeCapacity) {
+        collegeCapacity = collegeCapacity ? collegeCapacity * 2 : 16;
+        colleges = (College*)realloc(colleges, collegeCapacity * sizeof(College));
+    }
+    College* c = &colleges[collegeCount];
+    memset(c, 0, sizeof(College));
+    strcpy(c->name, name);
+    return collegeCount++;
+}
+
+static int internBranch(const char* name) {
+    for (int i = 0; i < branchCount; i++)
+        if (strcmp(branches[i].name, name) == 0) return i;
+
+    if (branchCount == branchCapacity) {
+        branchCapacity = branchCapacity ? branchCapacity * 2 : 16;
+        branches = (Branch*)realloc(branches, branchCapacity * sizeof(Branch));
+    }
+    strcpy(branches[branchCount].name, name);
+    return branchCount++;
+}
+
+// seats holds one count per seat pool
+static void addProgram(int college, int branch, const int* seats) {
+    if (programCount == programCapacityLength) {
+        programCapacityLength = programCapacityLength ? programCapacityLength * 2 : 64;
+        programs = (Program*)realloc(programs, programCapacityLength * sizeof(Program));
+        programCapacity = (int*)realloc(programCapacity, programCapacityLength * sizeof(int));
+        if (seatPoolCount > 1)
+            loadedPoolSeats = (int*)realloc(loadedPoolSeats,
+                                            (size_t)programCapacityLength * seatPoolCount * sizeof(int));
+    }
+    programs[programCount].college = (uint16_t)college;
+    programs[programCount].branch = (uint16_t)branch;
+    programCapacity[programCount] = 0;
+    for (int k = 0; k < seatPoolCount; k++) {
+        programCapacity[programCount] += seats[k];
+        if (seatPoolCount > 1)
+            loadedPoolSeats[(size_t)programCount * seatPoolCount + k] = seats[k];
+    }
+    programCount++;
+}
+
+// Stable counting sort by college so every college owns a consecutive range
+// of program ids. Returns false if a college lists the same branch twice.
+static bool groupProgramsByCollege(void) {
+    for (int c = 0; c < collegeCount; c++) colleges[c].program_count = 0;
+    for (int p = 0; p < programCount; p++) colleges[programs[p].college].program_count++;
+
+    int next = 0;
+    for (int c = 0; c < collegeCount; c++) {
+        colleges[c].first_program = next;
+        next += colleges[c].program_count;
+    }
+
+    Program* sorted = (Program*)malloc(programCount * sizeof(Program));
+    int* seats = (int*)malloc(programCount * sizeof(int));
+    int* fill = (int*)calloc(collegeCount, sizeof(int));
+    for (int p = 0; p < programCount; p++) {
+        int c = programs[p].college;
+        int slot = colleges[c].first_program + fill[c]++;
+        sorted[slot] = programs[p];
+        seats[slot] = programCapacity[p];
+
+        // Pool counts end up pool-major in the new program order
+        if (poolCapacity != NULL)
+            for (int k = 0; k < seatPoolCount; k++)
+                poolCapacity[(size_t)k * programCount + slot] =
+                    loadedPoolSeats[(size_t)p * seatPoolCount + k];
+    }
+    free(fill);
+    free(programs);
+    free(programCapacity);
+    programs = sorted;
+    programCapacity = seats;
+    programCapacityLength = programCount;
+
+    for (int c = 0; c < collegeCount; c++) {
+        int first = colleges[c].first_program;
+        for (int i = first; i < first + colleges[c].program_count; i++)
+            for (int j = first; j < i; j++)
+                if (programs[i].branch == programs[j].branch)
+                    return false;
+    }
+    return true;
+}
+
+static char* trimCatalogField(char* field) {
+    while (*field == ' ' || *field == '\t') field++;
+    char* end = field + strlen(field);
+    while (end > field && (end[-1] == ' ' || end[-1] == '\t' ||
+                           end[-1] == '\r' || end[-1] == '\n'))
+        end--;
+    *end = '\0';
+    if (end - field >= 2 && field[0] == '"' && end[-1] == '"') {
+        end[-1] = '\0';
+        field++;
+        // A doubled quote inside stands for one quote
+        char* out = field;
+        for (char* in = field; *in != '\0'; in++) {
+            *out++ = *in;
+            if (in[0] == '"' && in[1] == '"') in++;
+        }
+        *out = '\0';
+    }
+    return field;
+}
+
+#define CATALOG_MAX_FIELDS (2 + MAX_SEAT_POOLS)
+
+// Splits a line into at most CATALOG_MAX_FIELDS fields; a quoted field may
+// hold the delimiter
+static int splitCatalogLine(char* line, char** fields) {
+    char delim = (strchr(line, '\t') != NULL) ? '\t' : ',';
+    int count = 0;
+    char* p = line;
+    while (count < CATALOG_MAX_FIELDS) {
+        char* start = p;
+        bool quoted = false;
+        while (*p != '\0' && (quoted || *p != delim)) {
+            if (*p == '"') quoted = !quoted;
+            p++;
+        }
+        bool last = (*p == '\0');
+        *p = '\0';
+        fields[count++] = trimCatalogField(start);
+        if (last) return count;
+        p++;
+    }
+    return CATALOG_MAX_FIELDS + 1;  // Too many fields
+}
+
+static bool parseSeats(const char* text, int* seats) {
+    char* end;
+    long value = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || value < 0 || value > 1000000000L)
+        return false;
+    *seats = (int)value;
+    return true;
+}
+
+// A header with two or more seat columns names the seat pools
+static const char* readPoolHeader(char** names, int count) {
+    if (count == 1) return NULL;
+    for (int k = 0; k < count; k++) {
+        if (names[k][0] == '\0' || strlen(names[k]) >= POOL_NAME_LENGTH)
+            return "invalid seat pool name";
+        for (int j = 0; j < k; j++)
+            if (strcasecmp(names[j], names[k]) == 0)
+                return "seat pool named twice";
+        strcpy(seatPoolNames[k], names[k]);
+    }
+    seatPoolCount = count;
+    return NULL;
+}
+
+// Replaces the catalog with the programs listed in path. On failure the
+// reason is printed and the catalog is left empty.
+bool loadCatalog(const char* path) {
+    FILE* in = fopen(path, "r");
+    if (in == NULL) {
+        printf("%sError: Cannot open catalog file %s%s\n", COLOR_RED, path, COLOR_RESET);
+        return false;
+    }
+
+    releaseCatalog();
+    char line[CATALOG_LINE_LENGTH];
+    char* fields[CATALOG_MAX_FIELDS];
+    int seats[MAX_SEAT_POOLS];
+    long lineNo = 0;
+    bool firstRecord = true;
+    const char* error = NULL;
+
+    while (error == NULL && fgets(line, sizeof(line), in) != NULL) {
+        lineNo++;
+        char* p = line;
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p == '\0' || *p == '\r' || *p == '\n' || *p == '#') continue;
+
+        int count = splitCatalogLine(line, fields);
+        if (firstRecord) {
+            firstRecord = false;
+            if (count >= 3 && !parseSeats(fields[2], &seats[0])) {  // Header line
+                error = (count > CATALOG_MAX_FIELDS) ? "too many seat pools"
+                                                     : readPoolHeader(fields + 2, count - 2);
+                continue;
+            }
+        }
+
+        bool seatsValid = (count == 2 + seatPoolCount);
+        for (int k = 0; k < seatPoolCount && seatsValid; k++)
+            seatsValid = parseSeats(fields[2 + k], &seats[k]);
+
+        if (count < 3 || count > CATALOG_MAX_FIELDS) {
+            error = "expected college, branch, seats";
+        } else if (count != 2 + seatPoolCount) {
+            error = "expected one seat count per seat pool";
+        } else if (fields[0][0] == '\0' || strlen(fields[0]) >= MAX_NAME_LENGTH) {
+            error = "invalid college name";
+        } else if (fields[1][0] == '\0' || strlen(fields[1]) >= MAX_NAME_LENGTH) {
+            error = "invalid branch name";
+        } else if (!seatsValid) {
+            error = "invalid seat count";
+        } else if (programCount == MAX_PROGRAMS) {
+            error = "too many programs";
+        } else {
+            addProgram(internCollege(fields[0]), internBranch(fields[1]), seats);
+        }
+    }
+    fclose(in);
+
+    if (error == NULL && seatPoolCount > 1 && programCount > 0)
+        poolCapacity = (int*)malloc((size_t)seatPoolCount * programCount * sizeof(int));
+
+    if (error == NULL && programCount == 0) {
+        error = "no programs listed";
+    } else if (error == NULL && !groupProgramsByCollege()) {
+        error = "a college lists the same branch twice";
+        lineNo = 0;
+    }
+    if (error != NULL) {
+        if (lineNo > 0)
+            printf("%sError: %s line %ld: %s%s\n", COLOR_RED, path, lineNo, error, COLOR_RESET);
+        else
+            printf("%sError: %s: %s%s\n", COLOR_RED, path, error, COLOR_RESET);
+        releaseCatalog();
+        return false;
+    }
+
+    free(loadedPoolSeats);
+    loadedPoolSeats = NULL;
+    programSeats = (int*)malloc(programCount * sizeof(int));
+    memcpy(programSeats, programCapacity, programCount * sizeof(int));
+    if (poolCapacity != NULL) {
+        size_t poolBytes = (size_t)seatPoolCount * programCount * sizeof(int);
+        poolSeats = (int*)malloc(poolBytes);
+        memcpy(poolSeats, poolCapacity, poolBytes);
+    }
+    return true;
+}
+
+static void installDefaultCatalog(void) {
+    int collegeTotal = sizeof(defaultColleges) / sizeof(defaultColleges[0]);
+    int branchTotal = sizeof(defaultBranches) / sizeof(defaultBranches[0]);
+    int noSeats[MAX_SEAT_POOLS] = { 0 };
+    for (int c = 0; c < collegeTotal; c++)
+        for (int b = 0; b < branchTotal; b++)
+            addProgram(internCollege(defaultColleges[c]), internBranch(defaultBranches[b]), noSeats);
+    groupProgramsByCollege();
+    programSeats = (int*)calloc(programCount, sizeof(int));
+}
+
+// Sets up the catalog (the built-in one unless a file was loaded) and, when
+// totalStudents is positive, spreads that many seats over it
+void initializeColleges(int totalStudents) {
+    if (programCount == 0)
+        installDefaultCatalog();
+
+    for (int i = 0; i < collegeCount; i++) {
+        colleges[i].preference_count = 0;
+    }
+    memcpy(programSeats, programCapacity, programCount * sizeof(int));
+    if (poolCapacity != NULL)
+        memcpy(poolSeats, poolCapacity, (size_t)seatPoolCount * programCount * sizeof(int));
+
+    // Batch mode sizes the seat matrix only after its input has been read
+    if (totalStudents > 0)
+        distributeSeats(totalStudents);
+}
+
+// Splits a program's seats over the pools in the proportions of the
+// catalog's pool totals; rounding leftovers go to general merit
+static void splitOverPools(int program, int seats, const long* poolTotals, long total) {
+    int assigned = 0;
+    for (int k = seatPoolCount - 1; k >= 0; k--) {
+        int share = (k == 0) ? seats - assigned
+                             : (total > 0 ? (int)(seats * poolTotals[k] / total) : 0);
+        poolCapacity[(size_t)k * programCount + program] = share;
+        poolSeats[(size_t)k * programCount + program] = share;
+        assigned += share;
+    }
+}
+
+// Every college gets an equal share, split evenly over its programs
+void distributeSeats(int totalStudents) {
+    int seatsPerCollege = (totalStudents + collegeCount - 1) / collegeCount;
+
+    long poolTotals[MAX_SEAT_POOLS] = { 0 };
+    long total = 0;
+    if (poolCapacity != NULL) {
+        for (int k = 0; k < seatPoolCount; k++)
+            for (int p = 0; p < programCount; p++)
+                poolTotals[k] += poolCapacity[(size_t)k * programCount + p];
+        for (int k = 0; k < seatPoolCount; k++) total += poolTotals[k];
+    }
+
+    for (int c = 0; c < collegeCount; c++) {
+        int count = colleges[c].program_count;
+        int share = (seatsPerCollege + count - 1) / count * count;
+        for (int p = colleges[c].first_program; p < colleges[c].first_program + count; p++) {
+            programCapacity[p] = share / count;
+            programSeats[p] = programCapacity[p];
+            if (poolCapacity != NULL)
+                splitOverPools(p, programCapacity[p], poolTotals, total);
+        }
+    }
+
+    printf("\n%sInitial Seat Distribution:%s\n", COLOR_BLUE, COLOR_RESET);
+    for (int c = 0; c < collegeCount; c++) {
+        printf("%s:", colleges[c].name);
+        for (int i = 0; i < colleges[c].program_count; i++) {
+            int p = colleges[c].first_program + i;
+            printf("%s %s=%d", i > 0 ? "," : "", branches[programs[p].branch].name, programCapacity[p]);
+        }
+        printf("\n");
+    }
+}
+
+const char* programCollegeName(int program_id) {
+    if (program_id == PROGRAM_NOT_ELIGIBLE) return "Not Eligible";
+    if (program_id < 0) return "Not Allocated";
+    return colleges[PROGRAM_COLLEGE(program_id)].name;
+}
+
+const char* programBranchName(int program_id) {
+    if (program_id < 0) return "NA";
+    return branches[PROGRAM_BRANCH(program_id)].name;
+}
+
+const char* seatPoolName(int pool) {
+    return (pool >= 0 && pool < seatPoolCount) ? seatPoolNames[pool] : "";
+}
+
+// Reads a list of seat pool names separated by commas, ';', '|' or spaces
+// into a categories mask; general merit is always included. Returns false
+// on a name that is not a pool of the catalog.
+bool parsePoolList(char* text, uint8_t* categories) {
+    uint8_t mask = POOL_GENERAL;
+    char* save = NULL;
+    for (char* token = strtok_r(text, ",;| \t\r\n", &save); token != NULL;
+         token = strtok_r(NULL, ",;| \t\r\n", &save)) {
+        int k = 0;
+        while (k < seatPoolCount && strcasecmp(seatPoolNames[k], token) != 0) k++;
+        if (k == seatPoolCount) return false;
+        mask |= (uint8_t)(1u << k);
+    }
+    *categories = mask;
+    return true;
+}
@@ -0,0 +1,254 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "enhanced_ds.h"
+
+// ==========================================================
+//   BATCH CLAIM VERIFICATION
+//
+//   A claim file holds one reg_number,dob,aadhar per line, as
+//   collected at the document verification centres. The lines
+//   are indexed once, then checked CLAIM_TASK_SIZE at a time on
+//   the worker threads: each task splits its own copies of the
+//   lines, validates the dates and Aadhar numbers as one block
+//   and looks the registration numbers up in the verification
+//   store, which nothing writes to meanwhile. Results land in
+//   per-claim slots; marking students verified, catching
+//   repeated claims and writing the mismatch report are done
+//   afterwards in file order, so the outcome does not depend on
+//   the thread count.
+// ==========================================================
+
+#define CLAIM_TASK_SIZE 1024
+#define CLAIM_MAX_LINE  256  // Longer lines are malformed
+
+static const char* claimResultNames[CLAIM_RESULT_COUNT] = {
+    "verified", "malformed", "unknown-reg", "bad-dob",
+    "dob-mismatch", "bad-aadhar", "aadhar-mismatch", "duplicate"
+};
+
+const char* claimResultName(ClaimResult result) {
+    return (result >= 0 && result < CLAIM_RESULT_COUNT) ? claimResultNames[result] : "unknown";
+}
+
+typedef struct {
+    const char* text;
+    const size_t* start;   // Offset of each claim line in text
+    const uint32_t* length;
+    char delim;
+    int count;
+    CalendarDate today;
+    uint8_t* results;      // ClaimResult per claim
+    StudentId* students;
+    char (*regs)[MAX_REG_LENGTH];  // For the report; empty if too long
+} ClaimJob;
+
+static void claimTask(void* context, int task) {
+    ClaimJob* job = (ClaimJob*)context;
+    int first = task * CLAIM_TASK_SIZE;
+    int count = (job->count - first < CLAIM_TASK_SIZE) ? job->count - first : CLAIM_TASK_SIZE;
+
+    char dobs[CLAIM_TASK_SIZE * VALID_FIELD_WIDTH];
+    char aadhars[CLAIM_TASK_SIZE * VALID_FIELD_WIDTH];
+    uint8_t dobChecks[CLAIM_TASK_SIZE];
+    uint8_t aadharChecks[CLAIM_TASK_SIZE];
+    const StudentData* records[CLAIM_TASK_SIZE];
+    int claimOf[CLAIM_TASK_SIZE];
+    int found = 0;  // Claims whose registration number is known
+
+    // Split each line and look its registration number up
+    for (int i = 0; i < count; i++) {
+        int c = first + i;
+        job->regs[c][0] = '\0';
+        job->students[c] = NO_STUDENT;
+
+        char line[CLAIM_MAX_LINE];
+        char* fields[4];
+        if (job->length[c] >= CLAIM_MAX_LINE) {
+            job->results[c] = CLAIM_MALFORMED;
+            continue;
+        }
+        memcpy(line, job->text + job->start[c], job->length[c]);
+        line[job->length[c]] = '\0';
+        int fieldCount = splitFields(line, job->delim, fields, 3);
+        if (strlen(fields[0]) < MAX_REG_LENGTH)
+            strcpy(job->regs[c], fields[0]);
+        if (fieldCount != 3) {
+            job->results[c] = CLAIM_MALFORMED;
+            continue;
+        }
+
+        const StudentData* record = findVerificationByReg(fields[0]);
+        if (record != NULL)
+            job->students[c] = findStudentByReg(fields[0]);
+        if (job->students[c] == NO_STUDENT) {
+            job->results[c] = CLAIM_UNKNOWN_REG;
+            continue;
+        }
+        packField(dobs + (size_t)found * VALID_FIELD_WIDTH, fields[1]);
+        packField(aadhars + (size_t)found * VALID_FIELD_WIDTH, fields[2]);
+        records[found] = record;
+        claimOf[found++] = c;
+    }
+    if (found == 0) return;
+
+    validateDates(dobs, found, &job->today, dobChecks);
+    validateAadhars(aadhars, found, aadharChecks);
+
+    // Same order of checks as checkVerificationClaim
+    for (int i = 0; i < found; i++) {
+        const StudentData* record = records[i];
+        uint8_t* result = &job->results[claimOf[i]];
+        if (dobChecks[i] != FIELD_OK)
+            *result = CLAIM_BAD_DOB;
+        else if (strncmp(dobs + (size_t)i * VALID_FIELD_WIDTH, record->dob, VALID_FIELD_WIDTH) != 0)
+            *result = CLAIM_DOB_MISMATCH;
+        else if (aadharChecks[i] != FIELD_OK)
+            *result = CLAIM_BAD_AADHAR;
+        else if (strncmp(aadhars + (size_t)i * VALID_FIELD_WIDTH, record->aadhar, VALID_FIELD_WIDTH) != 0)
+            *result = CLAIM_AADHAR_MISMATCH;
+        else
+            *result = CLAIM_VERIFIED;
+    }
+}
+
+// A header has neither a registration number nor a date of birth, so a
+// mistyped first claim is still checked and reported
+static bool isClaimHeader(const char* line, size_t len, char delim) {
+    char copy[CLAIM_MAX_LINE];
+    char* fields[4];
+    if (len >= CLAIM_MAX_LINE) return false;  // Reported as malformed
+    memcpy(copy, line, len);
+    copy[len] = '\0';
+    int count = splitFields(copy, delim, fields, 3);
+    return !isValidRegNumber(fields[0]) && (count < 2 || !isValidDOB(fields[1]));
+}
+
+// Indexes the claim lines of text, skipping blank and comment lines and a
+// header. Returns the number of claims; start, length and lineNo are
+// allocated by the callee.
+static int indexClaims(const char* text, size_t size, size_t** start, uint32_t** length,
+                       long** lineNo, char* delim) {
+    int count = 0, capacity = 1024;
+    *start = (size_t*)malloc(capacity * sizeof(size_t));
+    *length = (uint32_t*)malloc(capacity * sizeof(uint32_t));
+    *lineNo = (long*)malloc(capacity * sizeof(long));
+    *delim = 0;
+
+    long line = 0;
+    size_t pos = 0;
+    while (pos < size) {
+        const char* end = memchr(text + pos, '\n', size - pos);
+        size_t next = (end != NULL) ? (size_t)(end - text) + 1 : size;
+        size_t len = (end != NULL) ? (size_t)(end - text) - pos : size - pos;
+        size_t from = pos;
+        pos = next;
+        line++;
+
+        if (len > 0 && text[from + len - 1] == '\r') len--;
+        size_t skip = 0;
+        while (skip < len && (text[from + skip] == ' ' || text[from + skip] == '\t')) skip++;
+        if (skip == len || text[from + skip] == '#') continue;
+
+        // The first claim decides between CSV and TSV; a first line with
+        // neither a registration number nor a date of birth is a header
+        if (*delim == 0) {
+            *delim = (memchr(text + from, '\t', len) != NULL) ? '\t' : ',';
+            if (isClaimHeader(text + from, len, *delim)) continue;
+        }
+
+        if (count == capacity) {
+            capacity *= 2;
+            *start = (size_t*)realloc(*start, capacity * sizeof(size_t));
+            *length = (uint32_t*)realloc(*length, capacity * sizeof(uint32_t));
+            *lineNo = (long*)realloc(*lineNo, capacity * sizeof(long));
+        }
+        (*start)[count] = from;
+        (*length)[count] = len < UINT32_MAX ? (uint32_t)len : UINT32_MAX;
+        (*lineNo)[count] = line;
+        count++;
+    }
+    return count;
+}
+
+// Checks every claim in text and writes the ones that fail to reportPath,
+// if given. Returns false only if the report cannot be written.
+bool verifyClaims(Queue* q, const char* text, size_t size, const char* reportPath, ClaimSummary* summary) {
+    memset(summary, 0, sizeof(*summary));
+    FILE* report = NULL;
+    if (reportPath != NULL && (report = fopen(reportPath, "w")) == NULL)
+        return false;
+    double t0 = monotonicSeconds();
+
+    ClaimJob job;
+    long* lineNo;
+    size_t* start;
+    uint32_t* length;
+    job.count = indexClaims(text, size, &start, &length, &lineNo, &job.delim);
+    job.text = text;
+    job.start = start;
+    job.length = length;
+    calendarToday(&job.today);
+    job.results = (uint8_t*)malloc(job.count + 1);
+    job.students = (StudentId*)malloc((job.count + 1) * sizeof(StudentId));
+    job.regs = malloc((job.count + 1) * sizeof(*job.regs));
+
+    // Lookups build the verification indexes on first use; do that now,
+    // before the workers share them
+    HashIndexImage regImage, aadharImage;
+    verificationIndexImages(&regImage, &aadharImage);
+    runParallel(claimTask, &job, (job.count + CLAIM_TASK_SIZE - 1) / CLAIM_TASK_SIZE);
+
+    // A student is verified by the first matching claim in the file
+    StudentStore* store = &q->students;
+    uint8_t* claimed = (uint8_t*)calloc(store->count + 1, 1);
+    if (report != NULL)
+        fprintf(report, "line,reg_number,reason\n");
+    for (int c = 0; c < job.count; c++) {
+        ClaimResult result = (ClaimResult)job.results[c];
+        if (result == CLAIM_VERIFIED) {
+            StudentId s = job.students[c];
+            if (claimed[s]) {
+                result = CLAIM_DUPLICATE;
+            } else {
+                claimed[s] = 1;
+                store->flags[s] |= STUDENT_VERIFIED;
+            }
+        }
+        summary->counts[result]++;
+        if (result != CLAIM_VERIFIED && report != NULL)
+            fprintf(report, "%ld,%s,%s\n", lineNo[c], job.regs[c], claimResultName(result));
+    }
+    summary->claims = job.count;
+    summary->seconds = monotonicSeconds() - t0;
+
+    free(claimed);
+    free(job.results);
+    free(job.students);
+    free(job.regs);
+    free(start);
+    free(length);
+    free(lineNo);
+    return report == NULL || fclose(report) == 0;
+}
+
+bool verifyClaimFile(Queue* q, const char* claimsPath, const char* reportPath, ClaimSummary* summary) {
+    FILE* in = fopen(claimsPath, "rb");
+    if (in == NULL) return false;
+    size_t size = 0, capacity = 1 << 20;
+    char* text = (char*)malloc(capacity);
+    size_t got;
+    while ((got = fread(text + size, 1, capacity - size, in)) > 0) {
+        size += got;
+        if (size == capacity) {
+            capacity *= 2;
+            text = (char*)realloc(text, capacity);
+        }
+    }
+    bool ok = !ferror(in);
+    fclose(in);
+
+    if (ok) ok = verifyClaims(q, text, size, reportPath, summary);
+    free(text);
+    return ok;
+}
@@ -0,0 +1,232 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "enhanced_ds.h"
+
+// ==========================================================
+//   CO-PREFERENCE MATRIX
+//
+//   Weight (a, b) counts the queued students who list program b
+//   right after program a, i.e. the students who move on to b
+//   when a is full. Lists are added when a student is enqueued,
+//   and an edit takes the old list off before adding the new
+//   one, so the weights always match the lists as they stand.
+//   Up to COPREF_DENSE_PROGRAMS programs the weights are one
+//   dense matrix and a flow lookup is a single load; a larger
+//   catalog keeps a growable run of nonzero edges per row.
+//   Each row caches its COPREF_TOP heaviest successors and only
+//   takes them again after the row has changed.
+// ==========================================================
+
+static void matrixInit(CoPreferenceMatrix* m, int programs) {
+    m->programs = programs;
+    if (programs <= COPREF_DENSE_PROGRAMS)
+        m->dense = (uint32_t*)calloc((size_t)programs * programs, sizeof(uint32_t));
+    else
+        m->rows = (CoPrefRow*)calloc(programs, sizeof(CoPrefRow));
+    m->outflow = (uint64_t*)calloc(programs, sizeof(uint64_t));
+    m->inflow = (uint64_t*)calloc(programs, sizeof(uint64_t));
+    m->first_choice = (uint32_t*)calloc(programs, sizeof(uint32_t));
+    m->top = (uint16_t*)malloc((size_t)programs * COPREF_TOP * sizeof(uint16_t));
+    m->top_count = (uint8_t*)calloc(programs, 1);
+    m->top_stale = (uint8_t*)malloc(programs);
+    memset(m->top_stale, 1, programs);
+}
+
+void coPreferenceRelease(CoPreferenceMatrix* m) {
+    if (m->rows != NULL)
+        for (int p = 0; p < m->programs; p++)
+            free(m->rows[p].edges);
+    free(m->rows);
+    free(m->dense);
+    free(m->outflow);
+    free(m->inflow);
+    free(m->first_choice);
+    free(m->top);
+    free(m->top_count);
+    free(m->top_stale);
+    memset(m, 0, sizeof(*m));
+}
+
+static void addEdge(CoPreferenceMatrix* m, int from, int to, int delta) {
+    if (m->dense != NULL) {
+        m->dense[(size_t)from * m->programs + to] += delta;
+    } else {
+        CoPrefRow* row = &m->rows[from];
+        int i = 0;
+        while (i < row->count && row->edges[i].program != to) i++;
+        if (i == row->count) {
+            if (row->count == row->capacity) {
+                row->capacity = row->capacity ? row->capacity * 2 : 4;
+                row->edges = (CoPrefEdge*)realloc(row->edges, row->capacity * sizeof(CoPrefEdge));
+            }
+            row->edges[row->count].program = (uint16_t)to;
+            row->edges[row->count].weight = 0;
+            row->count++;
+        }
+        row->edges[i].weight += delta;
+        if (row->edges[i].weight == 0)
+            row->edges[i] = row->edges[--row->count];
+    }
+    m->outflow[from] += delta;
+    m->inflow[to] += delta;
+    m->top_stale[from] = 1;
+}
+
+static void addList(CoPreferenceMatrix* m, const uint16_t* ids, int count, int delta) {
+    if (count == 0) return;
+    m->first_choice[ids[0]] += delta;
+    for (int i = 1; i < count; i++)
+        addEdge(m, ids[i - 1], ids[i], delta);
+}
+
+// Called by createQueue, once the catalog is known
+CoPreferenceMatrix* coPreferenceCreate(void) {
+    CoPreferenceMatrix* m = (CoPreferenceMatrix*)calloc(1, sizeof(CoPreferenceMatrix));
+    if (programCount > 0)
+        matrixInit(m, programCount);
+    else
+        m->pending = true;
+    return m;
+}
+
+// A session loaded from a snapshot, or one whose catalog changed after the
+// queue was made, builds the matrix from the queue on first use
+static CoPreferenceMatrix* ensureMatrix(Queue* q) {
+    CoPreferenceMatrix* m = q->co_preferences;
+    if (!m->pending && m->programs == programCount) return m;
+    coPreferenceRelease(m);
+    matrixInit(m, programCount);
+    m->pending = false;
+    for (StudentId s = q->front; s != NO_STUDENT; s = q->students.next[s])
+        addList(m, STUDENT_PREFS(q, s), q->students.num_preferences[s], 1);
+    return m;
+}
+
+// delta is +1 when a queued student's list is added, -1 when it is taken off
+void notePreferenceList(Queue* q, const uint16_t* ids, int count, int delta) {
+    CoPreferenceMatrix* m = q->co_preferences;
+    if (m->programs != programCount) m->pending = true;
+    if (m->pending) return;  // Picked up when the matrix is built
+    addList(m, ids, count, delta);
+}
+
+uint32_t preferenceFlow(Queue* q, int from, int to) {
+    CoPreferenceMatrix* m = ensureMatrix(q);
+    if (from < 0 || from >= m->programs || to < 0 || to >= m->programs) return 0;
+    if (m->dense != NULL)
+        return m->dense[(size_t)from * m->programs + to];
+    const CoPrefRow* row = &m->rows[from];
+    for (int i = 0; i < row->count; i++)
+        if (row->edges[i].program == to) return row->edges[i].weight;
+    return 0;
+}
+
+// Keeps list sorted by weight, heaviest first, ties to the lower program
+static void offerTop(uint16_t* list, uint32_t* weights, int* count, int program, uint32_t weight) {
+    if (weight == 0) return;
+    if (*count == COPREF_TOP && (weight < weights[COPREF_TOP - 1] ||
+                                 (weight == weights[COPREF_TOP - 1] && program > list[COPREF_TOP - 1])))
+        return;
+    int i = (*count < COPREF_TOP) ? (*count)++ : COPREF_TOP - 1;
+    while (i > 0 && (weights[i - 1] < weight || (weights[i - 1] == weight && list[i - 1] > program))) {
+        list[i] = list[i - 1];
+        weights[i] = weights[i - 1];
+        i--;
+    }
+    list[i] = (uint16_t)program;
+    weights[i] = weight;
+}
+
+// Programs most often listed right after program, heaviest first; fills up
+// to COPREF_TOP entries and returns how many
+int topCoPreferred(Queue* q, int program, uint16_t* out, uint32_t* weights) {
+    CoPreferenceMatrix* m = ensureMatrix(q);
+    if (program < 0 || program >= m->programs) return 0;
+    uint16_t* top = m->top + (size_t)program * COPREF_TOP;
+
+    if (m->top_stale[program]) {
+        uint32_t w[COPREF_TOP];
+        int count = 0;
+        if (m->dense != NULL) {
+            const uint32_t* row = m->dense + (size_t)program * m->programs;
+            for (int p = 0; p < m->programs; p++)
+                offerTop(top, w, &count, p, row[p]);
+        } else {
+            const CoPrefRow* row = &m->rows[program];
+            for (int i = 0; i < row->count; i++)
+                offerTop(top, w, &count, row->edges[i].program, row->edges[i].weight);
+        }
+        m->top_count[program] = (uint8_t)count;
+        m->top_stale[program] = 0;
+    }
+
+    int count = m->top_count[program];
+    for (int i = 0; i < count; i++) {
+        out[i] = top[i];
+        weights[i] = preferenceFlow(q, program, top[i]);
+    }
+    return count;
+}
+
+void coPreferenceReport(Queue* q) {
+    const CoPreferenceMatrix* m = q->co_preferences;
+    if (m->programs == 0 || m->pending) {
+        printf("Co-preference matrix: not built\n");
+        return;
+    }
+    size_t bytes = (size_t)m->programs * (2 * sizeof(uint64_t) + sizeof(uint32_t) +
+                                          COPREF_TOP * sizeof(uint16_t) + 2);
+    long edges = 0;
+    if (m->dense != NULL) {
+        bytes += (size_t)m->programs * m->programs * sizeof(uint32_t);
+    } else {
+        for (int p = 0; p < m->programs; p++) {
+            edges += m->rows[p].count;
+            bytes += m->rows[p].capacity * sizeof(CoPrefEdge);
+        }
+    }
+    if (m->dense != NULL)
+        printf("Co-preference matrix: dense %d x %d (%.1f KB)\n", m->programs, m->programs, bytes / 1024.0);
+    else
+        printf("Co-preference matrix: %ld edges over %d rows (%.1f KB)\n", edges, m->programs, bytes / 1024.0);
+}
+
+void preferenceFlowMenu(Queue* q) {
+    if (programCount == 0) return;
+    printf("\n%sPreference Flow%s\n", COLOR_BLUE, COLOR_RESET);
+    printf("===============\n");
+    for (int p = 0; p < programCount; p++)
+        printf("%d. %s - %s\n", p + 1, programCollegeName(p), programBranchName(p));
+    printf("\nEnter Choice: ");
+
+    int choice;
+    int scanResult = scanf("%d", &choice);
+    while (getchar() != '\n');
+    if (scanResult != 1 || choice < 1 || choice > programCount) {
+        printf("%sError: Please enter a choice between 1 and %d!%s\n", COLOR_RED, programCount, COLOR_RESET);
+        return;
+    }
+
+    int program = choice - 1;
+    CoPreferenceMatrix* m = ensureMatrix(q);
+    printf("\n%s%s - %s%s\n", COLOR_GREEN, programCollegeName(program), programBranchName(program), COLOR_RESET);
+    printf("First choice of : %u student(s)\n", m->first_choice[program]);
+    printf("Reached from    : %llu list(s), as the next choice after another program\n",
+           (unsigned long long)m->inflow[program]);
+    printf("Followed by     : %llu list(s)\n", (unsigned long long)m->outflow[program]);
+
+    uint16_t top[COPREF_TOP];
+    uint32_t weights[COPREF_TOP];
+    int count = topCoPreferred(q, program, top, weights);
+    if (count == 0) {
+        printf("\n%sNo student lists another program after this one.%s\n", COLOR_YELLOW, COLOR_RESET);
+        return;
+    }
+    printf("\nNext choices of students who list it:\n");
+    for (int i = 0; i < count; i++) {
+        printf("%d. %s - %s: %u student(s) (%.1f%%)\n", top[i] + 1,
+               programCollegeName(top[i]), programBranchName(top[i]), weights[i],
+               100.0 * weights[i] / m->outflow[program]);
+    }
+}
@@ -0,0 +1,372 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "enhanced_ds.h"
+
+// ==========================================================
+//   CUTOFF INDEX
+//
+//   Built from the allotment when an allocation pass ends. A
+//   slot is one (program, pool) pair, numbered like the seat
+//   pool arrays (pool * programCount + program). Each slot owns
+//   a region of the holders array as long as its capacity and
+//   keeps the ranks holding its seats there in ascending order,
+//   so its closing rank is the last entry and the seats left at
+//   rank R are the capacity minus the holders ranked before R.
+//   Every slot also sits in one list sorted by the rank that
+//   took its last seat (CUTOFF_OPEN while seats remain); a
+//   program is reachable at rank R exactly when one of its
+//   slots is at or past R in that list.
+//
+//   Edits and counselling rounds move single students; their
+//   moves are queued with noteCutoffMove and applied together
+//   by applyCutoffMoves, removals first, so a slot never holds
+//   more ranks than seats while a pass is half applied.
+// ==========================================================
+
+typedef struct {
+    int rank;  // Rank that took the slot's last seat, CUTOFF_OPEN if seats remain
+    int slot;
+} ExhaustionPoint;
+
+typedef struct {
+    int rank;
+    int from;  // Slot given up, -1 if none
+    int to;    // Slot taken, -1 if none
+} CutoffMove;
+
+struct CutoffTable {
+    int slots;                // programCount * seatPoolCount
+    int pools;
+    int* held;                // Seats taken per slot
+    size_t* start;            // slots + 1 region offsets into ranks
+    int* ranks;               // Holder ranks, ascending within a slot
+    ExhaustionPoint* points;  // One per slot, by (rank, slot)
+    CutoffMove* moves;        // Queued by noteCutoffMove
+    int move_count;
+    int move_capacity;
+};
+
+static int slotOf(int program_id, int pool) {
+    return program_id < 0 ? -1 : pool * programCount + program_id;
+}
+
+static int slotCapacity(const CutoffTable* table, int slot) {
+    return (int)(table->start[slot + 1] - table->start[slot]);
+}
+
+// Rank that took the slot's last seat; a slot without seats is never open
+static int exhaustionKey(const CutoffTable* table, int slot) {
+    int capacity = slotCapacity(table, slot);
+    if (table->held[slot] < capacity) return CUTOFF_OPEN;
+    return capacity == 0 ? 0 : table->ranks[table->start[slot] + capacity - 1];
+}
+
+static int comparePoints(const void* a, const void* b) {
+    const ExhaustionPoint* x = (const ExhaustionPoint*)a;
+    const ExhaustionPoint* y = (const ExhaustionPoint*)b;
+    if (x->rank != y->rank) return (x->rank < y->rank) ? -1 : 1;
+    return (x->slot > y->slot) - (x->slot < y->slot);
+}
+
+// First point not ordered before (rank, slot)
+static int pointLowerBound(const CutoffTable* table, int rank, int slot) {
+    int lo = 0, hi = table->slots;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        const ExhaustionPoint* p = &table->points[mid];
+        if (p->rank < rank || (p->rank == rank && p->slot < slot)) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// First holder of the slot ranked at or after rank
+static int holderLowerBound(const CutoffTable* table, int slot, int rank) {
+    const int* ranks = table->ranks + table->start[slot];
+    int lo = 0, hi = table->held[slot];
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (ranks[mid] < rank) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// Moves the slot's point from oldKey to its current key
+static void repositionPoint(CutoffTable* table, int slot, int oldKey) {
+    int newKey = exhaustionKey(table, slot);
+    if (newKey == oldKey) return;
+
+    ExhaustionPoint* points = table->points;
+    int from = pointLowerBound(table, oldKey, slot);
+    int to = pointLowerBound(table, newKey, slot);
+    if (to > from) {
+        to--;  // The point itself leaves the range it moves over
+        memmove(points + from, points + from + 1, (size_t)(to - from) * sizeof(ExhaustionPoint));
+    } else {
+        memmove(points + to + 1, points + to, (size_t)(from - to) * sizeof(ExhaustionPoint));
+    }
+    points[to].rank = newKey;
+    points[to].slot = slot;
+}
+
+static void removeHolder(CutoffTable* table, int slot, int rank) {
+    int oldKey = exhaustionKey(table, slot);
+    int* ranks = table->ranks + table->start[slot];
+    int at = holderLowerBound(table, slot, rank);
+    if (at == table->held[slot] || ranks[at] != rank) return;
+    memmove(ranks + at, ranks + at + 1, (size_t)(table->held[slot] - at - 1) * sizeof(int));
+    table->held[slot]--;
+    repositionPoint(table, slot, oldKey);
+}
+
+static void insertHolder(CutoffTable* table, int slot, int rank) {
+    if (table->held[slot] == slotCapacity(table, slot)) return;  // Not a seat this slot has
+    int oldKey = exhaustionKey(table, slot);
+    int* ranks = table->ranks + table->start[slot];
+    int at = holderLowerBound(table, slot, rank);
+    memmove(ranks + at + 1, ranks + at, (size_t)(table->held[slot] - at) * sizeof(int));
+    ranks[at] = rank;
+    table->held[slot]++;
+    repositionPoint(table, slot, oldKey);
+}
+
+void releaseCutoffs(CutoffTable* table) {
+    if (table == NULL) return;
+    free(table->held);
+    free(table->start);
+    free(table->ranks);
+    free(table->points);
+    free(table->moves);
+    free(table);
+}
+
+// Rebuilds the index from the students' current results. The queue is in
+// rank order, so appending each holder keeps every slot sorted.
+void buildCutoffs(Queue* q) {
+    releaseCutoffs(q->allocation->cutoffs);
+    CutoffTable* table = (CutoffTable*)calloc(1, sizeof(CutoffTable));
+    table->pools = seatPoolCount;
+    table->slots = programCount * seatPoolCount;
+    table->held = (int*)calloc(table->slots, sizeof(int));
+    table->start = (size_t*)malloc((table->slots + 1) * sizeof(size_t));
+    table->points = (ExhaustionPoint*)malloc(table->slots * sizeof(ExhaustionPoint));
+
+    const int* capacity = (seatPoolCount > 1) ? poolCapacity : programCapacity;
+    table->start[0] = 0;
+    for (int slot = 0; slot < table->slots; slot++)
+        table->start[slot + 1] = table->start[slot] + (capacity[slot] > 0 ? capacity[slot] : 0);
+    table->ranks = (int*)malloc((table->start[table->slots] ? table->start[table->slots] : 1) * sizeof(int));
+
+    const StudentStore* store = &q->students;
+    for (StudentId s = q->front; s != NO_STUDENT; s = store->next[s]) {
+        int slot = slotOf(store->allocated_program[s], store->allocated_pool[s]);
+        if (slot < 0 || table->held[slot] == slotCapacity(table, slot)) continue;
+        table->ranks[table->start[slot] + table->held[slot]++] = store->rank[s];
+    }
+
+    for (int slot = 0; slot < table->slots; slot++) {
+        table->points[slot].rank = exhaustionKey(table, slot);
+        table->points[slot].slot = slot;
+    }
+    qsort(table->points, table->slots, sizeof(ExhaustionPoint), comparePoints);
+    q->allocation->cutoffs = table;
+}
+
+// Queues a change of one student's seat; pool is ignored for programs
+// that are not allocated
+void noteCutoffMove(Queue* q, int rank, int fromProgram, int fromPool, int toProgram, int toPool) {
+    CutoffTable* table = q->allocation->cutoffs;
+    if (table == NULL) return;
+    if (table->move_count == table->move_capacity) {
+        table->move_capacity = table->move_capacity ? table->move_capacity * 2 : 64;
+        table->moves = (CutoffMove*)realloc(table->moves, table->move_capacity * sizeof(CutoffMove));
+    }
+    CutoffMove* move = &table->moves[table->move_count++];
+    move->rank = rank;
+    move->from = slotOf(fromProgram, fromPool);
+    move->to = slotOf(toProgram, toPool);
+}
+
+void applyCutoffMoves(Queue* q) {
+    CutoffTable* table = q->allocation->cutoffs;
+    if (table == NULL) return;
+    for (int i = 0; i < table->move_count; i++)
+        if (table->moves[i].from >= 0)
+            removeHolder(table, table->moves[i].from, table->moves[i].rank);
+    for (int i = 0; i < table->move_count; i++)
+        if (table->moves[i].to >= 0)
+            insertHolder(table, table->moves[i].to, table->moves[i].rank);
+    table->move_count = 0;
+}
+
+// Worst rank holding a seat of the program in any of the given pools,
+// 0 if none does
+int closingRank(const CutoffTable* table, int program_id, uint8_t categories) {
+    int closing = 0;
+    for (int k = 0; k < table->pools; k++) {
+        if (!(categories & (1u << k))) continue;
+        int slot = k * programCount + program_id;
+        if (table->held[slot] > 0) {
+            int last = table->ranks[table->start[slot] + table->held[slot] - 1];
+            if (last > closing) closing = last;
+        }
+    }
+    return closing;
+}
+
+// Rank after which no seat of the program is left in the given pools, or
+// CUTOFF_OPEN if one is still free
+int exhaustionRank(const CutoffTable* table, int program_id, uint8_t categories) {
+    int exhausted = 0;
+    for (int k = 0; k < table->pools; k++) {
+        if (!(categories & (1u << k))) continue;
+        int key = exhaustionKey(table, k * programCount + program_id);
+        if (key > exhausted) exhausted = key;
+    }
+    return exhausted;
+}
+
+// Seats of the program in the given pools that were still free when the
+// student ranked rank was placed (or would have been, for an unused rank)
+int seatsLeftAtRank(const CutoffTable* table, int program_id, uint8_t categories, int rank) {
+    int left = 0;
+    for (int k = 0; k < table->pools; k++) {
+        if (!(categories & (1u << k))) continue;
+        int slot = k * programCount + program_id;
+        left += slotCapacity(table, slot) - holderLowerBound(table, slot, rank);
+    }
+    return left;
+}
+
+static int compareProgramIds(const void* a, const void* b) {
+    return (int)*(const uint16_t*)a - (int)*(const uint16_t*)b;
+}
+
+// Programs with a seat free at rank in one of the given pools, written to
+// out (programCount entries) by id. Returns how many there are.
+int reachablePrograms(const CutoffTable* table, int rank, uint8_t categories, uint16_t* out) {
+    int count = 0;
+    for (int i = pointLowerBound(table, rank, 0); i < table->slots; i++) {
+        int slot = table->points[i].slot;
+        int pool = slot / programCount;
+        int program_id = slot % programCount;
+        if (!(categories & (1u << pool))) continue;
+
+        // A program open in several pools is listed by the first of them
+        bool listed = false;
+        for (int k = 0; k < pool && !listed; k++)
+            listed = (categories & (1u << k)) &&
+                     exhaustionKey(table, k * programCount + program_id) >= rank;
+        if (!listed) out[count++] = (uint16_t)program_id;
+    }
+    qsort(out, count, sizeof(uint16_t), compareProgramIds);
+    return count;
+}
+
+// One pool of one program as the cutoff export has it: closing_rank is 0
+// while the slot holds nobody, exhausted_at is CUTOFF_OPEN while seats
+// remain and 0 for a slot without seats
+void cutoffSlotInfo(const CutoffTable* table, int program_id, int pool, CutoffSlotInfo* info) {
+    int slot = pool * programCount + program_id;
+    info->seats = slotCapacity(table, slot);
+    info->filled = table->held[slot];
+    info->closing_rank = info->filled > 0 ? table->ranks[table->start[slot] + info->filled - 1] : 0;
+    info->exhausted_at = exhaustionKey(table, slot);
+}
+
+// Shown as "-" when a program never filled or was never taken
+static void printRankCell(int rank, int width) {
+    if (rank <= 0 || rank == CUTOFF_OPEN) printf(" %*s", width, "-");
+    else printf(" %*d", width, rank);
+}
+
+static void displayCutoffs(const CutoffTable* table) {
+    uint8_t all = (uint8_t)((1u << table->pools) - 1);
+    printf("\n%sClosing Ranks%s\n", COLOR_BLUE, COLOR_RESET);
+    printf("%-6s %-40s %-8s %7s %7s %10s %10s\n",
+           "Choice", "College", "Branch", "Seats", "Filled", "Closing", "Full at");
+    printf("---------------------------------------------------------------------------------------------\n");
+    for (int p = 0; p < programCount; p++) {
+        int seats = 0, filled = 0;
+        for (int k = 0; k < table->pools; k++) {
+            seats += slotCapacity(table, k * programCount + p);
+            filled += table->held[k * programCount + p];
+        }
+        printf("%-6d %-40.40s %-8.8s %7d %7d", p + 1, programCollegeName(p),
+               programBranchName(p), seats, filled);
+        printRankCell(closingRank(table, p, all), 10);
+        printRankCell(exhaustionRank(table, p, all), 10);
+        printf("\n");
+    }
+}
+
+// Reads the pool list for a query; returns false on an unknown pool name
+static bool inputQueryPools(uint8_t* categories) {
+    *categories = POOL_GENERAL;
+    if (seatPoolCount == 1) return true;
+    printf("Seat pools besides %s, comma separated, blank for none: ", seatPoolNames[0]);
+    char line[128];
+    if (fgets(line, sizeof(line), stdin) == NULL) return true;
+    if (parsePoolList(line, categories)) return true;
+    printf("%sError: Unknown seat pool.%s\n", COLOR_RED, COLOR_RESET);
+    return false;
+}
+
+static void queryRank(const CutoffTable* table) {
+    int rank;
+    printf("Enter Rank: ");
+    int scanResult = scanf("%d", &rank);
+    while (getchar() != '\n');
+    if (scanResult != 1 || rank < 1) {
+        printf("%sError: Please enter a valid rank number!%s\n", COLOR_RED, COLOR_RESET);
+        return;
+    }
+    uint8_t categories;
+    if (!inputQueryPools(&categories)) return;
+
+    uint16_t* reachable = (uint16_t*)malloc(programCount * sizeof(uint16_t));
+    int count = reachablePrograms(table, rank, categories, reachable);
+    printf("\n%s%d program(s) still had a seat at rank %d:%s\n", COLOR_GREEN, count, rank, COLOR_RESET);
+    for (int i = 0; i < count; i++) {
+        int p = reachable[i];
+        printf("%d. %s - %s (%d seat(s) left)\n", p + 1, programCollegeName(p),
+               programBranchName(p), seatsLeftAtRank(table, p, categories, rank));
+    }
+    free(reachable);
+}
+
+void cutoffMenu(Queue* q) {
+    while (1) {
+        const CutoffTable* table = q->allocation->cutoffs;
+        if (table == NULL) {
+            printf("\n%sNo seat allotment yet: run the allocation first.%s\n", COLOR_YELLOW, COLOR_RESET);
+            return;
+        }
+        printf("\n%s=== Cutoffs ===%s\n", COLOR_YELLOW, COLOR_RESET);
+        printf("1. Show Closing Ranks\n");
+        printf("2. Programs Open at a Rank\n");
+        printf("3. Back\n\n");
+        printf("Enter your choice: ");
+
+        int choice;
+        int scanResult = scanf("%d", &choice);
+        while (getchar() != '\n');
+        if (scanResult != 1) continue;
+
+        switch (choice) {
+            case 1:
+                displayCutoffs(table);
+                break;
+            case 2:
+                queryRank(table);
+                break;
+            case 3:
+                return;
+            default:
+                printf("\n%sInvalid choice! Please enter a number between 1 and 3.%s\n",
+                       COLOR_RED, COLOR_RESET);
+        }
+    }
+}
@@ -0,0 +1,383 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "enhanced_ds.h"
+
+// ==========================================================
+//   DEFERRED ACCEPTANCE
+//
+//   Student-proposing deferred acceptance over the options
+//   serial dictatorship uses: (program, pool) pairs,
+//   preferences in order and, for one program, pools in
+//   catalog order. Every option is a seat slot that holds up
+//   to its capacity of candidates in a max-heap on priority,
+//   so the weakest holder is on top. A free student proposes
+//   to their next option; the slot keeps them if it has room
+//   or if they beat the top, which then goes to the back of
+//   the work queue and proposes again from where it left off.
+//   Each proposal is one heap step, so a run is O(proposals x
+//   log capacity). The outcome is the stable matching that
+//   every student likes best, whatever order the queue is
+//   worked in. Students start in rank order, so with no
+//   priorities loaded nobody is ever displaced and the outcome
+//   is the serial one.
+// ==========================================================
+
+#define PRIORITY_MAX_LINE     256
+#define PRIORITY_MAX_REPORTED 20
+#define PRIORITY_UNLISTED     UINT32_MAX  // After every listed student
+
+typedef struct {
+    StudentId student;
+    uint32_t priority;
+} PriorityEntry;
+
+struct CollegePriorities {
+    int slots;               // seatPoolCount x programCount when loaded
+    size_t* start;           // Slot i owns entries[start[i] .. start[i + 1])
+    PriorityEntry* entries;  // By student within a slot
+};
+
+typedef struct {
+    int slot;
+    StudentId student;
+    uint32_t priority;
+} PriorityLine;
+
+// Lower keys are better: priority, then global rank
+typedef struct {
+    uint64_t key;
+    StudentId student;
+} HeldSeat;
+
+static AllocationEngine engine = ALLOCATION_SERIAL;
+
+void setAllocationEngine(AllocationEngine next) {
+    engine = next;
+}
+
+AllocationEngine currentAllocationEngine(void) {
+    return engine;
+}
+
+bool parseAllocationEngine(const char* text, AllocationEngine* out) {
+    if (strcasecmp(text, "serial") == 0) *out = ALLOCATION_SERIAL;
+    else if (strcasecmp(text, "deferred") == 0) *out = ALLOCATION_DEFERRED;
+    else return false;
+    return true;
+}
+
+const char* allocationEngineName(AllocationEngine e) {
+    return (e == ALLOCATION_DEFERRED) ? "deferred" : "serial";
+}
+
+static int comparePriorityLines(const void* a, const void* b) {
+    const PriorityLine* x = (const PriorityLine*)a;
+    const PriorityLine* y = (const PriorityLine*)b;
+    if (x->slot != y->slot) return x->slot < y->slot ? -1 : 1;
+    if (x->student != y->student) return x->student < y->student ? -1 : 1;
+    return (x->priority > y->priority) - (x->priority < y->priority);
+}
+
+void releaseCollegePriorities(CollegePriorities* priorities) {
+    if (priorities == NULL) return;
+    free(priorities->start);
+    free(priorities->entries);
+    free(priorities);
+}
+
+// Reads one priority line into lines; returns the reason it was refused
+static const char* addPriorityLine(char* line, PriorityLine** lines, long* count, long* capacity) {
+    char* fields[4];
+    char delim = (strchr(line, '\t') != NULL) ? '\t' : ',';
+    int fieldCount = splitFields(line, delim, fields, 4);
+    int choice, priority;
+    if (fieldCount < 3 || fieldCount > 4)
+        return "expected reg_number,choice,priority[,pool]";
+    StudentId student = findStudentByReg(fields[0]);
+    if (student == NO_STUDENT)
+        return "unknown registration number";
+    if (!parseRank(fields[1], &choice) || choice > programCount)
+        return "choice is not a program";
+    if (!parseRank(fields[2], &priority))
+        return "priority must be a positive number";
+
+    int firstPool = 0, lastPool = seatPoolCount - 1;
+    if (fieldCount == 4 && fields[3][0] != '\0') {
+        int k = 0;
+        while (k < seatPoolCount && strcasecmp(seatPoolNames[k], fields[3]) != 0) k++;
+        if (k == seatPoolCount) return "unknown seat pool";
+        firstPool = lastPool = k;
+    }
+
+    for (int k = firstPool; k <= lastPool; k++) {
+        if (*count == *capacity) {
+            *capacity *= 2;
+            *lines = (PriorityLine*)realloc(*lines, *capacity * sizeof(PriorityLine));
+        }
+        PriorityLine* entry = &(*lines)[(*count)++];
+        entry->slot = k * programCount + (choice - 1);
+        entry->student = student;
+        entry->priority = (uint32_t)priority;
+    }
+    return NULL;
+}
+
+// Replaces the queue's priorities with those in path. A student listed
+// twice for one seat keeps the better priority. Returns false only if the
+// file cannot be read.
+bool loadCollegePriorities(Queue* q, const char* path, long* loaded, long* rejected) {
+    FILE* in = fopen(path, "r");
+    if (in == NULL) return false;
+
+    long count = 0, capacity = 1024;
+    PriorityLine* lines = (PriorityLine*)malloc(capacity * sizeof(PriorityLine));
+    char line[PRIORITY_MAX_LINE];
+    long lineNo = 0;
+    bool firstRecord = true;
+    *loaded = *rejected = 0;
+    while (fgets(line, sizeof(line), in) != NULL) {
+        lineNo++;
+        size_t length = strlen(line);
+        const char* error = NULL;
+        if (length == sizeof(line) - 1 && line[length - 1] != '\n') {
+            int c;
+            while ((c = fgetc(in)) != EOF && c != '\n');
+            error = "line too long";
+        } else {
+            line[strcspn(line, "\r\n")] = '\0';
+            char* p = line;
+            while (*p == ' ' || *p == '\t') p++;
+            if (*p == '\0' || *p == '#') continue;
+
+            // A first line whose priority is not a number is a header
+            if (firstRecord) {
+                firstRecord = false;
+                char copy[PRIORITY_MAX_LINE];
+                char* fields[4];
+                int priority;
+                strcpy(copy, line);
+                int fieldCount = splitFields(copy, (strchr(copy, '\t') != NULL) ? '\t' : ',', fields, 4);
+                if (fieldCount >= 3 && fieldCount <= 4 && !parseRank(fields[2], &priority)) continue;
+            }
+            error = addPriorityLine(line, &lines, &count, &capacity);
+        }
+        if (error != NULL) {
+            if (*rejected < PRIORITY_MAX_REPORTED)
+                fprintf(stderr, "%sPriority line %ld rejected: %s%s\n", COLOR_RED, lineNo, error, COLOR_RESET);
+            (*rejected)++;
+            continue;
+        }
+        (*loaded)++;
+    }
+    fclose(in);
+    if (*rejected > PRIORITY_MAX_REPORTED)
+        fprintf(stderr, "%s... %ld more priority lines rejected%s\n",
+                COLOR_RED, *rejected - PRIORITY_MAX_REPORTED, COLOR_RESET);
+
+    qsort(lines, count, sizeof(PriorityLine), comparePriorityLines);
+    CollegePriorities* priorities = (CollegePriorities*)calloc(1, sizeof(CollegePriorities));
+    priorities->slots = seatPoolCount * programCount;
+    priorities->start = (size_t*)calloc(priorities->slots + 1, sizeof(size_t));
+    priorities->entries = (PriorityEntry*)malloc((count ? count : 1) * sizeof(PriorityEntry));
+    size_t kept = 0;
+    for (long i = 0; i < count; i++) {
+        if (i > 0 && lines[i].slot == lines[i - 1].slot && lines[i].student == lines[i - 1].student)
+            continue;
+        priorities->entries[kept].student = lines[i].student;
+        priorities->entries[kept].priority = lines[i].priority;
+        priorities->start[lines[i].slot + 1]++;
+        kept++;
+    }
+    for (int slot = 0; slot < priorities->slots; slot++)
+        priorities->start[slot + 1] += priorities->start[slot];
+    free(lines);
+
+    releaseCollegePriorities(q->priorities);
+    q->priorities = priorities;
+    q->allocation->valid = false;
+    return true;
+}
+
+static uint64_t priorityKey(const CollegePriorities* priorities, int slot, StudentId student, int rank) {
+    uint32_t priority = PRIORITY_UNLISTED;
+    if (priorities != NULL) {
+        size_t lo = priorities->start[slot], hi = priorities->start[slot + 1];
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (priorities->entries[mid].student < student) lo = mid + 1;
+            else hi = mid;
+        }
+        if (lo < priorities->start[slot + 1] && priorities->entries[lo].student == student)
+            priority = priorities->entries[lo].priority;
+    }
+    return ((uint64_t)priority << 32) | (uint32_t)rank;
+}
+
+static void heapPush(HeldSeat* heap, int* size, uint64_t key, StudentId student) {
+    int i = (*size)++;
+    while (i > 0 && heap[(i - 1) / 2].key < key) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i].key = key;
+    heap[i].student = student;
+}
+
+// Puts a new holder in place of the weakest one
+static void heapReplaceTop(HeldSeat* heap, int size, uint64_t key, StudentId student) {
+    int i = 0;
+    while (1) {
+        int child = 2 * i + 1;
+        if (child >= size) break;
+        if (child + 1 < size && heap[child + 1].key > heap[child].key) child++;
+        if (heap[child].key <= key) break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i].key = key;
+    heap[i].student = student;
+}
+
+// Allocates every queued student by deferred acceptance and leaves the
+// seats left in programSeats and, with seat pools, poolSeats
+void allocateDeferred(Queue* q, DeferredStats* stats) {
+    double t0 = monotonicSeconds();
+    StudentStore* store = &q->students;
+    int pools = seatPoolCount;
+    int slots = pools * programCount;
+    const int* capacity = (pools > 1) ? poolCapacity : programCapacity;
+    const CollegePriorities* priorities = q->priorities;
+    if (priorities != NULL && priorities->slots != slots) priorities = NULL;  // Catalog changed
+    memset(stats, 0, sizeof(*stats));
+
+    // The pooled serial state would not describe this allotment
+    releaseSeatPools(q->allocation->pools);
+    q->allocation->pools = NULL;
+
+    size_t* start = (size_t*)malloc((slots + 1) * sizeof(size_t));
+    start[0] = 0;
+    for (int slot = 0; slot < slots; slot++)
+        start[slot + 1] = start[slot] + (capacity[slot] > 0 ? capacity[slot] : 0);
+    HeldSeat* held = (HeldSeat*)malloc((start[slots] ? start[slots] : 1) * sizeof(HeldSeat));
+    int* size = (int*)calloc(slots ? slots : 1, sizeof(int));
+
+    size_t students = store->count ? store->count : 1;
+    uint32_t* cursor = (uint32_t*)calloc(students, sizeof(uint32_t));  // Next option
+    uint32_t* tried = (uint32_t*)calloc(students, sizeof(uint32_t));   // Proposals made
+    StudentId* work = (StudentId*)malloc(students * sizeof(StudentId));
+    long head = 0, tail = 0, pending = 0;
+
+    for (StudentId s = q->front; s != NO_STUDENT; s = store->next[s]) {
+        store->allocated_pool[s] = 0;
+        if (!(store->flags[s] & STUDENT_VERIFIED)) {
+            store->allocated_program[s] = PROGRAM_NOT_ELIGIBLE;
+            continue;
+        }
+        store->allocated_program[s] = PROGRAM_NOT_ALLOCATED;
+        store->categories[s] |= POOL_GENERAL;
+        work[tail++] = s;
+    }
+    stats->proposers = pending = tail;
+    long ring = tail ? tail : 1;  // Nobody is queued twice, so the ring never overflows
+    tail %= ring;
+
+    while (pending > 0) {
+        StudentId s = work[head];
+        head = (head + 1) % ring;
+        pending--;
+
+        const uint16_t* prefs = STUDENT_PREFS(q, s);
+        uint32_t options = (uint32_t)store->num_preferences[s] * pools;
+        int rank = store->rank[s];
+        while (cursor[s] < options) {
+            uint32_t option = cursor[s]++;
+            int k = option % pools;
+            if (!(store->categories[s] & (1u << k))) continue;
+            int slot = k * programCount + prefs[option / pools];
+            if (capacity[slot] <= 0) continue;
+
+            tried[s]++;
+            uint64_t key = priorityKey(priorities, slot, s, rank);
+            HeldSeat* heap = held + start[slot];
+            if (size[slot] < capacity[slot]) {
+                heapPush(heap, &size[slot], key, s);
+                break;
+            }
+            stats->rejections++;
+            if (key < heap[0].key) {
+                // The weakest holder goes back to the queue
+                work[tail] = heap[0].student;
+                tail = (tail + 1) % ring;
+                pending++;
+                stats->displaced++;
+                heapReplaceTop(heap, size[slot], key, s);
+                break;
+            }
+        }
+    }
+
+    // Write back the holders and the seats they leave
+    for (int slot = 0; slot < slots; slot++) {
+        const HeldSeat* heap = held + start[slot];
+        for (int i = 0; i < size[slot]; i++) {
+            store->allocated_program[heap[i].student] = slot % programCount;
+            store->allocated_pool[heap[i].student] = (uint8_t)(slot / programCount);
+        }
+    }
+    for (int p = 0; p < programCount; p++) {
+        programSeats[p] = 0;
+        for (int k = 0; k < pools; k++) {
+            int slot = k * programCount + p;
+            if (pools > 1) poolSeats[slot] = capacity[slot] - size[slot];
+            programSeats[p] += capacity[slot] - size[slot];
+        }
+    }
+
+    METRIC_BLOCK(proposalCounts);
+    for (StudentId s = q->front; s != NO_STUDENT; s = store->next[s]) {
+        if (store->flags[s] & STUDENT_VERIFIED)
+            METRIC_BLOCK_RECORD(proposalCounts, tried[s]);
+        stats->proposals += tried[s];
+    }
+    METRIC_BLOCK_MERGE(proposalCounts, METRIC_PROBES_PER_STUDENT);
+    METRIC_ADD(METRIC_PREFERENCE_PROBES, stats->proposals);
+    METRIC_ADD(METRIC_SEATS_EXHAUSTED, stats->rejections);
+    METRIC_ADD(METRIC_DISPLACEMENTS, stats->displaced);
+
+    free(start);
+    free(held);
+    free(size);
+    free(cursor);
+    free(tried);
+    free(work);
+    stats->seconds = monotonicSeconds() - t0;
+}
+
+// Re-runs deferred acceptance after the preferences of one student
+// changed. Any holder may be displaced by the edit, so there is no point
+// to resume from; outcomes that moved are logged. Returns the number of
+// students re-evaluated, or -1 if there is no allotment to update.
+int reallocateDeferred(Queue* q) {
+    AllocationState* state = q->allocation;
+    StudentStore* store = &q->students;
+    if (!state->valid) return -1;
+
+    size_t students = store->count ? store->count : 1;
+    int* previous = (int*)malloc(students * sizeof(int));
+    uint8_t* previousPool = (uint8_t*)malloc(students);
+    memcpy(previous, store->allocated_program, store->count * sizeof(int));
+    memcpy(previousPool, store->allocated_pool, store->count);
+
+    allocateDeferred(q, &state->deferred);
+    for (StudentId s = q->front; s != NO_STUDENT; s = store->next[s])
+        if (store->allocated_program[s] != previous[s] || store->allocated_pool[s] != previousPool[s])
+            logAllocation(q, s);
+    buildCutoffs(q);
+
+    free(previous);
+    free(previousPool);
+    return (int)state->deferred.proposers;
+}
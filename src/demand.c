@@ -0,0 +1,239 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "enhanced_ds.h"
+
+// ==========================================================
+//   DEMAND ANALYTICS
+//
+//   One pass over the student columns gives, for every program,
+//   how often it is listed at each choice position and by which
+//   rank bands, plus the candidates per rank band overall. The
+//   store is cut into id ranges, one per task on the worker
+//   threads, and each task counts into its own block, so the
+//   scan takes no locks and shares no cache lines. A second
+//   parallel pass sums the blocks, each task taking a range of
+//   programs. First-choice oversubscription is first-choice
+//   demand over the program's seats.
+// ==========================================================
+
+#define DEMAND_MIN_TASK_STUDENTS 65536  // Fewer students per task is not worth a thread
+
+// Upper rank of each band; the last one is open-ended
+const int demandBandLimits[DEMAND_RANK_BANDS] = {
+    1000, 5000, 10000, 25000, 50000, 100000, 250000, INT_MAX
+};
+
+static int rankBand(int rank) {
+    int band = 0;
+    while (rank > demandBandLimits[band]) band++;
+    return band;
+}
+
+// Counters of one task, laid out like the report's
+typedef struct {
+    uint32_t* by_position;
+    uint32_t* by_band;
+    long band_candidates[DEMAND_RANK_BANDS];
+    long candidates;
+    long verified;
+    long listed;
+    long no_preferences;
+} DemandCounters;
+
+typedef struct {
+    Queue* q;
+    DemandCounters* counters;
+    int tasks;
+    DemandReport* report;
+} DemandJob;
+
+static void countTask(void* context, int task) {
+    DemandJob* job = (DemandJob*)context;
+    const StudentStore* store = &job->q->students;
+    const uint16_t* pool = job->q->preferences.ids;
+    DemandCounters* c = &job->counters[task];
+    StudentId first = (StudentId)((long)store->count * task / job->tasks);
+    StudentId last = (StudentId)((long)store->count * (task + 1) / job->tasks);
+
+    for (StudentId s = first; s < last; s++) {
+        int rank = store->rank[s];
+        if (rank <= 0) continue;  // Released id
+        int band = rankBand(rank);
+        c->candidates++;
+        c->band_candidates[band]++;
+        c->verified += (store->flags[s] & STUDENT_VERIFIED) != 0;
+
+        int count = store->num_preferences[s];
+        if (count == 0) c->no_preferences++;
+        c->listed += count;
+        const uint16_t* prefs = pool + store->pref_offset[s];
+        for (int i = 0; i < count; i++) {
+            int position = (i < DEMAND_POSITIONS) ? i : DEMAND_POSITIONS - 1;
+            c->by_position[prefs[i] * DEMAND_POSITIONS + position]++;
+            c->by_band[prefs[i] * DEMAND_RANK_BANDS + band]++;
+        }
+    }
+}
+
+// Sums every task's counters for one range of programs
+static void mergeTask(void* context, int task) {
+    DemandJob* job = (DemandJob*)context;
+    DemandReport* r = job->report;
+    int first = (int)((long)r->programs * task / job->tasks);
+    int last = (int)((long)r->programs * (task + 1) / job->tasks);
+    size_t positionsFrom = (size_t)first * DEMAND_POSITIONS, positionsTo = (size_t)last * DEMAND_POSITIONS;
+    size_t bandsFrom = (size_t)first * DEMAND_RANK_BANDS, bandsTo = (size_t)last * DEMAND_RANK_BANDS;
+
+    for (int t = 0; t < job->tasks; t++) {
+        const DemandCounters* c = &job->counters[t];
+        for (size_t i = positionsFrom; i < positionsTo; i++) r->by_position[i] += c->by_position[i];
+        for (size_t i = bandsFrom; i < bandsTo; i++) r->by_band[i] += c->by_band[i];
+    }
+}
+
+DemandReport* analyzeDemand(Queue* q) {
+    double t0 = monotonicSeconds();
+    DemandReport* r = (DemandReport*)calloc(1, sizeof(DemandReport));
+    r->programs = programCount;
+    r->by_position = (uint32_t*)calloc((size_t)programCount * DEMAND_POSITIONS, sizeof(uint32_t));
+    r->by_band = (uint32_t*)calloc((size_t)programCount * DEMAND_RANK_BANDS, sizeof(uint32_t));
+
+    DemandJob job = { q, NULL, workerThreadCount(), r };
+    int useful = (q->students.count + DEMAND_MIN_TASK_STUDENTS - 1) / DEMAND_MIN_TASK_STUDENTS;
+    if (job.tasks > useful) job.tasks = useful > 0 ? useful : 1;
+    job.counters = (DemandCounters*)calloc(job.tasks, sizeof(DemandCounters));
+    for (int t = 0; t < job.tasks; t++) {
+        job.counters[t].by_position = (uint32_t*)calloc((size_t)programCount * DEMAND_POSITIONS, sizeof(uint32_t));
+        job.counters[t].by_band = (uint32_t*)calloc((size_t)programCount * DEMAND_RANK_BANDS, sizeof(uint32_t));
+    }
+    runParallel(countTask, &job, job.tasks);
+
+    for (int t = 0; t < job.tasks; t++) {
+        const DemandCounters* c = &job.counters[t];
+        r->candidates += c->candidates;
+        r->verified += c->verified;
+        r->listed += c->listed;
+        r->no_preferences += c->no_preferences;
+        for (int b = 0; b < DEMAND_RANK_BANDS; b++)
+            r->band_candidates[b] += c->band_candidates[b];
+    }
+    int scanTasks = job.tasks;
+    if (job.tasks > programCount) job.tasks = programCount;
+    runParallel(mergeTask, &job, job.tasks);
+
+    for (int t = 0; t < scanTasks; t++) {
+        free(job.counters[t].by_position);
+        free(job.counters[t].by_band);
+    }
+    free(job.counters);
+    r->threads = scanTasks;
+    r->seconds = monotonicSeconds() - t0;
+    return r;
+}
+
+void releaseDemandReport(DemandReport* r) {
+    if (r == NULL) return;
+    free(r->by_position);
+    free(r->by_band);
+    free(r);
+}
+
+// First-choice demand per seat; 0 for a program without seats
+double oversubscription(const DemandReport* r, int program) {
+    int seats = programCapacity[program];
+    return seats > 0 ? (double)r->by_position[program * DEMAND_POSITIONS] / seats : 0.0;
+}
+
+static void writeJsonString(FILE* out, const char* text) {
+    fputc('"', out);
+    for (const char* p = text; *p != '\0'; p++) {
+        if (*p == '"' || *p == '\\') fprintf(out, "\\%c", *p);
+        else if ((unsigned char)*p < 0x20) fprintf(out, "\\u%04x", (unsigned char)*p);
+        else fputc(*p, out);
+    }
+    fputc('"', out);
+}
+
+bool writeDemandJson(const DemandReport* r, const char* path) {
+    FILE* out = fopen(path, "w");
+    if (out == NULL) return false;
+
+    fprintf(out, "{\"candidates\":%ld,\"verified\":%ld,\"preferences\":%ld,\"no_preferences\":%ld,\n",
+            r->candidates, r->verified, r->listed, r->no_preferences);
+    fprintf(out, " \"positions\":%d,\"rank_bands\":[", DEMAND_POSITIONS);
+    for (int b = 0; b < DEMAND_RANK_BANDS; b++) {
+        fprintf(out, "%s{\"max_rank\":", b ? "," : "");
+        if (demandBandLimits[b] == INT_MAX) fprintf(out, "null");
+        else fprintf(out, "%d", demandBandLimits[b]);
+        fprintf(out, ",\"candidates\":%ld}", r->band_candidates[b]);
+    }
+    fprintf(out, "],\n \"programs\":[\n");
+    for (int p = 0; p < r->programs; p++) {
+        fprintf(out, "  {\"choice\":%d,\"college\":", p + 1);
+        writeJsonString(out, programCollegeName(p));
+        fprintf(out, ",\"branch\":");
+        writeJsonString(out, programBranchName(p));
+        long total = 0;
+        for (int i = 0; i < DEMAND_POSITIONS; i++) total += r->by_position[p * DEMAND_POSITIONS + i];
+        fprintf(out, ",\"seats\":%d,\"listed\":%ld,\"first_choice\":%u,\"oversubscription\":%.4f,\"by_position\":[",
+                programCapacity[p], total, r->by_position[p * DEMAND_POSITIONS], oversubscription(r, p));
+        for (int i = 0; i < DEMAND_POSITIONS; i++)
+            fprintf(out, "%s%u", i ? "," : "", r->by_position[p * DEMAND_POSITIONS + i]);
+        fprintf(out, "],\"by_rank_band\":[");
+        for (int b = 0; b < DEMAND_RANK_BANDS; b++)
+            fprintf(out, "%s%u", b ? "," : "", r->by_band[p * DEMAND_RANK_BANDS + b]);
+        fprintf(out, "]}%s\n", p + 1 < r->programs ? "," : "");
+    }
+    fprintf(out, " ]}\n");
+    return fclose(out) == 0;
+}
+
+static void displayDemand(const DemandReport* r) {
+    printf("\n%sDemand Analytics%s\n", COLOR_BLUE, COLOR_RESET);
+    printf("================\n");
+    printf("%ld candidate(s), %ld verified, %ld choice(s) listed, %ld with no preferences\n",
+           r->candidates, r->verified, r->listed, r->no_preferences);
+    printf("Scanned in %.2f ms on %d thread(s)\n\n", r->seconds * 1000.0, r->threads);
+
+    printf("%-6s %-40s %-6s %6s %8s %7s %8s %8s %8s\n",
+           "Choice", "College", "Branch", "Seats", "1st", "Ratio", "2nd", "3rd", "Listed");
+    for (int p = 0; p < r->programs; p++) {
+        const uint32_t* positions = r->by_position + (size_t)p * DEMAND_POSITIONS;
+        long total = 0;
+        for (int i = 0; i < DEMAND_POSITIONS; i++) total += positions[i];
+        const char* colour = oversubscription(r, p) > 1.0 ? COLOR_RED : "";
+        printf("%-6d %-40.40s %-6.6s %6d %s%8u %7.2f%s %8u %8u %8ld\n", p + 1,
+               programCollegeName(p), programBranchName(p), programCapacity[p],
+               colour, positions[0], oversubscription(r, p), colour[0] ? COLOR_RESET : "",
+               DEMAND_POSITIONS > 1 ? positions[1] : 0, DEMAND_POSITIONS > 2 ? positions[2] : 0, total);
+    }
+
+    printf("\nCandidates by rank band:\n");
+    for (int b = 0; b < DEMAND_RANK_BANDS; b++) {
+        int low = b ? demandBandLimits[b - 1] + 1 : 1;
+        if (demandBandLimits[b] == INT_MAX)
+            printf("  %7d+       : %ld\n", low, r->band_candidates[b]);
+        else
+            printf("  %7d-%-7d: %ld\n", low, demandBandLimits[b], r->band_candidates[b]);
+    }
+}
+
+void demandMenu(Queue* q) {
+    DemandReport* r = analyzeDemand(q);
+    displayDemand(r);
+
+    char path[256];
+    printf("\nSave as JSON to (press Enter to skip): ");
+    if (fgets(path, sizeof(path), stdin) != NULL) {
+        path[strcspn(path, "\r\n")] = '\0';
+        if (path[0] != '\0') {
+            if (writeDemandJson(r, path))
+                printf("%sDemand written to %s%s\n", COLOR_GREEN, path, COLOR_RESET);
+            else
+                printf("%sError: Cannot write %s%s\n", COLOR_RED, path, COLOR_RESET);
+        }
+    }
+    releaseDemandReport(r);
+}
@@ -1,301 +1,728 @@
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include "enhanced_ds.h"
 
-// Global college data
-College colleges[MAX_COLLEGES];
-
 // Global MAX_PREFERENCES variable
 int MAX_PREFERENCES = 3; // Default value, can be changed via command line
 
-// External function declarations
-extern bool isValidDOB(const char* dob);
-extern bool isValidAadhar(const char* aadhar);
-
 // Internal function declarations
-static BSTNode* createBSTNode(int rank, Student* student);
-static void insertBST(BSTNode** root, int rank, Student* student);
-static BSTNode* searchBST(BSTNode* root, int rank);
-static void pushOperation(OpStack* stack, const char* operation);
-static void updateCollegeNetwork(CollegeGraph* graph, int src, int dest, int weight);
+static BSTNode* insertBST(RankIndex* index, int rank, StudentId student);
+static BSTNode* searchBST(RankIndex* index, int rank);
+static StudentId rankSlotGet(RankBuckets* rb, int rank);
+static void rankSlotSet(RankBuckets* rb, int rank, StudentId student);
+static StudentId rankPredecessor(RankBuckets* rb, int rank);
+static void recordEnqueue(Queue* q, StudentId newStudent);
 
 // BST functions
-static BSTNode* createBSTNode(int rank, Student* student) {
-    BSTNode* node = (BSTNode*)malloc(sizeof(BSTNode));
+#define AVL_MAX_HEIGHT 64
+
+static BSTNode* createBSTNode(RankIndex* index, int rank, StudentId student) {
+    BSTNode* node = (BSTNode*)poolAlloc(&index->nodes);
     node->rank = rank;
+    node->height = 1;
     node->student = student;
     node->left = node->right = NULL;
     return node;
 }
 
-static void insertBST(BSTNode** root, int rank, Student* student) {
-    if (*root == NULL) {
-        *root = createBSTNode(rank, student);
-        return;
+static int nodeHeight(BSTNode* node) {
+    return node ? node->height : 0;
+}
+
+static void updateHeight(BSTNode* node) {
+    int l = nodeHeight(node->left);
+    int r = nodeHeight(node->right);
+    node->height = 1 + (l > r ? l : r);
+}
+
+static BSTNode* rotateRight(BSTNode* y) {
+    BSTNode* x = y->left;
+    y->left = x->right;
+    x->right = y;
+    updateHeight(y);
+    updateHeight(x);
+    return x;
+}
+
+static BSTNode* rotateLeft(BSTNode* x) {
+    BSTNode* y = x->right;
+    x->right = y->left;
+    y->left = x;
+    updateHeight(x);
+    updateHeight(y);
+    return y;
+}
+
+static BSTNode* rebalance(BSTNode* node) {
+    updateHeight(node);
+    int balance = nodeHeight(node->left) - nodeHeight(node->right);
+    if (balance > 1) {
+        if (nodeHeight(node->left->left) < nodeHeight(node->left->right))
+            node->left = rotateLeft(node->left);
+        return rotateRight(node);
+    }
+    if (balance < -1) {
+        if (nodeHeight(node->right->right) < nodeHeight(node->right->left))
+            node->right = rotateRight(node->right);
+        return rotateLeft(node);
+    }
+    return node;
+}
+
+static void setRankBit(RankIndex* index, int rank) {
+    index->bitmap[rank >> 6] |= (uint64_t)1 << (rank & 63);
+}
+
+// Grows the bitmap to cover rank when it is still in the dense range.
+// Ranks beyond it are answered by the tree alone.
+static void growRankBitmap(RankIndex* index, int rank) {
+    long dense = (long)index->count * 16;
+    if (dense < RANK_BITMAP_MIN) dense = RANK_BITMAP_MIN;
+    if (rank >= dense) return;
+
+    long limit = index->bitmap_limit ? index->bitmap_limit : 64;
+    while (limit <= rank) limit *= 2;
+    if (limit > dense) limit = (dense + 63) & ~63L;
+
+    index->bitmap = (uint64_t*)snapshotRealloc(index->bitmap, (index->bitmap_limit / 64) * sizeof(uint64_t),
+                                               (limit / 64) * sizeof(uint64_t));
+    memset(index->bitmap + index->bitmap_limit / 64, 0,
+           ((limit - index->bitmap_limit) / 64) * sizeof(uint64_t));
+
+    // Ranks that were outliers before may now fall inside the bitmap.
+    // They are all above the old limit, so only those subtrees are walked.
+    BSTNode* stack[AVL_MAX_HEIGHT];
+    int depth = 0;
+    if (index->root != NULL) stack[depth++] = index->root;
+    while (depth > 0) {
+        BSTNode* node = stack[--depth];
+        if (node->rank >= index->bitmap_limit && node->rank < limit)
+            setRankBit(index, node->rank);
+        if (node->left != NULL && node->rank > index->bitmap_limit)
+            stack[depth++] = node->left;
+        if (node->right != NULL && node->rank < limit - 1)
+            stack[depth++] = node->right;
+    }
+    index->bitmap_limit = limit;
+}
+
+static BSTNode* insertBST(RankIndex* index, int rank, StudentId student) {
+    BSTNode** path[AVL_MAX_HEIGHT];
+    int depth = 0;
+
+    BSTNode** link = &index->root;
+    while (*link != NULL) {
+        path[depth++] = link;
+        link = (rank < (*link)->rank) ? &(*link)->left : &(*link)->right;
+    }
+    BSTNode* node = createBSTNode(index, rank, student);
+    *link = node;
+    index->count++;
+
+    // Walk back up, stopping once a subtree height is unchanged
+    while (depth > 0) {
+        BSTNode** parent = path[--depth];
+        int oldHeight = (*parent)->height;
+        *parent = rebalance(*parent);
+        if ((*parent)->height == oldHeight)
+            break;
+    }
+
+    if (rank >= index->bitmap_limit)
+        growRankBitmap(index, rank);
+    if (rank >= 0 && rank < index->bitmap_limit)
+        setRankBit(index, rank);
+    return node;
+}
+
+static BSTNode* searchBST(RankIndex* index, int rank) {
+    BSTNode* node = index->root;
+    while (node != NULL && node->rank != rank)
+        node = (rank < node->rank) ? node->left : node->right;
+    return node;
+}
+
+// A rank index loaded from a snapshot comes with its bitmap but no tree;
+// the tree is built from the queue the first time it is needed
+static void ensureRankTree(Queue* q) {
+    RankIndex* index = q->rank_tree;
+    if (!index->tree_pending) return;
+    index->tree_pending = false;
+    index->count = 0;
+    for (StudentId s = q->front; s != NO_STUDENT; s = q->students.next[s])
+        insertBST(index, q->students.rank[s], s);
+}
+
+double monotonicSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Rank bucket functions
+static StudentId rankSlotGet(RankBuckets* rb, int rank) {
+    int page = rank >> RANK_PAGE_BITS;
+    if (page >= rb->page_count || rb->pages[page] == NULL)
+        return NO_STUDENT;
+    return rb->pages[page]->slots[rank & (RANK_PAGE_SIZE - 1)];
+}
+
+static void rankSlotSet(RankBuckets* rb, int rank, StudentId student) {
+    int page = rank >> RANK_PAGE_BITS;
+    if (page >= rb->page_count) {
+        int newCount = rb->page_count ? rb->page_count : 16;
+        while (newCount <= page) newCount *= 2;
+        rb->pages = (RankPage**)realloc(rb->pages, newCount * sizeof(RankPage*));
+        memset(rb->pages + rb->page_count, 0, (newCount - rb->page_count) * sizeof(RankPage*));
+        rb->page_count = newCount;
+    }
+    if (rb->pages[page] == NULL) {
+        rb->pages[page] = (RankPage*)malloc(sizeof(RankPage));
+        memset(rb->pages[page]->slots, 0xFF, sizeof(rb->pages[page]->slots));  // NO_STUDENT
+        rb->pages[page]->count = 0;
+    }
+
+    RankPage* p = rb->pages[page];
+    StudentId* slot = &p->slots[rank & (RANK_PAGE_SIZE - 1)];
+    // A repeated rank keeps the slot pointing at the first enqueued student of that rank
+    if (*slot == NO_STUDENT) {
+        *slot = student;
+        p->count++;
     }
-    if (rank < (*root)->rank)
-        insertBST(&(*root)->left, rank, student);
-    else
-        insertBST(&(*root)->right, rank, student);
 }
 
-static BSTNode* searchBST(BSTNode* root, int rank) {
-    if (root == NULL || root->rank == rank)
-        return root;
-    if (rank < root->rank)
-        return searchBST(root->left, rank);
-    return searchBST(root->right, rank);
+// Closest queued student with a lower rank, or NO_STUDENT if rank belongs at the front
+static StudentId rankPredecessor(RankBuckets* rb, int rank) {
+    int page = rank >> RANK_PAGE_BITS;
+    int slot = (rank & (RANK_PAGE_SIZE - 1)) - 1;
+    if (page >= rb->page_count) {
+        page = rb->page_count - 1;
+        slot = RANK_PAGE_SIZE - 1;
+    }
+
+    for (; page >= 0; page--, slot = RANK_PAGE_SIZE - 1) {
+        RankPage* p = rb->pages[page];
+        if (p == NULL || p->count == 0) continue;
+        for (; slot >= 0; slot--) {
+            if (p->slots[slot] != NO_STUDENT)
+                return p->slots[slot];
+        }
+    }
+    return NO_STUDENT;
+}
+
+bool rankExists(Queue* q, int rank) {
+    RankIndex* index = q->rank_tree;
+    if (rank >= 0 && rank < index->bitmap_limit) {
+        METRIC_COUNT(METRIC_RANK_BITMAP_LOOKUPS);
+        return (index->bitmap[rank >> 6] >> (rank & 63)) & 1;
+    }
+    METRIC_COUNT(METRIC_RANK_TREE_LOOKUPS);
+    METRIC_SPAN_BEGIN(lookup);
+    ensureRankTree(q);
+    bool found = searchBST(index, rank) != NULL;
+    METRIC_SPAN_END(lookup, METRIC_RANK_TREE_NS);
+    return found;
 }
 
 // Queue operations
 Queue* createQueue() {
     Queue* q = (Queue*)malloc(sizeof(Queue));
-    q->front = NULL;
-    q->rank_tree = NULL;
-    q->college_network = (CollegeGraph*)malloc(sizeof(CollegeGraph));
-    q->college_network->adjacency_list = (CollegeNode**)calloc(MAX_COLLEGES, sizeof(CollegeNode*));
-    q->operation_log = (OpStack*)malloc(sizeof(OpStack));
-    q->operation_log->top = NULL;
-    pushOperation(q->operation_log, "Queue initialized");
+    q->front = NO_STUDENT;
+    studentStoreInit(&q->students);
+    memset(&q->preferences, 0, sizeof(PreferencePool));
+    q->rank_slots = (RankBuckets*)calloc(1, sizeof(RankBuckets));
+    q->rank_tree = (RankIndex*)calloc(1, sizeof(RankIndex));
+    poolInit(&q->rank_tree->nodes, sizeof(BSTNode), RANK_NODE_POOL_BLOCK);
+    q->allocation = (AllocationState*)calloc(1, sizeof(AllocationState));
+    q->co_preferences = coPreferenceCreate();
+    q->rounds = NULL;
+    q->priorities = NULL;
+    q->journal = NULL;
+    q->journal_sequence = 0;
+    q->operation_log = opLogCreate();
+    opLogAppend(q->operation_log, OP_QUEUE_INIT, 0, PROGRAM_NOT_ALLOCATED);
     return q;
 }
 
-void enqueue(Queue* q, Student* newStudent) {
-    // Add to BST first
-    insertBST(&q->rank_tree, newStudent->rank, newStudent);
-    newStudent->rank_node = searchBST(q->rank_tree, newStudent->rank);
-    
-    // Update college network based on preferences
-    for (int i = 0; i < newStudent->num_preferences; i++) {
-        int college_idx = newStudent->preferences[i].college_index;
-        colleges[college_idx].preference_count++;
-        if (i > 0) {
-            int prev_college = newStudent->preferences[i-1].college_index;
-            updateCollegeNetwork(q->college_network, prev_college, college_idx, 1);
+// Stores a preference list for a student, reusing the student's run when
+// the new list fits in it
+void setStudentPreferences(Queue* q, StudentId student, const uint16_t* ids, int count) {
+    PreferencePool* pool = &q->preferences;
+    StudentStore* store = &q->students;
+    int current = store->num_preferences[student];
+    bool queued = store->rank[student] > 0 && rankSlotGet(q->rank_slots, store->rank[student]) == student;
+    if (queued)
+        notePreferenceList(q, STUDENT_PREFS(q, student), current, -1);
+    if (count > current) {
+        if (pool->used + count > pool->capacity) {
+            pool->capacity = pool->capacity ? pool->capacity * 2 : 4096;
+            while (pool->capacity < pool->used + count) pool->capacity *= 2;
+            pool->ids = (uint16_t*)snapshotRealloc(pool->ids, pool->used * sizeof(uint16_t),
+                                                   pool->capacity * sizeof(uint16_t));
         }
+        pool->stale += current;
+        store->pref_offset[student] = (uint32_t)pool->used;
+        pool->used += count;
+    } else {
+        pool->stale += current - count;
     }
+    memcpy(pool->ids + store->pref_offset[student], ids, count * sizeof(uint16_t));
+    store->num_preferences[student] = (uint16_t)count;
+    if (queued)
+        notePreferenceList(q, ids, count, 1);
+}
+
+// Index bookkeeping shared by enqueue and enqueueBulk
+static void recordEnqueue(Queue* q, StudentId newStudent) {
+    StudentStore* store = &q->students;
+    int rank = store->rank[newStudent];
+
+    // Add to BST first
+    ensureRankTree(q);
+    insertBST(q->rank_tree, rank, newStudent);
+    indexStudent(store->reg_number[newStudent], newStudent);
+    
+    // Count the student's choices and their order
+    const uint16_t* prefs = STUDENT_PREFS(q, newStudent);
+    for (int i = 0; i < store->num_preferences[newStudent]; i++)
+        colleges[PROGRAM_COLLEGE(prefs[i])].preference_count++;
+    notePreferenceList(q, prefs, store->num_preferences[newStudent], 1);
     
-    // Regular queue insertion based on rank
-    if (q->front == NULL || newStudent->rank < q->front->rank) {
-        newStudent->next = q->front;
+    opLogAppend(q->operation_log, OP_ENQUEUE, rank, PROGRAM_NOT_ALLOCATED);
+    noteRoundChange(q, newStudent);
+}
+
+void enqueue(Queue* q, StudentId newStudent) {
+    METRIC_SPAN_BEGIN(enqueue);
+    StudentStore* store = &q->students;
+    int rank = store->rank[newStudent];
+
+    // Queue insertion based on rank: the nearest lower rank is found
+    // through the rank buckets instead of walking the list from the front
+    StudentId prev = rankPredecessor(q->rank_slots, rank);
+    if (prev == NO_STUDENT) {
+        store->next[newStudent] = q->front;
         q->front = newStudent;
     } else {
-        Student* current = q->front;
-        while (current->next != NULL && current->next->rank < newStudent->rank) {
-            current = current->next;
-        }
-        newStudent->next = current->next;
-        current->next = newStudent;
+        store->next[newStudent] = store->next[prev];
+        store->next[prev] = newStudent;
     }
+    rankSlotSet(q->rank_slots, rank, newStudent);
+    q->allocation->valid = false;
     
-    char operation[100];
-    sprintf(operation, "Enqueued student with rank %d", newStudent->rank);
-    pushOperation(q->operation_log, operation);
+    recordEnqueue(q, newStudent);
+    METRIC_COUNT(METRIC_ENQUEUES);
+    METRIC_SPAN_END(enqueue, METRIC_ENQUEUE_NS);
+}
+
+typedef struct {
+    int rank;
+    int index;
+} RankKey;
+
+static int compareRankKeys(const void* a, const void* b) {
+    const RankKey* x = (const RankKey*)a;
+    const RankKey* y = (const RankKey*)b;
+    if (x->rank != y->rank) return (x->rank < y->rank) ? -1 : 1;
+    return (x->index < y->index) ? -1 : (x->index > y->index);
+}
+
+// Bulk-load path: sorts the new students once and merges them into the
+// queue in a single pass. Students whose rank is already queued (or that
+// repeat a rank earlier in the array) are not enqueued; they are moved to
+// the end of the array and the number of enqueued students is returned.
+// Loading into an empty queue also renumbers the store in rank order, so
+// the array is rewritten with the new ids.
+int enqueueBulk(Queue* q, StudentId* students, int count) {
+    METRIC_SPAN_BEGIN(bulk);
+    if (count <= 0) return 0;
+    StudentStore* store = &q->students;
+
+    RankKey* keys = (RankKey*)malloc(count * sizeof(RankKey));
+    for (int i = 0; i < count; i++) {
+        keys[i].rank = store->rank[students[i]];
+        keys[i].index = i;
+    }
+    qsort(keys, count, sizeof(RankKey), compareRankKeys);
+
+    StudentId* sorted = (StudentId*)malloc(count * sizeof(StudentId));
+    int accepted = 0;
+    int rejected = 0;
+    for (int i = 0; i < count; i++) {
+        StudentId s = students[keys[i].index];
+        bool duplicate = rankSlotGet(q->rank_slots, keys[i].rank) != NO_STUDENT ||
+                         (accepted > 0 && store->rank[sorted[accepted - 1]] == keys[i].rank);
+        if (duplicate) {
+            // Already-read keys are reused to remember the rejected inputs
+            keys[rejected++].index = keys[i].index;
+        } else {
+            sorted[accepted++] = s;
+        }
+    }
+    StudentId* duplicates = sorted + accepted;
+    for (int i = 0; i < rejected; i++)
+        duplicates[i] = students[keys[i].index];
+
+    // Nothing refers to ids yet: give the run ids 0..accepted-1
+    if (q->front == NO_STUDENT && q->rounds == NULL && q->priorities == NULL) {
+        renumberStudents(q, sorted, count);
+        for (int i = 0; i < count; i++) sorted[i] = i;
+    }
+
+    // Merge the sorted run into the existing rank-ordered list
+    if (accepted > 0) q->allocation->valid = false;
+    StudentId* link = &q->front;
+    for (int i = 0; i < accepted; i++) {
+        int rank = store->rank[sorted[i]];
+        while (*link != NO_STUDENT && store->rank[*link] < rank)
+            link = &store->next[*link];
+        store->next[sorted[i]] = *link;
+        *link = sorted[i];
+        link = &store->next[sorted[i]];
+        rankSlotSet(q->rank_slots, rank, sorted[i]);
+        recordEnqueue(q, sorted[i]);
+    }
+
+    memcpy(students, sorted, count * sizeof(StudentId));
+    free(sorted);
+    free(keys);
+    METRIC_ADD(METRIC_ENQUEUES, accepted);
+    METRIC_SPAN_END(bulk, METRIC_BULK_ENQUEUE_NS);
+    return accepted;
 }
 
-void displayStudents(Student* head) {
+// Both views page over the export cursor, EXPORT_PAGE_ROWS rows at a time
+void displayStudents(Queue* q) {
+    StudentStore* store = &q->students;
     printf("\n%sStudent List%s\n", COLOR_BLUE, COLOR_RESET);
     printf("============\n");
-    printf("%-10s %-20s %-6s %-30s %-10s\n", 
+    printf("%-10s %-20s %-6s %-30s %-10s", 
            "Reg No", "Name", "Rank", "College", "Branch");
-    printf("------------------------------------------------------------\n");
+    if (seatPoolCount > 1) printf(" %-8s", "Pool");
+    printf("\n------------------------------------------------------------\n");
     
-    Student* current = head;
-    while (current != NULL) {
-        printf("%-10s %-20s %-6d %-30s %-10s\n",
-               current->reg_number,
-               current->name,
-               current->rank,
-               current->allocated_college,
-               current->allocated_branch);
-        current = current->next;
+    ExportCursor cursor;
+    ExportRow row;
+    int shown = 0;
+    exportCursorInit(&cursor, q, EXPORT_ALLOTMENT, NULL);
+    while (exportNext(&cursor, &row) && pageRow(&shown)) {
+        printf("%-10s %-20s %-6d %-30s %-10s",
+               store->reg_number[row.student],
+               STUDENT_NAME(store, row.student),
+               row.rank,
+               programCollegeName(row.program),
+               programBranchName(row.program));
+        if (seatPoolCount > 1)
+            printf(" %-8s", row.program >= 0 ? seatPoolName(row.pool) : "");
+        printf("\n");
     }
 }
 
-// Operation Stack functions
-static void pushOperation(OpStack* stack, const char* operation) {
-    OpNode* newNode = (OpNode*)malloc(sizeof(OpNode));
-    strcpy(newNode->operation, operation);
-    newNode->next = stack->top;
-    stack->top = newNode;
-}
-
-static void updateCollegeNetwork(CollegeGraph* graph, int src, int dest, int weight) {
-    CollegeNode* newNode = (CollegeNode*)malloc(sizeof(CollegeNode));
-    newNode->college_id = dest;
-    newNode->preference_weight = weight;
-    newNode->next = graph->adjacency_list[src];
-    graph->adjacency_list[src] = newNode;
-}
-
 void displayColleges() {
     printf("\n%s================================================================%s\n", COLOR_BLUE, COLOR_RESET);
     printf("%s                  COMEDK College Information                      %s\n", COLOR_BLUE, COLOR_RESET);
     printf("%s================================================================%s\n", COLOR_BLUE, COLOR_RESET);
-    printf("%-4s %-35s %-15s %-10s\n", 
+    printf("%-6s %-35s %-15s %-10s\n", 
            "No.", "College Name", "Branch", "Seats");
     printf("----------------------------------------------------------------\n");
     
-    for (int i = 0; i < MAX_COLLEGES; i++) {
-        // Display CSE information
-        printf("%-4d %-35s %-15s %-10d\n", 
-               (2*i + 1), 
-               colleges[i].name, 
-               "CSE", 
-               colleges[i].seats_cse);
-               
-        // Display ECE information
-        printf("%-4d %-35s %-15s %-10d\n", 
-               (2*i + 2), 
-               "", 
-               "ECE", 
-               colleges[i].seats_ece);
-               
-        if (i < MAX_COLLEGES - 1) {
-            printf("----------------------------------------------------------------\n");
+    // One row per program, college name on the first one only; the cursor
+    // gives a row per pool, whose seats left follow the total
+    ExportCursor cursor;
+    ExportRow row;
+    int shown = 0;
+    exportCursorInit(&cursor, NULL, EXPORT_SEATS, NULL);
+    while (exportNext(&cursor, &row)) {
+        int program_id = row.program;
+        int college = PROGRAM_COLLEGE(program_id);
+        if (row.pool == 0) {
+            bool first = (program_id == colleges[college].first_program);
+            if (first && program_id > 0)
+                printf("----------------------------------------------------------------\n");
+            if (!pageRow(&shown)) break;
+            printf("%-6d %-35s %-15s %-10d", 
+                   program_id + 1, 
+                   first ? colleges[college].name : "", 
+                   programBranchName(program_id), 
+                   programSeats[program_id]);
         }
+        if (seatPoolCount > 1 && poolSeats != NULL)
+            printf(" %s %d", seatPoolNames[row.pool], row.left);
+        if (row.pool == seatPoolCount - 1) printf("\n");
     }
     printf("================================================================\n");
 }
 
-void inputPreferences(Student* student) {
+// Reads MAX_PREFERENCES program ids into choices without storing them
+static void choosePreferences(Queue* q, StudentId student, uint16_t* choices) {
     printf("\n%s============ College Preference Selection ============%s\n", COLOR_YELLOW, COLOR_RESET);
-    printf("Student: %s (Rank: %d)\n", student->name, student->rank);
+    printf("Student: %s (Rank: %d)\n", STUDENT_NAME(&q->students, student), q->students.rank[student]);
     printf("You must select exactly %d preferences in order of priority.\n", MAX_PREFERENCES);
     printf("Each preference should be a combination of college and branch.\n\n");
     
     displayColleges();
-    student->num_preferences = 0;
     
     for (int i = 0; i < MAX_PREFERENCES; i++) {
         printf("\n------------------------------------------------\n");
-        printf("Enter Priority %d Choice (1-8): ", i + 1);
+        printf("Enter Priority %d Choice (1-%d): ", i + 1, programCount);
         int choice;
-        scanf("%d", &choice);
+        if (scanf("%d", &choice) != 1) {
+            while (getchar() != '\n');
+            choice = 0;
+        }
         
-        if (choice < 1 || choice > 8) {
-            printf("%sInvalid choice! Please enter a number between 1 and 8.%s\n", COLOR_RED, COLOR_RESET);
+        if (choice < 1 || choice > programCount) {
+            printf("%sInvalid choice! Please enter a number between 1 and %d.%s\n", COLOR_RED, programCount, COLOR_RESET);
             i--;
             continue;
         }
         
-        student->preferences[i].college_index = (choice - 1) / 2;
-        strcpy(student->preferences[i].branch, 
-               (choice % 2 == 1) ? "CSE" : "ECE");
+        // Menu choices are numbered by program id
+        choices[i] = (uint16_t)(choice - 1);
         
         printf("Selected: %s - %s\n", 
-               colleges[student->preferences[i].college_index].name,
-               student->preferences[i].branch);
-        
-        student->num_preferences++;
+               programCollegeName(choice - 1),
+               programBranchName(choice - 1));
     }
 }
 
+void inputPreferences(Queue* q, StudentId student) {
+    uint16_t* choices = (uint16_t*)malloc(MAX_PREFERENCES * sizeof(uint16_t));
+    choosePreferences(q, student, choices);
+    setStudentPreferences(q, student, choices, MAX_PREFERENCES);
+    free(choices);
+}
+
+// Serial-dictatorship step for one student: first preference with a seat left
+// probes is set to the number of preferences looked at
+static int allocateStudent(Queue* q, StudentId student, int* probes) {
+    const StudentStore* store = &q->students;
+    *probes = 0;
+    if (!(store->flags[student] & STUDENT_VERIFIED))
+        return PROGRAM_NOT_ELIGIBLE;
+
+    const uint16_t* prefs = STUDENT_PREFS(q, student);
+    int count = store->num_preferences[student];
+    for (int i = 0; i < count; i++) {
+        int program_id = prefs[i];
+        if (programSeats[program_id] > 0) {
+            programSeats[program_id]--;
+            *probes = i + 1;
+            return program_id;
+        }
+    }
+    *probes = count;
+    return PROGRAM_NOT_ALLOCATED;
+}
+
+void logAllocation(Queue* q, StudentId student) {
+    int rank = q->students.rank[student];
+    int program_id = q->students.allocated_program[student];
+    if (program_id >= 0) {
+        opLogAppend(q->operation_log, OP_ALLOCATE, rank, program_id);
+    } else if (program_id == PROGRAM_NOT_ALLOCATED) {
+        opLogAppend(q->operation_log, OP_NOT_ALLOCATED, rank, PROGRAM_NOT_ALLOCATED);
+    }
+}
+
+static void saveCheckpoint(AllocationState* state, int rank) {
+    if (state->count == state->capacity) {
+        int used = state->count;
+        state->capacity = state->capacity ? state->capacity * 2 : 16;
+        state->ranks = (int*)snapshotRealloc(state->ranks, used * sizeof(int), state->capacity * sizeof(int));
+        state->seats = (int*)snapshotRealloc(state->seats, (size_t)used * programCount * sizeof(int),
+                                             (size_t)state->capacity * programCount * sizeof(int));
+    }
+    state->ranks[state->count] = rank;
+    memcpy(state->seats + (size_t)state->count * programCount, programSeats, programCount * sizeof(int));
+    state->count++;
+}
+
 void processAllocation(Queue* q) {
     printf("\n%sProcessing seat allocation...%s\n", COLOR_YELLOW, COLOR_RESET);
+    double t0 = monotonicSeconds();
+    METRIC_SPAN_BEGIN(allocation);
     
-    // First, save original seat counts for each college
-    int original_cse_seats[MAX_COLLEGES];
-    int original_ece_seats[MAX_COLLEGES];
-    
-    for (int i = 0; i < MAX_COLLEGES; i++) {
-        original_cse_seats[i] = colleges[i].seats_cse;
-        original_ece_seats[i] = colleges[i].seats_ece;
-    }
-    
-    // Count how many seats were already consumed by previous allocations
-    Student* temp = q->front;
-    while (temp != NULL) {
-        // If student was previously allocated, we need to restore those seats
-        if (strcmp(temp->allocated_college, "Not Allocated") != 0 && 
-            strcmp(temp->allocated_college, "Not Eligible") != 0) {
-            // Find the college index
-            for (int i = 0; i < MAX_COLLEGES; i++) {
-                if (strcmp(temp->allocated_college, colleges[i].name) == 0) {
-                    if (strcmp(temp->allocated_branch, "CSE") == 0) {
-                        original_cse_seats[i]++;
-                    } else if (strcmp(temp->allocated_branch, "ECE") == 0) {
-                        original_ece_seats[i]++;
-                    }
-                    break;
-                }
-            }
+    // A fresh round 1: earlier counselling rounds no longer apply
+    discardRounds(q);
+    
+    // Every seat returns to the pool: reset to the configured matrix
+    memcpy(programSeats, programCapacity, programCount * sizeof(int));
+    
+    // Now process allocation from the beginning based on rank order
+    AllocationState* state = q->allocation;
+    StudentStore* store = &q->students;
+    state->count = 0;
+    // Outcomes are counted here and merged once, not per student
+    long outcomes[3] = { 0, 0, 0 };  // Allocated, not allocated, not eligible
+    state->engine = currentAllocationEngine();
+    if (state->engine == ALLOCATION_DEFERRED) {
+        // College-side priorities; no checkpoints, an edit reruns it all
+        allocateDeferred(q, &state->deferred);
+        for (StudentId s = q->front; s != NO_STUDENT; s = store->next[s]) {
+            int program_id = store->allocated_program[s];
+            outcomes[program_id >= 0 ? 0 : (program_id == PROGRAM_NOT_ALLOCATED ? 1 : 2)]++;
+            logAllocation(q, s);
         }
-        temp = temp->next;
+        printf("%sDeferred acceptance settled after %ld proposal(s), %ld displaced.%s\n",
+               COLOR_BLUE, state->deferred.proposals, state->deferred.displaced, COLOR_RESET);
+    } else if (seatPoolCount > 1) {
+        // Pools are filled side by side; no checkpoints are kept
+        int passes = allocateSeatPools(q);
+        for (StudentId s = q->front; s != NO_STUDENT; s = store->next[s]) {
+            int program_id = store->allocated_program[s];
+            outcomes[program_id >= 0 ? 0 : (program_id == PROGRAM_NOT_ALLOCATED ? 1 : 2)]++;
+            logAllocation(q, s);
+        }
+        printf("%s%d seat pools settled after %d pass(es) on %d thread(s).%s\n",
+               COLOR_BLUE, seatPoolCount, passes, workerThreadCount(), COLOR_RESET);
+    } else {
+        METRIC_BLOCK(probeCounts);
+        long probeTotal = 0, exhausted = 0;
+        int position = 0;
+        for (StudentId s = q->front; s != NO_STUDENT; s = store->next[s], position++) {
+            if (position % CHECKPOINT_INTERVAL == 0)
+                saveCheckpoint(state, store->rank[s]);
+            
+            int probes;
+            int program_id = allocateStudent(q, s, &probes);
+            store->allocated_program[s] = program_id;
+            outcomes[program_id >= 0 ? 0 : (program_id == PROGRAM_NOT_ALLOCATED ? 1 : 2)]++;
+            probeTotal += probes;
+            exhausted += probes - (program_id >= 0);
+            METRIC_BLOCK_RECORD(probeCounts, probes);
+            logAllocation(q, s);
+        }
+        METRIC_BLOCK_MERGE(probeCounts, METRIC_PROBES_PER_STUDENT);
+        METRIC_ADD(METRIC_PREFERENCE_PROBES, probeTotal);
+        METRIC_ADD(METRIC_SEATS_EXHAUSTED, exhausted);
     }
+    buildCutoffs(q);
+    state->valid = true;
+    state->seconds = monotonicSeconds() - t0;
+    METRIC_COUNT(METRIC_ALLOCATION_RUNS);
+    METRIC_ADD(METRIC_ALLOCATED, outcomes[0]);
+    METRIC_ADD(METRIC_NOT_ALLOCATED, outcomes[1]);
+    METRIC_ADD(METRIC_NOT_ELIGIBLE, outcomes[2]);
+    METRIC_SPAN_END(allocation, METRIC_ALLOCATION_NS);
     
-    // Reset all college seats to original values
-    for (int i = 0; i < MAX_COLLEGES; i++) {
-        colleges[i].seats_cse = original_cse_seats[i];
-        colleges[i].seats_ece = original_ece_seats[i];
+    printf("\n%sAllocation complete! View all students to see results.%s\n", COLOR_GREEN, COLOR_RESET);
+}
+
+// Re-runs allocation after the preferences of one student changed. Results
+// for better ranks cannot change, so the run resumes from the checkpoint
+// just before that student and stops as soon as the seat state matches the
+// previous run again. Returns the number of students re-evaluated, or -1
+// if there is no valid allocation to update.
+int reallocateFromStudent(Queue* q, StudentId changed) {
+    AllocationState* state = q->allocation;
+    StudentStore* store = &q->students;
+    if (state->engine == ALLOCATION_DEFERRED)
+        return reallocateDeferred(q);
+    if (seatPoolCount > 1)
+        return state->valid ? reallocateSeatPools(q, changed) : -1;
+    if (!state->valid || state->count == 0)
+        return -1;
+
+    // Last checkpoint at or before the changed student
+    int lo = 0, hi = state->count - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if (state->ranks[mid] <= store->rank[changed]) lo = mid;
+        else hi = mid - 1;
     }
-    
-    // Clear all previous allocations
-    temp = q->front;
-    while (temp != NULL) {
-        strcpy(temp->allocated_college, "Not Allocated");
-        strcpy(temp->allocated_branch, "NA");
-        temp = temp->next;
+    int checkpoint = lo;
+
+    // The final seat state is restored as is if the run converges
+    size_t seatBytes = programCount * sizeof(int);
+    int* finalSeats = (int*)malloc(seatBytes);
+    memcpy(finalSeats, programSeats, seatBytes);
+    memcpy(programSeats, state->seats + (size_t)checkpoint * programCount, seatBytes);
+
+    // Replay the unchanged prefix from the stored results
+    StudentId current = rankSlotGet(q->rank_slots, state->ranks[checkpoint]);
+    for (; current != changed; current = store->next[current]) {
+        if (store->allocated_program[current] >= 0)
+            programSeats[store->allocated_program[current]]--;
     }
-    
-    // Now process allocation from the beginning based on rank order
-    Student* current = q->front;
-    while (current != NULL) {
-        if (!current->verified) {
-            strcpy(current->allocated_college, "Not Eligible");
-            strcpy(current->allocated_branch, "NA");
-            current = current->next;
-            continue;
+
+    // delta[p] = seats now - seats at the same point of the previous run
+    int* delta = (int*)calloc(programCount, sizeof(int));
+    int differing = 0;
+    int evaluated = 0;
+    int nextCheckpoint = checkpoint + 1;
+
+    for (; current != NO_STUDENT; current = store->next[current]) {
+        if (nextCheckpoint < state->count && store->rank[current] == state->ranks[nextCheckpoint]) {
+            memcpy(state->seats + (size_t)nextCheckpoint * programCount, programSeats, seatBytes);
+            nextCheckpoint++;
         }
-        
-        bool allocated = false;
-        
-        for (int i = 0; i < current->num_preferences && !allocated; i++) {
-            int college_idx = current->preferences[i].college_index;
-            char* branch = current->preferences[i].branch;
-            
-            if (strcmp(branch, "CSE") == 0 && colleges[college_idx].seats_cse > 0) {
-                strcpy(current->allocated_college, colleges[college_idx].name);
-                strcpy(current->allocated_branch, "CSE");
-                colleges[college_idx].seats_cse--;
-                allocated = true;
-                
-                char operation[100];
-                sprintf(operation, "Allocated %s to %s CSE", current->name, colleges[college_idx].name);
-                pushOperation(q->operation_log, operation);
+
+        int previous = store->allocated_program[current];
+        int probes;
+        int allocated = allocateStudent(q, current, &probes);
+        evaluated++;
+        if (allocated != previous) {
+            store->allocated_program[current] = allocated;
+            logAllocation(q, current);
+            noteCutoffMove(q, store->rank[current], previous, 0, allocated, 0);
+            if (previous >= 0) {
+                differing += (delta[previous] == 0) - (delta[previous] == -1);
+                delta[previous]++;
             }
-            else if (strcmp(branch, "ECE") == 0 && colleges[college_idx].seats_ece > 0) {
-                strcpy(current->allocated_college, colleges[college_idx].name);
-                strcpy(current->allocated_branch, "ECE");
-                colleges[college_idx].seats_ece--;
-                allocated = true;
-                
-                char operation[100];
-                sprintf(operation, "Allocated %s to %s ECE", current->name, colleges[college_idx].name);
-                pushOperation(q->operation_log, operation);
+            if (allocated >= 0) {
+                differing += (delta[allocated] == 0) - (delta[allocated] == 1);
+                delta[allocated]--;
             }
         }
-        
-        if (!allocated) {
-            strcpy(current->allocated_college, "Not Allocated");
-            strcpy(current->allocated_branch, "NA");
-            pushOperation(q->operation_log, "Student could not be allocated");
+
+        // Same seats as before at this point: the rest of the queue is unchanged
+        if (differing == 0) {
+            memcpy(programSeats, finalSeats, seatBytes);
+            break;
         }
-        
-        current = current->next;
     }
-    
-    printf("\n%sAllocation complete! View all students to see results.%s\n", COLOR_GREEN, COLOR_RESET);
+    applyCutoffMoves(q);
+    free(finalSeats);
+    free(delta);
+    return evaluated;
+}
+
+// Asks which reserved seat pools a student qualifies for
+static void inputCategories(Queue* q, StudentId student) {
+    while (getchar() != '\n');  // Clear input buffer
+    while (1) {
+        printf("Seat pools besides %s (", seatPoolNames[0]);
+        for (int k = 1; k < seatPoolCount; k++)
+            printf("%s%s", k > 1 ? ", " : "", seatPoolNames[k]);
+        printf("), comma separated, blank for none: ");
+
+        char line[128];
+        if (fgets(line, sizeof(line), stdin) == NULL) return;
+        if (parsePoolList(line, &q->students.categories[student])) return;
+        printf("%sError: Unknown seat pool.%s\n", COLOR_RED, COLOR_RESET);
+    }
+}
+
+// A journaled change is only reported as done once it is on disk
+static void confirmJournaled(Queue* q, uint64_t sequence) {
+    if (q->journal != NULL && !journalSync(q->journal, sequence))
+        printf("%sWarning: The journal could not be written; this change is kept in memory only.%s\n",
+               COLOR_YELLOW, COLOR_RESET);
 }
 
 void addNewStudent(Queue* q, int* student_count, int totalStudents) {
-    Student* newStudent = (Student*)malloc(sizeof(Student));
+    StudentId newStudent = allocStudent(q);
+    StudentStore* store = &q->students;
+    char* reg_number = store->reg_number[newStudent];
     printf("\n%s=== New Student Registration ===%s\n", COLOR_YELLOW, COLOR_RESET);
     printf("%sPlease enter the following details carefully%s\n\n", COLOR_BLUE, COLOR_RESET);
     
-    printf("1. Registration Number Format: DCXXX (e.g., DC101)\n");
+    printf("1. Registration Number Format: DC followed by 3-7 digits (e.g., DC101, DC1234567)\n");
     printf("2. Name: Maximum %d characters\n", MAX_NAME_LENGTH - 1);
     printf("3. Rank: Must be a unique number\n");
     printf("4. Date of Birth Format: DD-MM-YYYY\n");
@@ -304,40 +731,41 @@ void addNewStudent(Queue* q, int* student_count, int totalStudents) {
     char dob[15];
     char aadhar[15];
     
-    // Get and validate Registration Number (format: DCXXX)
+    // Get and validate Registration Number (format: DC + 3-7 digits)
     while (1) {
-        printf("Enter Registration Number (format: DCXXX): ");
-        scanf("%s", newStudent->reg_number);
-        
-        // Validate format: must be DC followed by 3 digits
-        if (strlen(newStudent->reg_number) != 5 || 
-            newStudent->reg_number[0] != 'D' || 
-            newStudent->reg_number[1] != 'C' ||
-            newStudent->reg_number[2] < '0' || newStudent->reg_number[2] > '9' ||
-            newStudent->reg_number[3] < '0' || newStudent->reg_number[3] > '9' ||
-            newStudent->reg_number[4] < '0' || newStudent->reg_number[4] > '9') {
-            printf("%sError: Registration number must be in format DCXXX (e.g., DC101)!%s\n", COLOR_RED, COLOR_RESET);
+        printf("Enter Registration Number (format: DC + 3-7 digits): ");
+        scanf("%9s", reg_number);
+
+        // Anything left of the word is an over-long number, not the next field
+        int c = getchar();
+        if (c != EOF && c != '\n' && c != ' ' && c != '\t') {
+            while (c != EOF && c != '\n') c = getchar();
+            printf("%sError: Registration number must be DC followed by 3-7 digits (e.g., DC101)!%s\n", COLOR_RED, COLOR_RESET);
+            continue;
+        }
+        if (c != EOF) ungetc(c, stdin);
+
+        // Validate format: must be DC followed by 3-7 digits
+        if (!isValidRegNumber(reg_number)) {
+            printf("%sError: Registration number must be DC followed by 3-7 digits (e.g., DC101)!%s\n", COLOR_RED, COLOR_RESET);
             continue;
         }
         
         // Check if registration number already exists
-        bool reg_exists = false;
-        for (int i = 0; i < verificationDataCount; i++) {
-            if (strcmp(verificationData[i].reg_number, newStudent->reg_number) == 0) {
-                printf("%sError: Registration Number %s already exists!%s\n", COLOR_RED, newStudent->reg_number, COLOR_RESET);
-                reg_exists = true;
-                break;
-            }
-        }
-        if (!reg_exists) {
-            break;
+        if (findVerificationByReg(reg_number) != NULL ||
+            findStudentByReg(reg_number) != NO_STUDENT) {
+            printf("%sError: Registration Number %s already exists!%s\n", COLOR_RED, reg_number, COLOR_RESET);
+            continue;
         }
+        break;
     }
     
     while (getchar() != '\n');  // Clear input buffer
     printf("Enter Student Name: ");
-    fgets(newStudent->name, MAX_NAME_LENGTH, stdin);
-    newStudent->name[strcspn(newStudent->name, "\n")] = 0;  // Remove newline
+    char name[MAX_NAME_LENGTH] = "";
+    fgets(name, MAX_NAME_LENGTH, stdin);
+    name[strcspn(name, "\n")] = 0;  // Remove newline
+    setStudentName(q, newStudent, name);
     
     int rank;
     while (1) {
@@ -347,13 +775,13 @@ void addNewStudent(Queue* q, int* student_count, int totalStudents) {
             while (getchar() != '\n');  // Clear input buffer
             continue;
         }
-        if (searchBST(q->rank_tree, rank) != NULL) {
+        if (rankExists(q, rank)) {
             printf("%sError: Rank %d is already taken!%s\n", COLOR_RED, rank, COLOR_RESET);
             continue;
         }
         break;
     }
-    newStudent->rank = rank;
+    store->rank[newStudent] = rank;
     
     while (getchar() != '\n');  // Clear input buffer
     
@@ -387,37 +815,62 @@ void addNewStudent(Queue* q, int* student_count, int totalStudents) {
         }
         
         // Check if Aadhar number already exists
-        bool aadhar_exists = false;
-        for (int i = 0; i < verificationDataCount; i++) {
-            if (strcmp(verificationData[i].aadhar, aadhar) == 0) {
-                printf("%sError: Aadhar Number %s already registered!%s\n", COLOR_RED, aadhar, COLOR_RESET);
-                aadhar_exists = true;
-                break;
-            }
-        }
-        if (!aadhar_exists) {
-            break;
+        if (findVerificationByAadhar(aadhar) != NULL) {
+            printf("%sError: Aadhar Number %s already registered!%s\n", COLOR_RED, aadhar, COLOR_RESET);
+            continue;
         }
+        break;
     }
     
+    // Set as verified and continue with preferences; the student is not
+    // linked anywhere until the registration has been journaled
+    store->flags[newStudent] |= STUDENT_VERIFIED;
+    if (seatPoolCount > 1)
+        inputCategories(q, newStudent);
+    inputPreferences(q, newStudent);
+    store->allocated_program[newStudent] = PROGRAM_NOT_ALLOCATED;
+    uint64_t sequence = 0;
+    if (q->journal != NULL)
+        sequence = journalRegistration(q->journal, q, newStudent, dob, aadhar);
+
     // Add to verification data
-    if (!addToVerificationData(newStudent->reg_number, newStudent->name, dob, aadhar)) {
-        printf("\n%sError: Could not add to verification data. Maximum limit reached.%s\n", COLOR_RED, COLOR_RESET);
-        free(newStudent);
+    if (!addToVerificationData(reg_number, name, dob, aadhar)) {
+        printf("\n%sError: Could not add to verification data.%s\n", COLOR_RED, COLOR_RESET);
+        releaseStudent(q, newStudent);
         return;
     }
-
-    // Set as verified and continue with preferences
-    newStudent->verified = true;
-    inputPreferences(newStudent);
-    strcpy(newStudent->allocated_college, "Not Allocated");
-    strcpy(newStudent->allocated_branch, "NA");
     enqueue(q, newStudent);
     (*student_count)++;
+    confirmJournaled(q, sequence);
     printf("\n%sStudent added successfully!%s\n", COLOR_GREEN, COLOR_RESET);
 
 }
 
+// Queues the seed records of verificationData[] as students ranked 1-5,
+// as every new session starts
+void preregisterSeedStudents(Queue* q) {
+    StudentStore* store = &q->students;
+    for (int i = 0; i < 5; i++) {
+        StudentId newStudent = allocStudent(q);
+        strcpy(store->reg_number[newStudent], verificationData[i].reg_number);
+        setStudentName(q, newStudent, verificationData[i].name);
+        store->rank[newStudent] = (i + 1);
+        store->flags[newStudent] = STUDENT_VERIFIED;
+        store->num_preferences[newStudent] = 0;
+        store->allocated_program[newStudent] = PROGRAM_NOT_ALLOCATED;
+        enqueue(q, newStudent);
+    }
+}
+
+// Records a preference change made to a queued student and refreshes an
+// existing allocation from that student's rank onwards. Returns the number
+// of students re-evaluated, or -1 if there was no allocation to refresh.
+int commitPreferenceUpdate(Queue* q, StudentId student) {
+    opLogAppend(q->operation_log, OP_UPDATE_PREFERENCES, q->students.rank[student], PROGRAM_NOT_ALLOCATED);
+    noteRoundChange(q, student);
+    return reallocateFromStudent(q, student);
+}
+
 void updateStudentPreferences(Queue* q) {
     printf("\n%s=== Update Student Preferences ===%s\n", COLOR_YELLOW, COLOR_RESET);
     printf("%sPlease verify your identity%s\n\n", COLOR_BLUE, COLOR_RESET);
@@ -427,35 +880,18 @@ void updateStudentPreferences(Queue* q) {
     scanf("%s", reg_number);
     
     // Find student in queue
-    Student* current = q->front;
-    Student* found_student = NULL;
+    StudentStore* store = &q->students;
+    StudentId found_student = findStudentByReg(reg_number);
     
-    while (current != NULL) {
-        if (strcmp(current->reg_number, reg_number) == 0) {
-            found_student = current;
-            break;
-        }
-        current = current->next;
-    }
-    
-    if (!found_student) {
+    if (found_student == NO_STUDENT) {
         printf("\n%sError: Student with registration number %s not found!%s\n", 
                COLOR_RED, reg_number, COLOR_RESET);
         return;
     }
     
     // Find verification data
-    bool found_verification = false;
-    StudentData* vData = NULL;
-    for (int i = 0; i < verificationDataCount; i++) {
-        if (strcmp(reg_number, verificationData[i].reg_number) == 0) {
-            vData = &verificationData[i];
-            found_verification = true;
-            break;
-        }
-    }
-    
-    if (!found_verification) {
+    StudentData* vData = findVerificationByReg(reg_number);
+    if (vData == NULL) {
         printf("%sError: Verification data not found!%s\n", COLOR_RED, COLOR_RESET);
         return;
     }
@@ -479,17 +915,18 @@ void updateStudentPreferences(Queue* q) {
     
     // Display current student info
     printf("\n%sStudent Information:%s\n", COLOR_GREEN, COLOR_RESET);
-    printf("Name: %s\n", found_student->name);
-    printf("Rank: %d\n", found_student->rank);
+    printf("Name: %s\n", STUDENT_NAME(store, found_student));
+    printf("Rank: %d\n", store->rank[found_student]);
     
     // Display current preferences if any
-    if (found_student->num_preferences > 0) {
+    if (store->num_preferences[found_student] > 0) {
         printf("\nCurrent Preferences:\n");
-        for (int i = 0; i < found_student->num_preferences; i++) {
+        const uint16_t* prefs = STUDENT_PREFS(q, found_student);
+        for (int i = 0; i < store->num_preferences[found_student]; i++) {
             printf("%d. %s - %s\n", 
                    i + 1,
-                   colleges[found_student->preferences[i].college_index].name,
-                   found_student->preferences[i].branch);
+                   programCollegeName(prefs[i]),
+                   programBranchName(prefs[i]));
         }
     }
     
@@ -500,15 +937,25 @@ void updateStudentPreferences(Queue* q) {
     scanf("%c", &choice);
     
     if (choice == 'y' || choice == 'Y') {
-        // Reset preferences and input new ones
-        found_student->num_preferences = 0;
-        inputPreferences(found_student);
+        // Input new preferences; they replace the old list once journaled
+        uint16_t* choices = (uint16_t*)malloc(MAX_PREFERENCES * sizeof(uint16_t));
+        choosePreferences(q, found_student, choices);
+        uint64_t sequence = 0;
+        if (q->journal != NULL)
+            sequence = journalPreferences(q->journal, reg_number, choices, MAX_PREFERENCES);
+        setStudentPreferences(q, found_student, choices, MAX_PREFERENCES);
+        free(choices);
+        confirmJournaled(q, sequence);
         printf("\n%sPreferences updated successfully!%s\n", COLOR_GREEN, COLOR_RESET);
         
-        // Log the operation
-        char operation[100];
-        sprintf(operation, "Updated preferences for student %s", found_student->reg_number);
-        pushOperation(q->operation_log, operation);
+        int evaluated = commitPreferenceUpdate(q, found_student);
+        if (evaluated >= 0) {
+            printf("%sAllocation refreshed: %d student(s) re-evaluated from rank %d.%s\n",
+                   COLOR_GREEN, evaluated, store->rank[found_student], COLOR_RESET);
+        } else if (q->rounds != NULL) {
+            printf("%sThe change takes effect in round %d.%s\n",
+                   COLOR_YELLOW, q->rounds->round_count + 1, COLOR_RESET);
+        }
     } else {
         printf("\n%sPreferences update cancelled.%s\n", COLOR_YELLOW, COLOR_RESET);
     }
@@ -521,7 +968,7 @@ void displaySystemStatus(Queue* q) {
     // Display college preference counts
     printf("College Preferences:\n");
     printf("-------------------\n");
-    for (int i = 0; i < MAX_COLLEGES; i++) {
+    for (int i = 0; i < collegeCount; i++) {
         printf("%s: %d preferences\n", 
                colleges[i].name, 
                colleges[i].preference_count);
@@ -530,66 +977,98 @@ void displaySystemStatus(Queue* q) {
     // Display recent operations
     printf("\nRecent Operations:\n");
     printf("------------------\n");
-    OpNode* current = q->operation_log->top;
-    int count = 0;
-    while (current != NULL && count < 5) {
-        printf("- %s\n", current->operation);
-        current = current->next;
-        count++;
+    OpRecord recent[5];
+    int count = opLogRecent(q->operation_log, recent, 5);
+    for (int i = 0; i < count; i++) {
+        char text[128];
+        formatOpRecord(&recent[i], text, sizeof(text));
+        if (recent[i].op == OP_ALLOCATE) {
+            printf("- %s (%s - %s)\n", text,
+                   programCollegeName(recent[i].program_id),
+                   programBranchName(recent[i].program_id));
+        } else {
+            printf("- %s\n", text);
+        }
     }
-}
+    printf("Total operations logged: %llu\n",
+           (unsigned long long)opLogCount(q->operation_log));
+
+    printf("\nAllocation engine: %s", allocationEngineName(currentAllocationEngine()));
+    const AllocationState* state = q->allocation;
+    if (state->valid && state->engine == ALLOCATION_DEFERRED)
+        printf(" (last run: %ld proposal(s), %ld displaced, %.2f ms)", state->deferred.proposals,
+               state->deferred.displaced, state->deferred.seconds * 1000.0);
+    printf("\n");
 
-// Forward declaration for BST freeing
-static void freeBSTTree(BSTNode* root);
+    // Pool usage: idle is the share of reserved slots not holding a record
+    printf("\nMemory Pools:\n");
+    printf("-------------\n");
+    printf("%-14s %10s %10s %7s %12s %8s %12s %10s\n",
+           "Pool", "Live", "Reserved", "Blocks", "KB", "Idle", "Allocs", "Frees");
+    poolReport(&q->rank_tree->nodes, "Rank nodes");
+    printf("Preference pool: %zu ids in use, %zu stale (%.1f KB)\n",
+           q->preferences.used - q->preferences.stale, q->preferences.stale,
+           q->preferences.capacity * sizeof(uint16_t) / 1024.0);
+    studentStoreReport(&q->students);
+    coPreferenceReport(q);
 
-// Recursive function to free BST nodes
-static void freeBSTTree(BSTNode* root) {
-    if (root == NULL) return;
-    freeBSTTree(root->left);
-    freeBSTTree(root->right);
-    free(root);
+    printf("\nHot-path Metrics:\n");
+    printf("-----------------\n");
+    metricsReport();
 }
 
-// Cleanup function to free all allocated memory
+// Cleanup function to free all allocated memory. Every record type lives in
+// a pool or a column store, so this is a handful of block releases rather
+// than a walk over each structure.
 void cleanupQueue(Queue* q) {
     if (q == NULL) return;
+    METRIC_SPAN_BEGIN(cleanup);
     
-    // Free all students in the linked list
-    Student* current = q->front;
-    while (current != NULL) {
-        Student* temp = current;
-        current = current->next;
-        free(temp);
-    }
-    
-    // Free all BST nodes
-    freeBSTTree(q->rank_tree);
-    
-    // Free all college graph nodes
-    if (q->college_network != NULL) {
-        for (int i = 0; i < MAX_COLLEGES; i++) {
-            CollegeNode* node = q->college_network->adjacency_list[i];
-            while (node != NULL) {
-                CollegeNode* temp = node;
-                node = node->next;
-                free(temp);
-            }
-        }
-        free(q->college_network->adjacency_list);
-        free(q->college_network);
+    // Drop counselling round state while the students still exist
+    discardRounds(q);
+    
+    // Release all students
+    forgetIndexedStudents();
+    studentStoreRelease(&q->students);
+    snapshotFree(q->preferences.ids);
+    
+    // Free the rank buckets
+    if (q->rank_slots != NULL) {
+        for (int i = 0; i < q->rank_slots->page_count; i++)
+            snapshotFree(q->rank_slots->pages[i]);
+        free(q->rank_slots->pages);
+        free(q->rank_slots);
     }
     
-    // Free all operation log nodes
-    if (q->operation_log != NULL) {
-        OpNode* op = q->operation_log->top;
-        while (op != NULL) {
-            OpNode* temp = op;
-            op = op->next;
-            free(temp);
-        }
-        free(q->operation_log);
+    // Release the rank index
+    if (q->rank_tree != NULL) {
+        poolRelease(&q->rank_tree->nodes);
+        snapshotFree(q->rank_tree->bitmap);
+        free(q->rank_tree);
     }
     
+    // Release the co-preference matrix
+    if (q->co_preferences != NULL) {
+        coPreferenceRelease(q->co_preferences);
+        free(q->co_preferences);
+    }
+    
+    // Sync and close the journal, then the operation log
+    journalClose(q->journal);
+    opLogDestroy(q->operation_log);
+    
+    // Free the allocation checkpoints
+    if (q->allocation != NULL) {
+        snapshotFree(q->allocation->ranks);
+        snapshotFree(q->allocation->seats);
+        releaseSeatPools(q->allocation->pools);
+        releaseCutoffs(q->allocation->cutoffs);
+        free(q->allocation);
+    }
+    releaseCollegePriorities(q->priorities);
+    
     // Free the queue itself
     free(q);
-}
\ No newline at end of file
+    METRIC_COUNT(METRIC_CLEANUPS);
+    METRIC_SPAN_END(cleanup, METRIC_CLEANUP_NS);
+}
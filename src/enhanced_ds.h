@@ -1,15 +1,18 @@
 #ifndef ENHANCED_DS_H
 #define ENHANCED_DS_H
 
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 // Constants
-#define MAX_COLLEGES 4
+#define MAX_PROGRAMS 65535  // Program ids are stored as uint16_t
 #define MAX_NAME_LENGTH 50
 #define MAX_REG_LENGTH 10
-#define MAX_VERIFICATION_DATA 100
 
-// Global variable for MAX_PREFERENCES (set from command line)
+// Global variable for MAX_PREFERENCES (set from command line, at most the
+// number of programs in the catalog)
 extern int MAX_PREFERENCES;
 
 // ANSI color codes
@@ -27,84 +30,845 @@ typedef struct {
     char aadhar[15];
 } StudentData;
 
-extern StudentData verificationData[MAX_VERIFICATION_DATA];
+extern StudentData* verificationData;  // Grows on demand
 extern int verificationDataCount;
 
-// BST for rank tracking
+// Typed slab pools (arena.c): fixed-size records are carved from large
+// blocks, freed records are kept on a free list for reuse, and a pool is
+// released block by block instead of record by record.
+typedef struct SlabBlock SlabBlock;
+
+typedef struct {
+    size_t item_size;     // Rounded up to the platform alignment
+    int items_per_block;
+    SlabBlock* blocks;    // Newest first; only the newest has unused slots
+    int block_used;       // Slots carved from the newest block
+    void* free_list;      // Freed records, reused before carving
+    int block_count;
+    long live;            // Records currently handed out
+    long allocations;     // poolAlloc calls since the pool was set up
+    long frees;
+} SlabPool;
+
+void poolInit(SlabPool* pool, size_t itemSize, int itemsPerBlock);
+void* poolAlloc(SlabPool* pool);
+void poolFree(SlabPool* pool, void* item);
+void poolRelease(SlabPool* pool);
+void poolReport(const SlabPool* pool, const char* label);
+
+#define RANK_NODE_POOL_BLOCK  1024
+
+// Students are numbered densely from 0 and every per-student field lives
+// in a column of the queue's StudentStore, indexed by that number.
+typedef int32_t StudentId;
+#define NO_STUDENT (-1)
+
+// Balanced (AVL) BST for rank tracking. Nodes come from the index's own
+// pool, so insert, search and free need no recursion.
+#define RANK_BITMAP_MIN (1 << 20)  // Ranks always covered by the bitmap
+
 typedef struct BSTNode {
     int rank;
-    struct Student* student;
+    int height;
+    StudentId student;
     struct BSTNode* left;
     struct BSTNode* right;
 } BSTNode;
 
-// Graph for college network
-typedef struct CollegeNode {
-    int college_id;
-    int preference_weight;
-    struct CollegeNode* next;
-} CollegeNode;
+// Rank index: the tree answers ordered lookups for any rank, and a
+// direct-mapped bitmap answers "is this rank taken" in O(1) for the
+// dense range [0, bitmap_limit).
+typedef struct {
+    BSTNode* root;
+    SlabPool nodes;
+    uint64_t* bitmap;
+    long bitmap_limit;
+    int count;
+    bool tree_pending;  // Loaded from a snapshot: bitmap and count only
+} RankIndex;
+
+// Co-preference matrix: weight (a, b) is the number of queued students
+// listing program b right after program a. Dense up to
+// COPREF_DENSE_PROGRAMS programs, one run of nonzero edges per row beyond.
+#define COPREF_DENSE_PROGRAMS 2048
+#define COPREF_TOP 8  // Heaviest successors cached per row
 
 typedef struct {
-    CollegeNode** adjacency_list;
-} CollegeGraph;
+    uint16_t program;
+    uint32_t weight;
+} CoPrefEdge;
 
-// Stack for operation logging
-typedef struct OpNode {
-    char operation[100];
-    struct OpNode* next;
-} OpNode;
+typedef struct {
+    CoPrefEdge* edges;
+    int count;
+    int capacity;
+} CoPrefRow;
 
 typedef struct {
-    OpNode* top;
-} OpStack;
+    int programs;            // Matrix side; programCount when built
+    uint32_t* dense;         // programs * programs, row = earlier choice
+    CoPrefRow* rows;         // Instead of dense for a large catalog
+    uint64_t* outflow;       // Row sums
+    uint64_t* inflow;        // Column sums
+    uint32_t* first_choice;  // Students listing the program first
+    uint16_t* top;           // COPREF_TOP cached successors per row
+    uint8_t* top_count;
+    uint8_t* top_stale;      // Row changed since its successors were taken
+    bool pending;            // Built from the queue on first use
+} CoPreferenceMatrix;
+
+// Operation log: a fixed-size ring of compact binary records, flushed to
+// an append-only file by a background writer thread (oplog.c). Records
+// are only turned into text when the log is read.
+#define OPLOG_CAPACITY (1 << 16)  // Records held in memory, power of two
+#define OPLOG_MAGIC    0x4C4F4B44454D4F43ULL  // "COMEDKOL" on disk
+#define OPLOG_VERSION  1
+
+typedef enum {
+    OP_QUEUE_INIT = 1,
+    OP_ENQUEUE,
+    OP_ALLOCATE,
+    OP_NOT_ALLOCATED,
+    OP_UPDATE_PREFERENCES,
+    OP_ROUND_STARTED,   // rank field holds the round number
+    OP_WITHDRAWN
+} OpCode;
 
-// Original structures enhanced with internal tracking
 typedef struct {
-    int college_index;
-    char branch[4];  // CSE or ECE
-    int preference_weight;  // Added for preference tracking
-} Preference;
+    uint64_t timestamp_ns;  // Wall clock, nanoseconds since the epoch
+    int32_t rank;
+    int32_t program_id;
+    uint8_t op;             // OpCode
+    uint8_t reserved[7];
+} OpRecord;                 // 24 bytes on disk
 
-typedef struct Student {
-    char reg_number[MAX_REG_LENGTH];
-    char name[MAX_NAME_LENGTH];
-    int rank;
-    bool verified;
-    Preference preferences[8];  // Fixed size to accommodate max 8 preferences
-    int num_preferences;
-    char allocated_college[MAX_NAME_LENGTH];
-    char allocated_branch[4];
-    struct Student* next;
-    BSTNode* rank_node;  // Link to BST node
-} Student;
+typedef struct {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t record_size;
+} OpLogFileHeader;
+
+typedef struct OpLog OpLog;
 
+// Write-ahead journal of registrations and preference edits (journal.c)
+typedef struct Journal Journal;
+
+// Catalog (catalog.c): every (college, branch) pair offered is a program
+// with a compact integer id, and the allocation pass works on ids only.
+// Names are resolved through the program table for display.
 typedef struct {
     char name[MAX_NAME_LENGTH];
-    int seats_cse;
-    int seats_ece;
     int preference_count;  // Track how often this college is preferred
+    int first_program;     // Programs of a college have consecutive ids
+    int program_count;
 } College;
 
-// Queue structure (Priority Queue)
 typedef struct {
-    Student* front;
-    BSTNode* rank_tree;  // BST root
-    CollegeGraph* college_network;  // College preference graph
-    OpStack* operation_log;  // Operation history
+    char name[MAX_NAME_LENGTH];
+} Branch;
+
+typedef struct {
+    uint16_t college;  // Index into colleges
+    uint16_t branch;   // Index into branches
+} Program;
+
+extern College* colleges;
+extern int collegeCount;
+extern Branch* branches;
+extern int branchCount;
+extern Program* programs;
+extern int programCount;
+
+#define PROGRAM_COLLEGE(program_id) (programs[(program_id)].college)
+#define PROGRAM_BRANCH(program_id)  (programs[(program_id)].branch)
+
+// Allocation results that are not a program id
+#define PROGRAM_NOT_ALLOCATED (-1)
+#define PROGRAM_NOT_ELIGIBLE  (-2)
+
+// Column store for student records. The hot columns are everything an
+// allocation pass touches, so it streams through a few dense arrays; the
+// cold columns are only read for display and lookups. A student's
+// preferences are a run of program ids in the queue's PreferencePool.
+#define STUDENT_VERIFIED 0x01  // flags bit
+#define POOL_GENERAL     0x01  // categories bit of pool 0, always set
+
+typedef struct {
+    // Hot columns
+    int* rank;
+    int* allocated_program;   // Program id or PROGRAM_NOT_ALLOCATED/NOT_ELIGIBLE
+    uint32_t* pref_offset;    // Start of the run in the preference pool
+    uint16_t* num_preferences;
+    uint8_t* flags;           // STUDENT_VERIFIED
+    uint8_t* round_status;    // RoundResponse in effect, ROUND_FLOAT by default
+    uint8_t* categories;      // Seat pools the student may take, bit k = pool k
+    uint8_t* allocated_pool;  // Pool of the allocated seat
+    StudentId* next;          // Queue order; also chains released ids
+    // Cold columns
+    char (*reg_number)[MAX_REG_LENGTH];
+    uint32_t* name;           // Offset of the name in the names heap
+    char* names;              // Names stored back to back, NUL-terminated
+    size_t names_used;
+    size_t names_capacity;
+    size_t names_stale;       // Bytes of replaced or released names
+    int count;                // Ids handed out, live or released
+    int capacity;
+    int live;
+    StudentId free_list;      // Released ids, reused first
+} StudentStore;
+
+#define STUDENT_NAME(store, id) ((store)->names + (store)->name[(id)])
+#define STUDENT_STORE_INITIAL 1024
+
+// Flat seat matrix indexed by program id, programCount entries
+extern int* programCapacity;  // Configured seats
+extern int* programSeats;     // Seats left after allocation
+
+// Seat pools (category quotas). A catalog may split every program's seats
+// into up to MAX_SEAT_POOLS pools; pool 0 is general merit and open to
+// everyone, the others only to students with that categories bit. With a
+// single pool the pool arrays stay NULL and programCapacity/programSeats
+// are the whole seat matrix; otherwise those hold the per-program totals
+// and the pool arrays are pool-major, entry k * programCount + p.
+#define MAX_SEAT_POOLS   8
+#define POOL_NAME_LENGTH 16
+
+extern int seatPoolCount;
+extern char seatPoolNames[MAX_SEAT_POOLS][POOL_NAME_LENGTH];
+extern int* poolCapacity;
+extern int* poolSeats;
+
+// Shared store for preference lists: each student owns a run of program
+// ids. An edit that fits reuses the run; a longer list gets a new run and
+// the old one is counted as stale.
+typedef struct {
+    uint16_t* ids;
+    size_t used;
+    size_t capacity;
+    size_t stale;
+} PreferencePool;
+
+// Rank-bucketed queue index: ranks are dense integers, so each rank maps
+// directly to a slot. Pages of slots are allocated on demand so a stray
+// large rank does not reserve memory for every rank below it.
+#define RANK_PAGE_BITS 10
+#define RANK_PAGE_SIZE (1 << RANK_PAGE_BITS)
+
+typedef struct {
+    StudentId slots[RANK_PAGE_SIZE];
+    int count;  // Occupied slots, lets empty pages be skipped quickly
+} RankPage;
+
+typedef struct {
+    RankPage** pages;
+    int page_count;  // Length of the pages directory
+} RankBuckets;
+
+// Seat-state checkpoints from the last full allocation. Checkpoint i holds
+// the seats left just before the student with rank ranks[i]; one is taken
+// every CHECKPOINT_INTERVAL students so a re-run can resume mid-queue.
+#define CHECKPOINT_INTERVAL 1024
+
+typedef struct SeatPoolRun SeatPoolRun;  // pools.c
+typedef struct CutoffTable CutoffTable;  // cutoffs.c
+
+// How a full allocation assigns seats. Serial dictatorship hands out seats
+// in global rank order; deferred acceptance lets each program and pool
+// rank its applicants by its own priorities (deferred.c).
+typedef enum {
+    ALLOCATION_SERIAL = 0,
+    ALLOCATION_DEFERRED
+} AllocationEngine;
+
+typedef struct {
+    long proposers;    // Verified students
+    long proposals;    // Options tried, over all proposers
+    long rejections;   // Proposals turned down, at once or later
+    long displaced;    // Held candidates bumped by a higher priority
+    double seconds;
+} DeferredStats;
+
+typedef struct {
+    int* ranks;
+    int* seats;     // count x programCount, row i belongs to ranks[i]
+    int count;
+    int capacity;
+    bool valid;     // False once the queue changes after an allocation
+    double seconds; // Duration of the last full allocation
+    SeatPoolRun* pools;  // Pool results of the last pooled allocation
+    CutoffTable* cutoffs;  // Closing ranks of the current allotment
+    AllocationEngine engine;  // Engine of the last full allocation
+    DeferredStats deferred;   // Its run, if that was deferred acceptance
+} AllocationState;
+
+// Multi-round counselling (rounds.c). After each round a student may
+// accept the seat, float (keep it but take a better preference if one
+// frees up) or exit (give it up). Later rounds only move students into
+// seats that came free, so nobody is ever downgraded.
+typedef enum {
+    ROUND_FLOAT = 0,
+    ROUND_ACCEPT,
+    ROUND_EXIT
+} RoundResponse;
+
+typedef struct {
+    StudentId student;
+    int from_program;
+    int to_program;
+} RoundChange;
+
+typedef struct {
+    int number;
+    int* seats;               // Seats left when the round closed
+    RoundChange* changes;     // Outcomes that differ from the previous round
+    int change_count;
+    int change_capacity;
+    int touched;              // Students evaluated by the round
+    int upgrades;             // Seat holders moved to a better preference
+    int placed;               // Students given their first seat
+    int exits;
+    int accepts;
+    double seconds;
+} RoundSnapshot;
+
+// Students listing one program, in rank order. Entries before cursor can
+// no longer be moved into the program: students only move up or leave.
+typedef struct {
+    StudentId* students;
+    int count;
+    int capacity;
+    int cursor;
+} InterestList;
+
+typedef struct {
+    StudentId student;
+    RoundResponse response;
+} PendingResponse;
+
+typedef struct {
+    RoundSnapshot* rounds;
+    int round_count;
+    int round_capacity;
+    InterestList* interest;      // One list per program
+    int64_t* heap;               // Open programs keyed by head rank
+    int* heap_rank;              // Key of each program's live entry, -1 if none
+    int heap_count;
+    int heap_capacity;
+    PendingResponse* responses;  // Recorded since the last round
+    int response_count;
+    int response_capacity;
+    StudentId* changed;          // Enqueued or edited since the last round
+    int changed_count;
+    int changed_capacity;
+} RoundState;
+
+typedef struct CollegePriorities CollegePriorities;  // deferred.c
+
+// Queue structure (Priority Queue). Students linked into a queue must come
+// from its store (allocStudent); cleanupQueue releases them in bulk.
+typedef struct {
+    StudentId front;
+    StudentStore students;  // Student records owned by this queue
+    PreferencePool preferences;  // Preference runs of those students
+    RankBuckets* rank_slots;  // Rank -> Student, used for O(1) placement
+    RankIndex* rank_tree;  // Balanced rank tree + dense bitmap
+    CoPreferenceMatrix* co_preferences;  // Program-to-next-program weights
+    OpLog* operation_log;  // Operation history
+    AllocationState* allocation;  // Checkpoints for incremental re-runs
+    RoundState* rounds;  // NULL until round 1 closes
+    CollegePriorities* priorities;  // NULL = every seat ranks by global rank
+    Journal* journal;  // NULL unless journaling
+    uint64_t journal_sequence;  // Last journal record reflected when loaded;
+                                // the open journal counts on from here
 } Queue;
 
+// Program ids a student listed, best first; num_preferences entries
+#define STUDENT_PREFS(q, id) ((q)->preferences.ids + (q)->students.pref_offset[(id)])
+
 // Function declarations
 Queue* createQueue(void);
-void enqueue(Queue* q, Student* newStudent);
-void displayStudents(Student* head);
-bool verifyStudent(Student* student);
+void studentStoreInit(StudentStore* store);
+void studentStoreRelease(StudentStore* store);
+void studentStoreReport(const StudentStore* store);
+void renumberStudents(Queue* q, const StudentId* order, int count);
+StudentId allocStudent(Queue* q);
+void releaseStudent(Queue* q, StudentId student);  // Only for students never enqueued
+void setStudentName(Queue* q, StudentId student, const char* name);
+void enqueue(Queue* q, StudentId newStudent);
+int enqueueBulk(Queue* q, StudentId* students, int count);
+bool rankExists(Queue* q, int rank);
+void displayStudents(Queue* q);
+bool verifyStudent(Queue* q, StudentId student);
 bool addToVerificationData(const char* reg_number, const char* name, const char* dob, const char* aadhar);
-void inputPreferences(Student* student);
+void preregisterSeedStudents(Queue* q);
+void inputPreferences(Queue* q, StudentId student);
+void setStudentPreferences(Queue* q, StudentId student, const uint16_t* ids, int count);
 void displayColleges(void);
 void processAllocation(Queue* q);
+int reallocateFromStudent(Queue* q, StudentId changed);
+void logAllocation(Queue* q, StudentId student);
+int commitPreferenceUpdate(Queue* q, StudentId student);
+double monotonicSeconds(void);
 void displaySystemStatus(Queue* q);
 void updateStudentPreferences(Queue* q);  // New function for updating preferences
 void cleanupQueue(Queue* q);  // Cleanup function to free all allocated memory
+bool loadCatalog(const char* path);
+void releaseCatalog(void);
+void initializeColleges(int totalStudents);
+const char* programCollegeName(int program_id);
+const char* programBranchName(int program_id);
+void distributeSeats(int totalStudents);
+bool parsePoolList(char* text, uint8_t* categories);
+const char* seatPoolName(int pool);
+
+// Seat pool allocation (pools.c)
+int allocateSeatPools(Queue* q);
+int reallocateSeatPools(Queue* q, StudentId changed);
+void releaseSeatPools(SeatPoolRun* run);
+
+// Deferred acceptance (deferred.c). A priority file holds one
+// reg_number,choice,priority[,pool] per line; a lower priority is better,
+// a line without a pool covers every pool of the program, and students a
+// seat does not list come after the listed ones in rank order.
+void setAllocationEngine(AllocationEngine engine);
+AllocationEngine currentAllocationEngine(void);
+bool parseAllocationEngine(const char* text, AllocationEngine* engine);
+const char* allocationEngineName(AllocationEngine engine);
+bool loadCollegePriorities(Queue* q, const char* path, long* loaded, long* rejected);
+void releaseCollegePriorities(CollegePriorities* priorities);
+void allocateDeferred(Queue* q, DeferredStats* stats);
+int reallocateDeferred(Queue* q);
+
+// Cutoff index (cutoffs.c). Queries take a set of seat pools as a
+// categories mask and never walk the students.
+#define CUTOFF_OPEN INT32_MAX  // Exhaustion rank of a program with seats left
+
+typedef struct {
+    int seats;
+    int filled;
+    int closing_rank;   // Last holder's rank, 0 if none
+    int exhausted_at;   // Rank that took the last seat, CUTOFF_OPEN if seats remain
+} CutoffSlotInfo;
+
+void buildCutoffs(Queue* q);
+void noteCutoffMove(Queue* q, int rank, int fromProgram, int fromPool, int toProgram, int toPool);
+void applyCutoffMoves(Queue* q);
+void releaseCutoffs(CutoffTable* table);
+int closingRank(const CutoffTable* table, int program_id, uint8_t categories);
+int exhaustionRank(const CutoffTable* table, int program_id, uint8_t categories);
+int seatsLeftAtRank(const CutoffTable* table, int program_id, uint8_t categories, int rank);
+int reachablePrograms(const CutoffTable* table, int rank, uint8_t categories, uint16_t* out);
+void cutoffSlotInfo(const CutoffTable* table, int program_id, int pool, CutoffSlotInfo* info);
+void cutoffMenu(Queue* q);
+
+// What-if simulation (whatif.c). A snapshot is an immutable copy of the
+// allotment; simulations against it never touch the queue or the seat
+// matrix and may run side by side.
+typedef struct AllocationSnapshot AllocationSnapshot;
+
+typedef struct {
+    StudentId student;
+    const uint16_t* preferences;  // Hypothetical list, best first
+    int count;
+} WhatIfEdit;
+
+typedef struct {
+    int program_id;        // Seat the student would get, or PROGRAM_NOT_*
+    int pool;
+    int previous_program;  // Seat held in the allotment
+    int previous_pool;
+    int displaced;         // Other students whose seat would change
+    int evaluated;         // Students replayed
+} WhatIfOutcome;
+
+AllocationSnapshot* takeAllocationSnapshot(Queue* q);
+void releaseAllocationSnapshot(AllocationSnapshot* snap);
+double simulateWhatIf(const AllocationSnapshot* snap, const WhatIfEdit* edits,
+                      WhatIfOutcome* outcomes, int count);
+void whatIfInteractive(Queue* q);
+
+// Co-preference matrix (coprefs.c)
+CoPreferenceMatrix* coPreferenceCreate(void);
+void coPreferenceRelease(CoPreferenceMatrix* m);
+void notePreferenceList(Queue* q, const uint16_t* ids, int count, int delta);
+uint32_t preferenceFlow(Queue* q, int from, int to);
+int topCoPreferred(Queue* q, int program, uint16_t* out, uint32_t* weights);
+void coPreferenceReport(Queue* q);
+void preferenceFlowMenu(Queue* q);
+
+// Hot-path metrics (metrics.c). Counters are relaxed atomic adds, each on
+// its own cache line; timing spans and per-item values go into log2
+// histograms. Building with -DCOMEDK_NO_METRICS turns every METRIC_ macro
+// into nothing, so instrumented code pays nothing at all.
+#define METRIC_BUCKETS 40  // Bucket b holds values below 2^b; the last one is open
+
+typedef enum {
+    METRIC_ENQUEUES,
+    METRIC_RANK_BITMAP_LOOKUPS,  // Answered by the rank bitmap
+    METRIC_RANK_TREE_LOOKUPS,    // Beyond the bitmap, answered by the AVL tree
+    METRIC_VERIFY_PASSED,        // Interactive verification
+    METRIC_VERIFY_FAILED,
+    METRIC_CLAIM_CHECKS,         // checkVerificationClaim
+    METRIC_ALLOCATION_RUNS,
+    METRIC_PREFERENCE_PROBES,    // Preferences looked at by full allocation runs
+    METRIC_SEATS_EXHAUSTED,      // Probes that found the program full
+    METRIC_DISPLACEMENTS,        // Deferred acceptance: held seats taken back
+    METRIC_ALLOCATED,
+    METRIC_NOT_ALLOCATED,        // Every preference full
+    METRIC_NOT_ELIGIBLE,         // Not verified
+    METRIC_CLEANUPS,
+    METRIC_COUNTER_COUNT
+} MetricCounter;
+
+typedef enum {
+    METRIC_ENQUEUE_NS,
+    METRIC_BULK_ENQUEUE_NS,      // One enqueueBulk call
+    METRIC_RANK_TREE_NS,
+    METRIC_CLAIM_CHECK_NS,
+    METRIC_ALLOCATION_NS,
+    METRIC_PROBES_PER_STUDENT,
+    METRIC_CLEANUP_NS,
+    METRIC_HISTOGRAM_COUNT
+} MetricHistogram;
+
+typedef struct {
+    _Atomic uint64_t value;
+    char pad[56];
+} MetricSlot;
+
+extern MetricSlot metricCounters[METRIC_COUNTER_COUNT];
+
+// Histogram filled by one thread, merged into the shared one in one go
+typedef struct {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+    uint64_t buckets[METRIC_BUCKETS];
+} MetricBlock;
+
+uint64_t metricNow(void);  // Monotonic nanoseconds
+void metricRecord(MetricHistogram histogram, uint64_t value);
+void metricBlockRecord(MetricBlock* block, uint64_t value);
+void metricMerge(MetricHistogram histogram, const MetricBlock* block);
+bool metricsEnabled(void);
+void metricsReport(void);
+bool writeMetricsJson(const char* path);
+
+#ifndef COMEDK_NO_METRICS
+#define METRIC_ADD(counter, n) \
+    atomic_fetch_add_explicit(&metricCounters[(counter)].value, (uint64_t)(n), memory_order_relaxed)
+#define METRIC_SPAN_BEGIN(span)               uint64_t span##_started = metricNow()
+#define METRIC_SPAN_END(span, histogram)      metricRecord((histogram), metricNow() - span##_started)
+#define METRIC_BLOCK(block)                   MetricBlock block = { 0, 0, 0, { 0 } }
+#define METRIC_BLOCK_RECORD(block, value)     metricBlockRecord(&(block), (value))
+#define METRIC_BLOCK_MERGE(block, histogram)  metricMerge((histogram), &(block))
+#else
+#define METRIC_ADD(counter, n)                ((void)sizeof(n))
+#define METRIC_SPAN_BEGIN(span)               ((void)0)
+#define METRIC_SPAN_END(span, histogram)      ((void)0)
+#define METRIC_BLOCK(block)                   ((void)0)
+#define METRIC_BLOCK_RECORD(block, value)     ((void)sizeof(value))
+#define METRIC_BLOCK_MERGE(block, histogram)  ((void)0)
+#endif
+#define METRIC_COUNT(counter) METRIC_ADD((counter), 1)
+
+// Demand analytics (demand.c). Counts are over every registered student;
+// choices past DEMAND_POSITIONS share the last position bucket.
+#define DEMAND_POSITIONS  10
+#define DEMAND_RANK_BANDS 8
+
+extern const int demandBandLimits[DEMAND_RANK_BANDS];  // Highest rank of each band
+
+typedef struct {
+    int programs;
+    long candidates;
+    long verified;
+    long listed;              // Choices over all lists
+    long no_preferences;      // Candidates with an empty list
+    uint32_t* by_position;    // [program * DEMAND_POSITIONS + choice position]
+    uint32_t* by_band;        // [program * DEMAND_RANK_BANDS + band], any position
+    long band_candidates[DEMAND_RANK_BANDS];
+    int threads;              // Tasks the scan ran as
+    double seconds;
+} DemandReport;
+
+DemandReport* analyzeDemand(Queue* q);
+void releaseDemandReport(DemandReport* r);
+double oversubscription(const DemandReport* r, int program);
+bool writeDemandJson(const DemandReport* r, const char* path);
+void demandMenu(Queue* q);
+
+// Result export (export.c). Allotment, seat matrix and cutoff rows come
+// from one cursor, which the exporter and the paged terminal views share.
+#define EXPORT_PAGE_ROWS 25  // Rows per page of a terminal view
+
+typedef enum {
+    EXPORT_ALLOTMENT,  // One row per queued student, in rank order
+    EXPORT_SEATS,      // One row per program and seat pool
+    EXPORT_CUTOFFS     // One row per program and seat pool; needs an allotment
+} ExportTable;
+
+typedef enum {
+    EXPORT_CSV,
+    EXPORT_JSONL,
+    EXPORT_BINARY
+} ExportFormat;
+
+typedef struct {
+    int program;   // Program id, -1 = every program
+    int min_rank;  // 0 = no bound; students by rank, cutoffs by closing rank
+    int max_rank;
+} ExportFilter;
+
+typedef struct {
+    Queue* q;
+    ExportTable table;
+    ExportFilter filter;
+    StudentId student;  // Next student of an allotment
+    int slot;           // Next program * seatPoolCount + pool otherwise
+    int end;
+} ExportCursor;
+
+typedef struct {
+    StudentId student;  // Allotment rows only
+    int rank;
+    int program;        // Program id, or PROGRAM_NOT_ALLOCATED/NOT_ELIGIBLE
+    int pool;
+    int seats;          // Seat matrix and cutoff rows
+    int left;
+    int filled;
+    int closing_rank;
+    int exhausted_at;
+} ExportRow;
+
+typedef struct {
+    long rows;
+    uint64_t bytes;
+    double seconds;
+} ExportStats;
+
+// q may be NULL for the seat matrix; a NULL filter passes every row
+void exportCursorInit(ExportCursor* c, Queue* q, ExportTable table, const ExportFilter* filter);
+bool exportNext(ExportCursor* c, ExportRow* row);
+bool exportResults(Queue* q, ExportTable table, ExportFormat format, const ExportFilter* filter,
+                   const char* path, ExportStats* stats);
+bool parseExportFormat(const char* text, ExportFormat* format);
+bool parseRankRange(const char* text, ExportFilter* filter);
+bool pageRow(int* shown);
+void exportMenu(Queue* q);
+
+// State snapshot (snapshot.c). A snapshot file holds a whole session as
+// sections at fixed offsets, with no pointers in it. Loading maps it
+// copy-on-write and uses the sections in place; an array is copied out
+// of the mapping only when it first has to grow, which is what
+// snapshotRealloc/snapshotFree take care of for every array that may
+// come from a snapshot.
+#define SNAPSHOT_MAGIC   0x53534B44454D4F43ULL  // "COMEDKSS" on disk
+#define SNAPSHOT_VERSION 2
+
+bool saveSnapshot(Queue* q, const char* path);
+Queue* loadSnapshot(const char* path);
+void* snapshotRealloc(void* array, size_t used, size_t size);
+void snapshotFree(void* array);
+void releaseSnapshot(void);
+
+// Write-ahead journal (journal.c). A change is appended before it is
+// applied and acknowledged once journalSync says it is on disk; a writer
+// thread syncs whatever has piled up in one go. Opening the journal
+// replays it on top of the queue's state.
+#define JOURNAL_MAGIC   0x4A574B44454D4F43ULL  // "COMEDKWJ" on disk
+#define JOURNAL_VERSION 1
+
+typedef struct {
+    long replayed;    // Records applied to the queue
+    long rejected;    // Records that did not apply, as when they were made
+    long skipped;     // Records the snapshot already holds
+    long torn_bytes;  // Incomplete or corrupt tail cut off the file
+    double seconds;
+} JournalRecovery;
+
+Journal* journalOpen(Queue* q, const char* path, JournalRecovery* recovery);
+uint64_t journalRegistration(Journal* j, Queue* q, StudentId student, const char* dob, const char* aadhar);
+uint64_t journalPreferences(Journal* j, const char* reg_number, const uint16_t* ids, int count);
+bool journalSync(Journal* j, uint64_t sequence);
+uint64_t journalLastSequence(Journal* j);
+bool journalCheckpoint(Journal* j, uint64_t sequence);
+void journalStats(Journal* j, long* records, long* syncs);
+void journalClose(Journal* j);
+
+// Worker threads (workers.c)
+#define MAX_WORKER_THREADS 64
+
+typedef void (*ParallelTask)(void* context, int task);
+
+void setWorkerThreads(int threads);
+int workerThreadCount(void);
+void runParallel(ParallelTask task, void* context, int tasks);
+void stopWorkers(void);
+
+// Counselling rounds (rounds.c)
+bool recordRoundResponse(Queue* q, StudentId student, RoundResponse response);
+const RoundSnapshot* runNextRound(Queue* q);
+void noteRoundChange(Queue* q, StudentId student);
+void discardRounds(Queue* q);
+void displayRoundSummary(Queue* q);
+void counsellingRoundsMenu(Queue* q);
+const char* roundResponseName(RoundResponse response);
+
+// Outcome of checking a (reg, DOB, Aadhar) claim against verificationData
+typedef enum {
+    VERIFY_OK = 0,
+    VERIFY_UNKNOWN_REG,
+    VERIFY_DOB_MISMATCH,
+    VERIFY_AADHAR_MISMATCH
+} VerifyResult;
+
+VerifyResult checkVerificationClaim(const char* reg_number, const char* dob, const char* aadhar);
+
+// Verification store hash indexes (verification.c)
+uint64_t packRegNumber(const char* reg_number);
+uint64_t packAadhar(const char* aadhar);
+StudentData* findVerificationByReg(const char* reg_number);
+StudentData* findVerificationByAadhar(const char* aadhar);
+StudentId findStudentByReg(const char* reg_number);
+void indexStudent(const char* reg_number, StudentId student);
+void forgetIndexedStudents(void);
+void removeFromVerificationData(const char* reg_number);
+
+typedef struct {
+    void* entries;      // capacity records of entry_size bytes
+    int capacity;
+    int count;
+    size_t entry_size;
+} HashIndexImage;
+
+void verificationIndexImages(HashIndexImage* reg, HashIndexImage* aadhar);
+void adoptVerificationData(StudentData* data, int count,
+                           const HashIndexImage* reg, const HashIndexImage* aadhar);
+
+// Operation log (oplog.c)
+OpLog* opLogCreate(void);
+bool opLogOpenFile(OpLog* log, const char* path);
+void opLogAppend(OpLog* log, uint8_t op, int32_t rank, int32_t program_id);
+int opLogRecent(OpLog* log, OpRecord* out, int max);
+uint64_t opLogCount(OpLog* log);
+void opLogDestroy(OpLog* log);
+const char* opCodeName(uint8_t op);
+int formatOpRecord(const OpRecord* record, char* buf, size_t len);
+
+// Field validation (verification.c)
+bool isValidRegNumber(const char* reg_number);
+bool isValidDOB(const char* dob);
+bool isValidAadhar(const char* aadhar);
+
+// Bulk field validation (validate.c). Each field is packed into a
+// NUL-padded VALID_FIELD_WIDTH slot; a block of slots is validated in one
+// call that writes one FieldCheck per slot. The isValid* functions are
+// the same checks on a block of one.
+#define VALID_FIELD_WIDTH 16
+
+typedef enum {
+    FIELD_OK = 0,
+    FIELD_BAD_LENGTH,
+    FIELD_BAD_CHARACTER,  // A non-digit, or the wrong prefix or separator
+    FIELD_BAD_DATE,       // No such day, or a year before 1900
+    FIELD_NOT_PAST        // Date of birth not before the reference date
+} FieldCheck;
+
+typedef struct {
+    int year;
+    int month;
+    int day;
+} CalendarDate;
+
+void calendarToday(CalendarDate* today);
+void packField(char* slot, const char* text);
+void validateRegNumbers(const char* slots, int count, uint8_t* checks);
+void validateDates(const char* slots, int count, const CalendarDate* today, uint8_t* checks);
+void validateAadhars(const char* slots, int count, uint8_t* checks);
+
+// Batch claim verification (claims.c). A claim is reg_number,dob,aadhar;
+// each one that matches the verification store marks its student
+// verified, and every other claim is reported with its reason.
+typedef enum {
+    CLAIM_VERIFIED = 0,
+    CLAIM_MALFORMED,        // Not three fields, or an overlong line
+    CLAIM_UNKNOWN_REG,
+    CLAIM_BAD_DOB,          // Not a valid date of birth
+    CLAIM_DOB_MISMATCH,
+    CLAIM_BAD_AADHAR,       // Not a valid Aadhar number
+    CLAIM_AADHAR_MISMATCH,
+    CLAIM_DUPLICATE,        // Student verified by an earlier claim in the file
+    CLAIM_RESULT_COUNT
+} ClaimResult;
+
+typedef struct {
+    long claims;
+    long counts[CLAIM_RESULT_COUNT];
+    double seconds;  // Checking and merging, not reading the file
+} ClaimSummary;
+
+const char* claimResultName(ClaimResult result);
+bool verifyClaims(Queue* q, const char* text, size_t size, const char* reportPath, ClaimSummary* summary);
+bool verifyClaimFile(Queue* q, const char* claimsPath, const char* reportPath, ClaimSummary* summary);
+
+// Headless batch mode (batch.c)
+typedef struct {
+    const char* inputPath;
+    const char* outputPath;
+    int totalSeats;         // 0 = one seat per accepted student
+    const char* oplogPath;  // NULL = operation log kept in memory only
+    int rounds;             // Counselling rounds to run, at least 1
+    const char* responsesPath;  // round,reg_number,response; NULL = all float
+    const char* catalogPath;    // NULL = built-in catalog
+    int threads;                // Worker threads, 0 = one per CPU
+    const char* cutoffsPath;      // NULL = no cutoff table written
+    const char* rankQueriesPath;  // rank[,pools] per line; needs rankAnswersPath
+    const char* rankAnswersPath;
+    const char* whatIfPath;       // reg_number,preferences per line; needs whatIfOutPath
+    const char* whatIfOutPath;
+    const char* snapshotPath;     // NULL = no snapshot saved
+    const char* claimsPath;       // NULL = every accepted student is verified
+    const char* claimsReportPath; // Mismatched claims; NULL = not written
+    const char* demandPath;       // Demand analytics as JSON; NULL = not written
+    const char* seatMatrixPath;   // NULL = no seat matrix written
+    ExportFormat format;          // Of the allotment, cutoff and seat matrix files
+    ExportFilter filter;          // Rows written to those files; program -1 = all
+    const char* metricsPath;      // Metrics as JSON at exit; NULL = not written
+    AllocationEngine engine;
+    const char* prioritiesPath;   // College-side priorities; needs the deferred engine
+} BatchOptions;
+
+int runBatchMode(const BatchOptions* options);
+
+// Record fields as batch input has them; also used by the registration
+// service (server.c), so these keep no state between calls
+int splitFields(char* line, char delim, char** fields, int maxFields);
+bool parseRank(const char* text, int* rank);
+const char* parsePreferences(char* text, uint16_t* ids, int* count);
+
+// Registration service (server.c). Counters send one request per line
+// over a Unix domain socket; an event loop thread reads them and request
+// threads answer them against the shared queue.
+typedef struct Server Server;
+
+typedef struct {
+    const char* socketPath;
+    int seats;                  // Seats over the built-in catalog
+    int maxPreferences;         // 0 = every program
+    const char* catalogPath;    // NULL = built-in catalog
+    const char* snapshotPath;   // Reopened if it exists, saved on shutdown
+    const char* journalPath;    // NULL = changes are not journaled
+    const char* oplogPath;      // NULL = operation log kept in memory only
+    int threads;                // Worker and request threads, 0 = one per CPU
+    const char* metricsPath;    // Metrics as JSON on shutdown; NULL = not written
+    AllocationEngine engine;
+} ServeOptions;
+
+Server* serverStart(Queue* q, const char* socketPath, int threads);
+int serverThreadCount(Server* s);
+void serverReport(Server* s);
+void serverStop(Server* s);
+int runServeMode(const ServeOptions* options);
 
 #endif
\ No newline at end of file
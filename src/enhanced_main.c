@@ -2,15 +2,13 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <unistd.h>
 #include "enhanced_ds.h"
 
-// External declarations
-extern College colleges[MAX_COLLEGES];
-
 // Function declarations
-void initializeColleges(int totalStudents);
 void displayMenu(void);
 void addNewStudent(Queue* q, int* student_count, int totalStudents);
+void saveSessionSnapshot(Queue* q, const char* path);
 
 int main(int argc, char *argv[]) {
 
@@ -18,12 +16,188 @@ int main(int argc, char *argv[]) {
     //   UPDATED: Require TWO arguments
     //   argv[1] = total students
     //   argv[2] = MAX_PREFERENCES
+    //   [--oplog <file>] (default comedk_oplog.bin)
+    //   [--catalog <file>] (default: built-in colleges)
+    //   [--threads N] (default: one per CPU)
+    //   [--snapshot <file>] (reopened if it exists, saved on exit)
+    //   [--journal <file>] (replayed on startup, appended to on every change)
+    //   [--metrics-out <file>] (hot-path metrics as JSON, written on exit)
+    //   [--engine serial|deferred] (default serial)
+    //   or: --batch <input> --out <output> [options]
+    //       [--rounds N] [--responses <file>] [--threads N]
+    //       [--cutoffs <file>] [--rank-queries <file> --rank-answers <file>]
+    //       [--what-if <file> --what-if-out <file>] [--snapshot <file>]
+    //       [--claims <file> [--claims-report <file>]] [--demand <file>]
+    //       [--seat-matrix <file>] [--format csv|jsonl|binary]
+    //       [--only-program N] [--only-ranks A-B] [--metrics-out <file>]
+    //       [--engine serial|deferred [--priorities <file>]]
+    // or: --serve <socket> [--seats N] [--max-prefs N] [--catalog <file>]
+    //       [--snapshot <file>] [--journal <file>] [--oplog <file>] [--threads N]
+    //       [--metrics-out <file>] [--engine serial|deferred]
     // =====================================================
-    if (argc != 3) {
-        printf("%sUsage: %s <total_students> <max_preferences>%s\n",
+    if (argc >= 2 && strcmp(argv[1], "--batch") == 0) {
+        BatchOptions options = { 0 };
+        options.rounds = 1;
+        options.filter.program = -1;
+        bool valid = true;
+
+        for (int i = 1; i < argc && valid; i++) {
+            if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+                options.inputPath = argv[++i];
+            } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+                options.outputPath = argv[++i];
+            } else if (strcmp(argv[i], "--seats") == 0 && i + 1 < argc) {
+                options.totalSeats = atoi(argv[++i]);
+            } else if (strcmp(argv[i], "--oplog") == 0 && i + 1 < argc) {
+                options.oplogPath = argv[++i];
+            } else if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) {
+                options.rounds = atoi(argv[++i]);
+            } else if (strcmp(argv[i], "--responses") == 0 && i + 1 < argc) {
+                options.responsesPath = argv[++i];
+            } else if (strcmp(argv[i], "--catalog") == 0 && i + 1 < argc) {
+                options.catalogPath = argv[++i];
+            } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+                options.threads = atoi(argv[++i]);
+            } else if (strcmp(argv[i], "--cutoffs") == 0 && i + 1 < argc) {
+                options.cutoffsPath = argv[++i];
+            } else if (strcmp(argv[i], "--rank-queries") == 0 && i + 1 < argc) {
+                options.rankQueriesPath = argv[++i];
+            } else if (strcmp(argv[i], "--rank-answers") == 0 && i + 1 < argc) {
+                options.rankAnswersPath = argv[++i];
+            } else if (strcmp(argv[i], "--what-if") == 0 && i + 1 < argc) {
+                options.whatIfPath = argv[++i];
+            } else if (strcmp(argv[i], "--what-if-out") == 0 && i + 1 < argc) {
+                options.whatIfOutPath = argv[++i];
+            } else if (strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc) {
+                options.snapshotPath = argv[++i];
+            } else if (strcmp(argv[i], "--claims") == 0 && i + 1 < argc) {
+                options.claimsPath = argv[++i];
+            } else if (strcmp(argv[i], "--claims-report") == 0 && i + 1 < argc) {
+                options.claimsReportPath = argv[++i];
+            } else if (strcmp(argv[i], "--demand") == 0 && i + 1 < argc) {
+                options.demandPath = argv[++i];
+            } else if (strcmp(argv[i], "--seat-matrix") == 0 && i + 1 < argc) {
+                options.seatMatrixPath = argv[++i];
+            } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+                valid = parseExportFormat(argv[++i], &options.format);
+            } else if (strcmp(argv[i], "--only-program") == 0 && i + 1 < argc) {
+                options.filter.program = atoi(argv[++i]) - 1;
+                valid = (options.filter.program >= 0);
+            } else if (strcmp(argv[i], "--only-ranks") == 0 && i + 1 < argc) {
+                valid = parseRankRange(argv[++i], &options.filter);
+            } else if (strcmp(argv[i], "--metrics-out") == 0 && i + 1 < argc) {
+                options.metricsPath = argv[++i];
+            } else if (strcmp(argv[i], "--engine") == 0 && i + 1 < argc) {
+                valid = parseAllocationEngine(argv[++i], &options.engine);
+            } else if (strcmp(argv[i], "--priorities") == 0 && i + 1 < argc) {
+                options.prioritiesPath = argv[++i];
+            } else {
+                valid = false;
+            }
+        }
+
+        if (!valid || options.inputPath == NULL || options.outputPath == NULL ||
+            options.totalSeats < 0 || options.rounds < 1 || options.threads < 0 ||
+            (options.rankQueriesPath == NULL) != (options.rankAnswersPath == NULL) ||
+            (options.whatIfPath == NULL) != (options.whatIfOutPath == NULL) ||
+            (options.claimsReportPath != NULL && options.claimsPath == NULL) ||
+            (options.prioritiesPath != NULL && options.engine != ALLOCATION_DEFERRED)) {
+            printf("%sUsage: %s --batch <students.csv> --out <allotment.csv> [--seats N] [--oplog <file>]%s\n",
+                   COLOR_RED, argv[0], COLOR_RESET);
+            printf("%s       [--rounds N] [--responses <responses.csv>] [--catalog <catalog.csv>] [--threads N]%s\n",
+                   COLOR_RED, COLOR_RESET);
+            printf("%s       [--cutoffs <cutoffs.csv>] [--rank-queries <ranks.csv> --rank-answers <answers.csv>]%s\n",
+                   COLOR_RED, COLOR_RESET);
+            printf("%s       [--what-if <lists.csv> --what-if-out <outcomes.csv>] [--snapshot <file>]%s\n",
+                   COLOR_RED, COLOR_RESET);
+            printf("%s       [--claims <claims.csv> [--claims-report <report.csv>]] [--demand <demand.json>]%s\n",
+                   COLOR_RED, COLOR_RESET);
+            printf("%s       [--seat-matrix <seats.csv>] [--format csv|jsonl|binary] [--only-program N] [--only-ranks A-B]%s\n",
+                   COLOR_RED, COLOR_RESET);
+            printf("%s       [--metrics-out <metrics.json>] [--engine serial|deferred [--priorities <priorities.csv>]]%s\n",
+                   COLOR_RED, COLOR_RESET);
+            return 1;
+        }
+        return runBatchMode(&options);
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "--serve") == 0) {
+        ServeOptions options = { 0 };
+        options.seats = 1000;
+        bool valid = (argc >= 3 && argc % 2 == 1);
+
+        for (int i = 1; i + 1 < argc && valid; i += 2) {
+            if (strcmp(argv[i], "--serve") == 0) options.socketPath = argv[i + 1];
+            else if (strcmp(argv[i], "--seats") == 0) options.seats = atoi(argv[i + 1]);
+            else if (strcmp(argv[i], "--max-prefs") == 0) options.maxPreferences = atoi(argv[i + 1]);
+            else if (strcmp(argv[i], "--catalog") == 0) options.catalogPath = argv[i + 1];
+            else if (strcmp(argv[i], "--snapshot") == 0) options.snapshotPath = argv[i + 1];
+            else if (strcmp(argv[i], "--journal") == 0) options.journalPath = argv[i + 1];
+            else if (strcmp(argv[i], "--oplog") == 0) options.oplogPath = argv[i + 1];
+            else if (strcmp(argv[i], "--threads") == 0) options.threads = atoi(argv[i + 1]);
+            else if (strcmp(argv[i], "--metrics-out") == 0) options.metricsPath = argv[i + 1];
+            else if (strcmp(argv[i], "--engine") == 0) valid = parseAllocationEngine(argv[i + 1], &options.engine);
+            else valid = false;
+        }
+
+        if (!valid || options.seats < 1 || options.maxPreferences < 0 || options.threads < 0) {
+            printf("%sUsage: %s --serve <socket> [--seats N] [--max-prefs N] [--catalog <catalog.csv>]%s\n",
+                   COLOR_RED, argv[0], COLOR_RESET);
+            printf("%s       [--snapshot <file>] [--journal <file>] [--oplog <file>] [--threads N] [--metrics-out <file>]%s\n",
+                   COLOR_RED, COLOR_RESET);
+            printf("%s       [--engine serial|deferred]%s\n", COLOR_RED, COLOR_RESET);
+            return 1;
+        }
+        return runServeMode(&options);
+    }
+
+    const char* oplogPath = "comedk_oplog.bin";
+    const char* catalogPath = NULL;
+    const char* snapshotPath = NULL;
+    const char* journalPath = NULL;
+    const char* metricsPath = NULL;
+    int threads = 0;
+    AllocationEngine engine = ALLOCATION_SERIAL;
+    bool validArgs = (argc >= 3 && argc % 2 == 1);
+    for (int i = 3; i + 1 < argc && validArgs; i += 2) {
+        if (strcmp(argv[i], "--oplog") == 0) oplogPath = argv[i + 1];
+        else if (strcmp(argv[i], "--catalog") == 0) catalogPath = argv[i + 1];
+        else if (strcmp(argv[i], "--threads") == 0) threads = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--snapshot") == 0) snapshotPath = argv[i + 1];
+        else if (strcmp(argv[i], "--journal") == 0) journalPath = argv[i + 1];
+        else if (strcmp(argv[i], "--metrics-out") == 0) metricsPath = argv[i + 1];
+        else if (strcmp(argv[i], "--engine") == 0) validArgs = parseAllocationEngine(argv[i + 1], &engine);
+        else validArgs = false;
+    }
+    if (!validArgs || threads < 0) {
+        printf("%sUsage: %s <total_students> <max_preferences> [--oplog <file>] [--catalog <file>]%s\n",
+               COLOR_RED, argv[0], COLOR_RESET);
+        printf("%s       [--threads N] [--snapshot <file>] [--journal <file>] [--metrics-out <file>]%s\n",
+               COLOR_RED, COLOR_RESET);
+        printf("%s       [--engine serial|deferred]%s\n", COLOR_RED, COLOR_RESET);
+        printf("%s       %s --batch <students.csv> --out <allotment.csv> [--seats N] [--oplog <file>]%s\n",
+               COLOR_RED, argv[0], COLOR_RESET);
+        printf("%s       [--rounds N] [--responses <responses.csv>] [--catalog <catalog.csv>] [--threads N]%s\n",
+               COLOR_RED, COLOR_RESET);
+        printf("%s       [--cutoffs <cutoffs.csv>] [--rank-queries <ranks.csv> --rank-answers <answers.csv>]%s\n",
+               COLOR_RED, COLOR_RESET);
+        printf("%s       [--what-if <lists.csv> --what-if-out <outcomes.csv>] [--snapshot <file>]%s\n",
+               COLOR_RED, COLOR_RESET);
+        printf("%s       [--claims <claims.csv> [--claims-report <report.csv>]] [--demand <demand.json>]%s\n",
+               COLOR_RED, COLOR_RESET);
+        printf("%s       [--seat-matrix <seats.csv>] [--format csv|jsonl|binary] [--only-program N] [--only-ranks A-B]%s\n",
+               COLOR_RED, COLOR_RESET);
+        printf("%s       [--metrics-out <metrics.json>] [--engine serial|deferred [--priorities <priorities.csv>]]%s\n",
+               COLOR_RED, COLOR_RESET);
+        printf("%s       %s --serve <socket> [--seats N] [--max-prefs N] [--catalog <catalog.csv>]%s\n",
                COLOR_RED, argv[0], COLOR_RESET);
+        printf("%s       [--snapshot <file>] [--journal <file>] [--oplog <file>] [--threads N] [--metrics-out <file>]%s\n",
+               COLOR_RED, COLOR_RESET);
+        printf("%s       [--engine serial|deferred]%s\n", COLOR_RED, COLOR_RESET);
         return 1;
     }
+    setWorkerThreads(threads);
+    setAllocationEngine(engine);
 
     int totalStudents = atoi(argv[1]);
     if (totalStudents <= 0) {
@@ -32,35 +206,72 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
+    // An existing snapshot brings its own catalog, seats and students
+    bool resume = (snapshotPath != NULL && access(snapshotPath, F_OK) == 0);
+    if (resume && catalogPath != NULL) {
+        printf("%sError: --catalog only applies to a new session, %s already has one%s\n",
+               COLOR_RED, snapshotPath, COLOR_RESET);
+        return 1;
+    }
+
+    Queue* studentQueue = NULL;
+    if (resume) {
+        double t0 = monotonicSeconds();
+        studentQueue = loadSnapshot(snapshotPath);
+        if (studentQueue == NULL) return 1;
+        printf("\n%sSnapshot %s reopened in %.2f ms: %d students, %d programs, %d seat pool(s)%s\n",
+               COLOR_GREEN, snapshotPath, (monotonicSeconds() - t0) * 1000.0,
+               studentQueue->students.live, programCount, seatPoolCount, COLOR_RESET);
+    } else if (catalogPath != NULL) {
+        // Seats come from the catalog file when one is given
+        if (!loadCatalog(catalogPath)) return 1;
+        initializeColleges(0);
+        printf("\n%sCatalog loaded: %d colleges, %d programs, %d seat pool(s)%s\n",
+               COLOR_GREEN, collegeCount, programCount, seatPoolCount, COLOR_RESET);
+    } else {
+        initializeColleges(totalStudents);
+    }
+
     // NEW → Set global MAX_PREFERENCES from command line
     MAX_PREFERENCES = atoi(argv[2]);
-    if (MAX_PREFERENCES < 1 || MAX_PREFERENCES > 8) {
-        printf("%sError: MAX_PREFERENCES must be between 1 and 8%s\n",
-               COLOR_RED, COLOR_RESET);
+    if (MAX_PREFERENCES < 1 || MAX_PREFERENCES > programCount) {
+        printf("%sError: MAX_PREFERENCES must be between 1 and %d%s\n",
+               COLOR_RED, programCount, COLOR_RESET);
         return 1;
     }
 
     printf("\n%sMAX_PREFERENCES set to: %d%s\n",
            COLOR_GREEN, MAX_PREFERENCES, COLOR_RESET);
 
-    initializeColleges(totalStudents);
-    Queue* studentQueue = createQueue();
+    if (studentQueue == NULL) studentQueue = createQueue();
+    if (!opLogOpenFile(studentQueue->operation_log, oplogPath)) {
+        printf("%sWarning: Cannot open operation log %s, keeping it in memory only%s\n",
+               COLOR_YELLOW, oplogPath, COLOR_RESET);
+    }
     int choice;
-    int student_count = 0;
 
     // Pre-register 5 verified students using verificationData[]
-    for (int i = 0; i < 5; i++) {
-        Student* newStudent = (Student*)malloc(sizeof(Student));
-        strcpy(newStudent->reg_number, verificationData[i].reg_number);
-        strcpy(newStudent->name, verificationData[i].name);
-        newStudent->rank = (i + 1);
-        newStudent->verified = true;
-        newStudent->num_preferences = 0;
-        strcpy(newStudent->allocated_college, "Not Allocated");
-        strcpy(newStudent->allocated_branch, "NA");
-        enqueue(studentQueue, newStudent);
-        student_count++;
+    if (!resume)
+        preregisterSeedStudents(studentQueue);
+
+    // Changes made since the snapshot (or since a fresh start) come back
+    // from the journal before anything new is accepted
+    if (journalPath != NULL) {
+        JournalRecovery recovery;
+        studentQueue->journal = journalOpen(studentQueue, journalPath, &recovery);
+        if (studentQueue->journal == NULL) return 1;
+        printf("\n%sJournal %s replayed in %.2f ms: %ld change(s) applied",
+               COLOR_GREEN, journalPath, recovery.seconds * 1000.0, recovery.replayed);
+        if (recovery.skipped > 0) printf(", %ld already in the snapshot", recovery.skipped);
+        printf("%s\n", COLOR_RESET);
+        if (recovery.rejected > 0)
+            printf("%sWarning: %ld journaled change(s) did not apply to this session%s\n",
+                   COLOR_YELLOW, recovery.rejected, COLOR_RESET);
+        if (recovery.torn_bytes > 0)
+            printf("%sWarning: Dropped an incomplete record at the end of the journal (%ld bytes)%s\n",
+                   COLOR_YELLOW, recovery.torn_bytes, COLOR_RESET);
     }
+    int student_count = studentQueue->students.live;
 
     // =======================
     // Main menu loop
@@ -87,7 +298,7 @@ int main(int argc, char *argv[]) {
                 break;
 
             case 2:
-                displayStudents(studentQueue->front);
+                displayStudents(studentQueue);
                 break;
 
             case 3:
@@ -103,6 +314,41 @@ int main(int argc, char *argv[]) {
                 break;
 
             case 6:
+                counsellingRoundsMenu(studentQueue);
+                break;
+
+            case 7:
+                cutoffMenu(studentQueue);
+                break;
+
+            case 8:
+                whatIfInteractive(studentQueue);
+                break;
+
+            case 9:
+                saveSessionSnapshot(studentQueue, snapshotPath);
+                break;
+
+            case 10:
+                preferenceFlowMenu(studentQueue);
+                break;
+
+            case 11:
+                demandMenu(studentQueue);
+                break;
+
+            case 12:
+                exportMenu(studentQueue);
+                break;
+
+            case 13:
+                displaySystemStatus(studentQueue);
+                break;
+
+            case 14:
+                if (snapshotPath != NULL)
+                    saveSessionSnapshot(studentQueue, snapshotPath);
+
                 printf("\n%sCleaning system memory...%s\n",
                        COLOR_YELLOW, COLOR_RESET);
 
@@ -110,6 +356,8 @@ int main(int argc, char *argv[]) {
                 // NEW → FREE ALL MEMORY BEFORE EXITING
                 // =====================================
                 cleanupQueue(studentQueue);
+                if (metricsPath != NULL && !writeMetricsJson(metricsPath))
+                    printf("%sError: Cannot write metrics file %s%s\n", COLOR_RED, metricsPath, COLOR_RESET);
 
                 printf("%sThank you for using COMEDK Admission System!%s\n",
                        COLOR_GREEN, COLOR_RESET);
@@ -118,7 +366,7 @@ int main(int argc, char *argv[]) {
                 return 0;
 
             default:
-                printf("\n%sInvalid choice! Please enter a number between 1 and 6.%s\n",
+                printf("\n%sInvalid choice! Please enter a number between 1 and 14.%s\n",
                        COLOR_RED, COLOR_RESET);
         }
     }
@@ -126,31 +374,6 @@ int main(int argc, char *argv[]) {
     return 0;
 }
 
-void initializeColleges(int totalStudents) {
-    strcpy(colleges[0].name, "PES University");
-    strcpy(colleges[1].name, "RV College of Engineering");
-    strcpy(colleges[2].name, "BMS College of Engineering");
-    strcpy(colleges[3].name, "MS Ramaiah Institute of Technology");
-
-    int seatsPerCollege = (totalStudents + MAX_COLLEGES - 1) / MAX_COLLEGES;
-    if (seatsPerCollege % 2 != 0)
-        seatsPerCollege++;
-
-    for (int i = 0; i < MAX_COLLEGES; i++) {
-        colleges[i].seats_cse = seatsPerCollege / 2;
-        colleges[i].seats_ece = seatsPerCollege / 2;
-        colleges[i].preference_count = 0;
-    }
-
-    printf("\n%sInitial Seat Distribution:%s\n", COLOR_BLUE, COLOR_RESET);
-    for (int i = 0; i < MAX_COLLEGES; i++) {
-        printf("%s: CSE=%d, ECE=%d\n",
-               colleges[i].name,
-               colleges[i].seats_cse,
-               colleges[i].seats_ece);
-    }
-}
-
 void displayMenu() {
     printf("\n\n%s************************************%s\n", COLOR_YELLOW, COLOR_RESET);
     printf("%s        WELCOME TO COMEDK         %s\n", COLOR_GREEN, COLOR_RESET);
@@ -163,6 +386,30 @@ void displayMenu() {
     printf("3. View All Available Colleges\n");
     printf("4. Process Seat Allotment\n");
     printf("5. Update Student Preferences\n");
-    printf("6. Exit\n\n");
-    printf("Please enter your choice (1-6): ");
+    printf("6. Counselling Rounds\n");
+    printf("7. Cutoffs and Rank Queries\n");
+    printf("8. What-if Preference Change\n");
+    printf("9. Save Snapshot\n");
+    printf("10. Preference Flow\n");
+    printf("11. Demand Analytics\n");
+    printf("12. Export Results\n");
+    printf("13. System Status\n");
+    printf("14. Exit\n\n");
+    printf("Please enter your choice (1-14): ");
+}
+
+// Saves to the --snapshot file, or to comedk_snapshot.bin without one.
+// Only the --snapshot file is where the session restarts from, so only
+// saving there lets the journal drop the records it now holds.
+void saveSessionSnapshot(Queue* q, const char* path) {
+    bool sessionFile = (path != NULL);
+    if (path == NULL) path = "comedk_snapshot.bin";
+    uint64_t sequence = (q->journal != NULL) ? journalLastSequence(q->journal) : 0;
+    double t0 = monotonicSeconds();
+    if (!saveSnapshot(q, path)) return;
+    printf("\n%sSnapshot saved to %s in %.1f ms%s\n",
+           COLOR_GREEN, path, (monotonicSeconds() - t0) * 1000.0, COLOR_RESET);
+    if (sessionFile && q->journal != NULL && journalCheckpoint(q->journal, sequence))
+        printf("%sJournal cleared up to change %llu%s\n",
+               COLOR_GREEN, (unsigned long long)sequence, COLOR_RESET);
 }
@@ -0,0 +1,558 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "enhanced_ds.h"
+
+// ==========================================================
+//   RESULT EXPORT
+//
+//   Rows come from an ExportCursor, which walks the allotment
+//   in rank order or the seat matrix and cutoff table program
+//   by program, applying the filter as it goes. The exporter
+//   formats each row straight into a 1 MB buffer, integers by
+//   hand, and hands full buffers to write(2), so a 150,000-row
+//   allotment is a few hundred system calls and no printf. The
+//   terminal views page over the same cursor.
+//
+//   Binary layout: an ExportFileHeader, the program table (per
+//   program a length-prefixed college and branch name), the
+//   pool names in POOL_NAME_LENGTH bytes each, then one record
+//   per row. An allotment record is followed by the student's
+//   name, name_length bytes without a NUL.
+// ==========================================================
+
+#define EXPORT_BUFFER_SIZE (1 << 20)
+#define EXPORT_MAGIC   0x58454B44454D4F43ULL  // "COMEDKEX" on disk
+#define EXPORT_VERSION 1
+
+typedef struct {
+    uint64_t magic;
+    uint32_t version;
+    uint16_t table;        // ExportTable
+    uint16_t pools;
+    uint32_t programs;
+    uint32_t record_size;  // Fixed part of a record
+    uint64_t rows;         // Written once the export is complete
+} ExportFileHeader;        // 32 bytes on disk
+
+typedef struct {
+    int32_t rank;
+    int16_t program;       // Or PROGRAM_NOT_ALLOCATED/NOT_ELIGIBLE
+    uint8_t pool;
+    uint8_t name_length;
+    char reg_number[MAX_REG_LENGTH];
+    uint8_t reserved[2];
+} ExportAllotmentRecord;   // 20 bytes, then the name
+
+typedef struct {
+    uint16_t program;
+    uint8_t pool;
+    uint8_t reserved;
+    int32_t seats;
+    int32_t left;
+} ExportSeatRecord;        // 12 bytes
+
+typedef struct {
+    uint16_t program;
+    uint8_t pool;
+    uint8_t reserved;
+    int32_t seats;
+    int32_t filled;
+    int32_t closing_rank;  // 0 if the slot holds nobody
+    int32_t exhausted_at;  // CUTOFF_OPEN while seats remain
+} ExportCutoffRecord;      // 20 bytes
+
+static const char* exportTableNames[] = { "allotment", "seat matrix", "cutoffs" };
+
+// ------------------------------------------------------------
+// Cursor
+// ------------------------------------------------------------
+
+void exportCursorInit(ExportCursor* c, Queue* q, ExportTable table, const ExportFilter* filter) {
+    c->q = q;
+    c->table = table;
+    c->filter.program = -1;
+    c->filter.min_rank = 0;
+    c->filter.max_rank = 0;
+    if (filter != NULL) c->filter = *filter;
+    c->student = (table == EXPORT_ALLOTMENT) ? q->front : NO_STUDENT;
+
+    // Slots are program-major, so one program is one run of them
+    c->slot = 0;
+    c->end = programCount * seatPoolCount;
+    if (table == EXPORT_ALLOTMENT || (table == EXPORT_CUTOFFS && q->allocation->cutoffs == NULL))
+        c->end = 0;
+    else if (c->filter.program >= 0) {
+        c->slot = c->filter.program < programCount ? c->filter.program * seatPoolCount : 0;
+        c->end = c->filter.program < programCount ? c->slot + seatPoolCount : 0;
+    }
+}
+
+static bool inRankRange(const ExportFilter* f, int rank) {
+    return rank >= f->min_rank && (f->max_rank == 0 || rank <= f->max_rank);
+}
+
+bool exportNext(ExportCursor* c, ExportRow* row) {
+    const ExportFilter* f = &c->filter;
+    if (c->table == EXPORT_ALLOTMENT) {
+        const StudentStore* store = &c->q->students;
+        while (c->student != NO_STUDENT) {
+            StudentId s = c->student;
+            int rank = store->rank[s];
+            c->student = store->next[s];
+            if (f->max_rank > 0 && rank > f->max_rank) {
+                c->student = NO_STUDENT;  // The queue is in rank order
+                break;
+            }
+            if (rank < f->min_rank) continue;
+            if (f->program >= 0 && store->allocated_program[s] != f->program) continue;
+            row->student = s;
+            row->rank = rank;
+            row->program = store->allocated_program[s];
+            row->pool = store->allocated_pool[s];
+            return true;
+        }
+        return false;
+    }
+
+    while (c->slot < c->end) {
+        int program_id = c->slot / seatPoolCount;
+        int pool = c->slot % seatPoolCount;
+        c->slot++;
+        row->student = NO_STUDENT;
+        row->program = program_id;
+        row->pool = pool;
+        if (c->table == EXPORT_SEATS) {
+            bool pooled = (seatPoolCount > 1 && poolCapacity != NULL);
+            size_t entry = (size_t)pool * programCount + program_id;
+            row->seats = pooled ? poolCapacity[entry] : programCapacity[program_id];
+            row->left = pooled ? poolSeats[entry] : programSeats[program_id];
+            row->filled = row->seats - row->left;
+            return true;
+        }
+        CutoffSlotInfo info;
+        cutoffSlotInfo(c->q->allocation->cutoffs, program_id, pool, &info);
+        if ((f->min_rank > 0 || f->max_rank > 0) &&
+            (info.closing_rank == 0 || !inRankRange(f, info.closing_rank)))
+            continue;
+        row->seats = info.seats;
+        row->filled = info.filled;
+        row->left = info.seats - info.filled;
+        row->closing_rank = info.closing_rank;
+        row->exhausted_at = info.exhausted_at;
+        return true;
+    }
+    return false;
+}
+
+// ------------------------------------------------------------
+// Write buffer
+// ------------------------------------------------------------
+
+typedef struct {
+    int fd;
+    char* data;
+    size_t used;
+    uint64_t written;
+    bool failed;
+} ExportBuffer;
+
+static void flushBuffer(ExportBuffer* b) {
+    size_t done = 0;
+    while (done < b->used && !b->failed) {
+        ssize_t n = write(b->fd, b->data + done, b->used - done);
+        if (n < 0) b->failed = true;
+        else done += (size_t)n;
+    }
+    b->written += done;
+    b->used = 0;
+}
+
+static void putBytes(ExportBuffer* b, const void* bytes, size_t n) {
+    if (b->used + n > EXPORT_BUFFER_SIZE) flushBuffer(b);
+    if (n > EXPORT_BUFFER_SIZE) {
+        // Larger than the buffer: goes out directly
+        size_t done = 0;
+        while (done < n && !b->failed) {
+            ssize_t w = write(b->fd, (const char*)bytes + done, n - done);
+            if (w < 0) b->failed = true;
+            else done += (size_t)w;
+        }
+        b->written += done;
+        return;
+    }
+    memcpy(b->data + b->used, bytes, n);
+    b->used += n;
+}
+
+static void putChar(ExportBuffer* b, char ch) {
+    if (b->used == EXPORT_BUFFER_SIZE) flushBuffer(b);
+    b->data[b->used++] = ch;
+}
+
+static void putString(ExportBuffer* b, const char* text) {
+    putBytes(b, text, strlen(text));
+}
+
+static void putInt(ExportBuffer* b, long value) {
+    char digits[24];
+    int n = 0;
+    unsigned long v = value < 0 ? 0UL - (unsigned long)value : (unsigned long)value;
+    do {
+        digits[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v != 0);
+    if (b->used + n + 1 > EXPORT_BUFFER_SIZE) flushBuffer(b);
+    char* out = b->data + b->used;
+    if (value < 0) *out++ = '-';
+    while (n > 0) *out++ = digits[--n];
+    b->used = (size_t)(out - b->data);
+}
+
+// One RFC 4180 field: quoted only if it holds a comma, quote or line
+// break, with every inner quote doubled
+static void putCsvField(ExportBuffer* b, const char* text) {
+    if (strpbrk(text, ",\"\r\n") == NULL) {
+        putString(b, text);
+        return;
+    }
+    putChar(b, '"');
+    for (const char* p = text; *p != '\0'; p++) {
+        if (*p == '"') putChar(b, '"');
+        putChar(b, *p);
+    }
+    putChar(b, '"');
+}
+
+static void putJsonString(ExportBuffer* b, const char* text) {
+    putChar(b, '"');
+    for (const char* p = text; *p != '\0'; p++) {
+        unsigned char ch = (unsigned char)*p;
+        if (ch == '"' || ch == '\\') {
+            putChar(b, '\\');
+            putChar(b, (char)ch);
+        } else if (ch < 0x20) {
+            static const char hex[] = "0123456789abcdef";
+            char escape[6] = { '\\', 'u', '0', '0', hex[ch >> 4], hex[ch & 15] };
+            putBytes(b, escape, sizeof(escape));
+        } else {
+            putChar(b, (char)ch);
+        }
+    }
+    putChar(b, '"');
+}
+
+// ------------------------------------------------------------
+// Row formats
+// ------------------------------------------------------------
+
+static void putCsvHeader(ExportBuffer* b, ExportTable table) {
+    bool pooled = (seatPoolCount > 1);
+    if (table == EXPORT_ALLOTMENT)
+        putString(b, pooled ? "reg_number,name,rank,college,branch,pool\n" : "reg_number,name,rank,college,branch\n");
+    else if (table == EXPORT_SEATS)
+        putString(b, "choice,college,branch,pool,seats,left,filled\n");
+    else
+        putString(b, "choice,college,branch,pool,seats,filled,closing_rank,exhausted_at\n");
+}
+
+static void putCsvRow(ExportBuffer* b, Queue* q, ExportTable table, const ExportRow* row) {
+    if (table == EXPORT_ALLOTMENT) {
+        const StudentStore* store = &q->students;
+        putCsvField(b, store->reg_number[row->student]);
+        putChar(b, ',');
+        putCsvField(b, STUDENT_NAME(store, row->student));
+        putChar(b, ',');
+        putInt(b, row->rank);
+        putChar(b, ',');
+        putCsvField(b, programCollegeName(row->program));
+        putChar(b, ',');
+        putCsvField(b, programBranchName(row->program));
+        if (seatPoolCount > 1) {
+            putChar(b, ',');
+            if (row->program >= 0) putCsvField(b, seatPoolName(row->pool));
+        }
+        putChar(b, '\n');
+        return;
+    }
+
+    putInt(b, row->program + 1);
+    putChar(b, ',');
+    putCsvField(b, programCollegeName(row->program));
+    putChar(b, ',');
+    putCsvField(b, programBranchName(row->program));
+    putChar(b, ',');
+    putCsvField(b, seatPoolName(row->pool));
+    putChar(b, ',');
+    putInt(b, row->seats);
+    putChar(b, ',');
+    if (table == EXPORT_SEATS) {
+        putInt(b, row->left);
+        putChar(b, ',');
+        putInt(b, row->filled);
+    } else {
+        putInt(b, row->filled);
+        putChar(b, ',');
+        if (row->filled > 0) putInt(b, row->closing_rank);
+        putChar(b, ',');
+        if (row->exhausted_at != CUTOFF_OPEN) putInt(b, row->exhausted_at);
+    }
+    putChar(b, '\n');
+}
+
+static void putJsonRank(ExportBuffer* b, const char* key, int rank, bool present) {
+    putString(b, key);
+    if (present) putInt(b, rank);
+    else putString(b, "null");
+}
+
+static void putJsonlRow(ExportBuffer* b, Queue* q, ExportTable table, const ExportRow* row) {
+    if (table == EXPORT_ALLOTMENT) {
+        const StudentStore* store = &q->students;
+        putString(b, "{\"reg_number\":");
+        putJsonString(b, store->reg_number[row->student]);
+        putString(b, ",\"name\":");
+        putJsonString(b, STUDENT_NAME(store, row->student));
+        putString(b, ",\"rank\":");
+        putInt(b, row->rank);
+        if (row->program >= 0) {
+            putString(b, ",\"status\":\"allocated\",\"choice\":");
+            putInt(b, row->program + 1);
+            putString(b, ",\"college\":");
+            putJsonString(b, programCollegeName(row->program));
+            putString(b, ",\"branch\":");
+            putJsonString(b, programBranchName(row->program));
+            putString(b, ",\"pool\":");
+            putJsonString(b, seatPoolName(row->pool));
+        } else {
+            putString(b, row->program == PROGRAM_NOT_ELIGIBLE ? ",\"status\":\"not_eligible\"" :
+                                                              ",\"status\":\"not_allocated\"");
+            putString(b, ",\"choice\":null,\"college\":null,\"branch\":null,\"pool\":null");
+        }
+        putString(b, "}\n");
+        return;
+    }
+
+    putString(b, "{\"choice\":");
+    putInt(b, row->program + 1);
+    putString(b, ",\"college\":");
+    putJsonString(b, programCollegeName(row->program));
+    putString(b, ",\"branch\":");
+    putJsonString(b, programBranchName(row->program));
+    putString(b, ",\"pool\":");
+    putJsonString(b, seatPoolName(row->pool));
+    putString(b, ",\"seats\":");
+    putInt(b, row->seats);
+    if (table == EXPORT_SEATS) {
+        putString(b, ",\"left\":");
+        putInt(b, row->left);
+    }
+    putString(b, ",\"filled\":");
+    putInt(b, row->filled);
+    if (table == EXPORT_CUTOFFS) {
+        putJsonRank(b, ",\"closing_rank\":", row->closing_rank, row->filled > 0);
+        putJsonRank(b, ",\"exhausted_at\":", row->exhausted_at, row->exhausted_at != CUTOFF_OPEN);
+    }
+    putString(b, "}\n");
+}
+
+static uint32_t binaryRecordSize(ExportTable table) {
+    if (table == EXPORT_ALLOTMENT) return sizeof(ExportAllotmentRecord);
+    return table == EXPORT_SEATS ? sizeof(ExportSeatRecord) : sizeof(ExportCutoffRecord);
+}
+
+static void putShortString(ExportBuffer* b, const char* text) {
+    size_t length = strlen(text);
+    uint8_t n = (uint8_t)(length < 255 ? length : 255);
+    putChar(b, (char)n);
+    putBytes(b, text, n);
+}
+
+static void putBinaryHeader(ExportBuffer* b, ExportTable table, uint64_t rows) {
+    ExportFileHeader header = { EXPORT_MAGIC, EXPORT_VERSION, (uint16_t)table, (uint16_t)seatPoolCount,
+                                (uint32_t)programCount, binaryRecordSize(table), rows };
+    putBytes(b, &header, sizeof(header));
+    for (int p = 0; p < programCount; p++) {
+        putShortString(b, programCollegeName(p));
+        putShortString(b, programBranchName(p));
+    }
+    for (int k = 0; k < seatPoolCount; k++) {
+        char name[POOL_NAME_LENGTH] = { 0 };
+        memcpy(name, seatPoolNames[k], strnlen(seatPoolNames[k], POOL_NAME_LENGTH - 1));
+        putBytes(b, name, POOL_NAME_LENGTH);
+    }
+}
+
+static void putBinaryRow(ExportBuffer* b, Queue* q, ExportTable table, const ExportRow* row) {
+    if (table == EXPORT_ALLOTMENT) {
+        const StudentStore* store = &q->students;
+        const char* name = STUDENT_NAME(store, row->student);
+        size_t length = strlen(name);
+        ExportAllotmentRecord r;
+        memset(&r, 0, sizeof(r));
+        r.rank = row->rank;
+        r.program = (int16_t)row->program;
+        r.pool = (uint8_t)(row->program >= 0 ? row->pool : 0);
+        r.name_length = (uint8_t)(length < 255 ? length : 255);
+        memcpy(r.reg_number, store->reg_number[row->student], MAX_REG_LENGTH);
+        putBytes(b, &r, sizeof(r));
+        putBytes(b, name, r.name_length);
+    } else if (table == EXPORT_SEATS) {
+        ExportSeatRecord r = { (uint16_t)row->program, (uint8_t)row->pool, 0, row->seats, row->left };
+        putBytes(b, &r, sizeof(r));
+    } else {
+        ExportCutoffRecord r = { (uint16_t)row->program, (uint8_t)row->pool, 0, row->seats, row->filled,
+                                 row->closing_rank, row->exhausted_at };
+        putBytes(b, &r, sizeof(r));
+    }
+}
+
+// ------------------------------------------------------------
+// Export
+// ------------------------------------------------------------
+
+bool exportResults(Queue* q, ExportTable table, ExportFormat format, const ExportFilter* filter,
+                   const char* path, ExportStats* stats) {
+    memset(stats, 0, sizeof(*stats));
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    double t0 = monotonicSeconds();
+
+    ExportBuffer b = { fd, (char*)malloc(EXPORT_BUFFER_SIZE), 0, 0, false };
+    if (format == EXPORT_CSV) putCsvHeader(&b, table);
+    else if (format == EXPORT_BINARY) putBinaryHeader(&b, table, 0);
+
+    ExportCursor cursor;
+    ExportRow row;
+    exportCursorInit(&cursor, q, table, filter);
+    while (exportNext(&cursor, &row) && !b.failed) {
+        if (format == EXPORT_CSV) putCsvRow(&b, q, table, &row);
+        else if (format == EXPORT_JSONL) putJsonlRow(&b, q, table, &row);
+        else putBinaryRow(&b, q, table, &row);
+        stats->rows++;
+    }
+    flushBuffer(&b);
+
+    // The row count is only known now
+    if (format == EXPORT_BINARY && !b.failed) {
+        uint64_t rows = (uint64_t)stats->rows;
+        if (pwrite(fd, &rows, sizeof(rows), offsetof(ExportFileHeader, rows)) != sizeof(rows))
+            b.failed = true;
+    }
+    free(b.data);
+    if (close(fd) != 0) b.failed = true;
+    stats->bytes = b.written;
+    stats->seconds = monotonicSeconds() - t0;
+    return !b.failed;
+}
+
+bool parseExportFormat(const char* text, ExportFormat* format) {
+    if (strcmp(text, "csv") == 0) *format = EXPORT_CSV;
+    else if (strcmp(text, "jsonl") == 0) *format = EXPORT_JSONL;
+    else if (strcmp(text, "binary") == 0) *format = EXPORT_BINARY;
+    else return false;
+    return true;
+}
+
+// "A-B", "A-" or "-B"; either bound may be left open
+bool parseRankRange(const char* text, ExportFilter* filter) {
+    const char* dash = strchr(text, '-');
+    if (dash == NULL) return false;
+    char low[16], high[16];
+    size_t lowLength = (size_t)(dash - text);
+    if (lowLength >= sizeof(low) || strlen(dash + 1) >= sizeof(high)) return false;
+    memcpy(low, text, lowLength);
+    low[lowLength] = '\0';
+    strcpy(high, dash + 1);
+
+    int minRank = 0, maxRank = 0;
+    if ((low[0] != '\0' && !parseRank(low, &minRank)) || (high[0] != '\0' && !parseRank(high, &maxRank)))
+        return false;
+    if (maxRank > 0 && minRank > maxRank) return false;
+    filter->min_rank = minRank;
+    filter->max_rank = maxRank;
+    return true;
+}
+
+// ------------------------------------------------------------
+// Terminal
+// ------------------------------------------------------------
+
+// Called before each row of a terminal view; after every EXPORT_PAGE_ROWS
+// rows waits for Enter. Returns false once the reader stops the listing.
+bool pageRow(int* shown) {
+    if (*shown > 0 && *shown % EXPORT_PAGE_ROWS == 0) {
+        printf("%s-- More: Enter to continue, q to stop --%s", COLOR_YELLOW, COLOR_RESET);
+        char answer[16];
+        if (fgets(answer, sizeof(answer), stdin) == NULL || answer[0] == 'q' || answer[0] == 'Q')
+            return false;
+    }
+    (*shown)++;
+    return true;
+}
+
+// Reads one line into buffer; false on end of input
+static bool inputLine(const char* prompt, char* buffer, int size) {
+    printf("%s", prompt);
+    if (fgets(buffer, size, stdin) == NULL) return false;
+    buffer[strcspn(buffer, "\r\n")] = '\0';
+    return true;
+}
+
+void exportMenu(Queue* q) {
+    char line[256];
+    printf("\n%sExport Results%s\n", COLOR_BLUE, COLOR_RESET);
+    printf("==============\n");
+    printf("1. Allotment\n2. Seat Matrix\n3. Cutoffs\n");
+    if (!inputLine("\nTable (1-3): ", line, sizeof(line))) return;
+    int choice = atoi(line);
+    if (choice < 1 || choice > 3) {
+        printf("%sError: Please enter a choice between 1 and 3!%s\n", COLOR_RED, COLOR_RESET);
+        return;
+    }
+    ExportTable table = (ExportTable)(choice - 1);
+    if (table == EXPORT_CUTOFFS && q->allocation->cutoffs == NULL) {
+        printf("\n%sNo seat allotment yet: run the allocation first.%s\n", COLOR_YELLOW, COLOR_RESET);
+        return;
+    }
+
+    ExportFormat format;
+    if (!inputLine("Format (csv, jsonl, binary): ", line, sizeof(line))) return;
+    if (!parseExportFormat(line, &format)) {
+        printf("%sError: Unknown format '%s'!%s\n", COLOR_RED, line, COLOR_RESET);
+        return;
+    }
+
+    ExportFilter filter = { -1, 0, 0 };
+    if (!inputLine("Only choice number (Enter for all): ", line, sizeof(line))) return;
+    if (line[0] != '\0') {
+        int program = atoi(line);
+        if (program < 1 || program > programCount) {
+            printf("%sError: Please enter a choice between 1 and %d!%s\n", COLOR_RED, programCount, COLOR_RESET);
+            return;
+        }
+        filter.program = program - 1;
+    }
+    if (table != EXPORT_SEATS) {
+        if (!inputLine("Only ranks, e.g. 1-5000 (Enter for all): ", line, sizeof(line))) return;
+        if (line[0] != '\0' && !parseRankRange(line, &filter)) {
+            printf("%sError: Invalid rank range '%s'!%s\n", COLOR_RED, line, COLOR_RESET);
+            return;
+        }
+    }
+
+    if (!inputLine("File name: ", line, sizeof(line)) || line[0] == '\0') return;
+    ExportStats stats;
+    if (!exportResults(q, table, format, &filter, line, &stats)) {
+        printf("%sError: Cannot write %s%s\n", COLOR_RED, line, COLOR_RESET);
+        return;
+    }
+    double mb = stats.bytes / (1024.0 * 1024.0);
+    printf("%s%s: %ld row(s), %.2f MB written to %s in %.3f s (%.1f MB/s)%s\n", COLOR_GREEN,
+           exportTableNames[table], stats.rows, mb, line, stats.seconds,
+           stats.seconds > 0 ? mb / stats.seconds : 0.0, COLOR_RESET);
+}
@@ -0,0 +1,511 @@
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "enhanced_ds.h"
+
+// ==========================================================
+//   WRITE-AHEAD JOURNAL
+//
+//   Registrations and preference edits are appended here as
+//   compact binary records before they change the queue, so
+//   whatever happened since the last snapshot survives a crash.
+//   A record is a 16-byte header (payload length, CRC-32,
+//   sequence number) followed by a payload that starts with its
+//   JournalRecordType.
+//
+//   Producers copy records into a pending buffer under the lock.
+//   The writer thread swaps it for an empty buffer, writes the
+//   batch with one write() and syncs the file; records appended
+//   while it waits on the disk form the next batch (group
+//   commit). One sync makes a whole batch durable, and a caller
+//   that must acknowledge a change waits in journalSync for its
+//   own sequence number only.
+//
+//   Sequence numbers run on across snapshots. A snapshot stores
+//   the last sequence it reflects, and once it is saved over
+//   the session's snapshot file the journal is cut back to its
+//   header with that sequence as the new base. Opening a journal
+//   replays every record after the queue's sequence, stops at
+//   the first torn or corrupt record and cuts the file there.
+// ==========================================================
+
+#define JOURNAL_BUFFER_LIMIT (4 << 20)  // Pending bytes before producers wait
+#define JOURNAL_MAX_PAYLOAD  (1 << 20)
+#define JOURNAL_FIXED_BYTES  256        // Room for the fields before a preference list
+
+typedef struct {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t base_sequence;  // Records continue from base_sequence + 1
+} JournalFileHeader;
+
+typedef struct {
+    uint32_t length;    // Payload bytes that follow
+    uint32_t checksum;  // CRC-32 of the payload and then the sequence
+    uint64_t sequence;
+} JournalRecordHeader;
+
+typedef enum {
+    JOURNAL_REGISTER = 1,  // Verification record plus the queued student
+    JOURNAL_PREFERENCES    // New preference list of a queued student
+} JournalRecordType;
+
+struct Journal {
+    int fd;                 // Opened with O_APPEND
+    char* pending;          // Records not yet handed to the writer
+    size_t pending_used;
+    size_t pending_capacity;
+    char* writing;          // Batch the writer is working on
+    size_t writing_capacity;
+    uint64_t last;          // Last sequence handed out
+    uint64_t durable;       // Last sequence synced to disk
+    bool busy;              // Writer holds a batch that is not synced yet
+    bool stopping;
+    bool failed;            // A write or sync failed; nothing more becomes durable
+    long records;
+    long syncs;
+    pthread_t writer;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;    // Records pending, or stopping
+    pthread_cond_t synced;  // durable moved, a batch was taken, or failed
+};
+
+
+// ==========================================================
+//                       RECORD FORMAT
+// ==========================================================
+
+static uint32_t crcTable[256];
+static pthread_once_t crcOnce = PTHREAD_ONCE_INIT;
+
+static void buildCrcTable(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++)
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        crcTable[i] = c;
+    }
+}
+
+static uint32_t crcUpdate(uint32_t crc, const void* data, size_t length) {
+    const uint8_t* p = (const uint8_t*)data;
+    while (length-- > 0)
+        crc = crcTable[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+static uint32_t recordChecksum(const void* head, size_t headLength,
+                               const void* tail, size_t tailLength, uint64_t sequence) {
+    uint32_t crc = crcUpdate(0xFFFFFFFFu, head, headLength);
+    crc = crcUpdate(crc, tail, tailLength);
+    return ~crcUpdate(crc, &sequence, sizeof(sequence));
+}
+
+static uint8_t* putBytes(uint8_t* p, const void* data, size_t length) {
+    memcpy(p, data, length);
+    return p + length;
+}
+
+// Strings are a length byte and the characters, without the NUL
+static uint8_t* putString(uint8_t* p, const char* text) {
+    size_t length = strlen(text);
+    *p++ = (uint8_t)length;
+    return putBytes(p, text, length);
+}
+
+typedef struct {
+    const uint8_t* p;
+    const uint8_t* end;
+    bool ok;
+} RecordReader;
+
+static void getBytes(RecordReader* in, void* out, size_t length) {
+    if (!in->ok || (size_t)(in->end - in->p) < length) {
+        in->ok = false;
+        memset(out, 0, length);
+        return;
+    }
+    memcpy(out, in->p, length);
+    in->p += length;
+}
+
+static void getString(RecordReader* in, char* out, size_t capacity) {
+    uint8_t length = 0;
+    getBytes(in, &length, 1);
+    if (length >= capacity) in->ok = false;
+    if (!in->ok) {
+        out[0] = '\0';
+        return;
+    }
+    getBytes(in, out, length);
+    out[length] = '\0';
+}
+
+// Reads a preference list into ids; the payload itself is not aligned
+static int getPreferences(RecordReader* in, uint16_t* ids) {
+    uint16_t count = 0;
+    getBytes(in, &count, sizeof(count));
+    getBytes(in, ids, count * sizeof(uint16_t));
+    for (int i = 0; i < count && in->ok; i++)
+        if (ids[i] >= programCount) in->ok = false;
+    return count;
+}
+
+
+// ==========================================================
+//                    GROUP COMMIT WRITER
+// ==========================================================
+
+static bool writeAll(int fd, const void* data, size_t len) {
+    const char* p = (const char*)data;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+static void* writerMain(void* arg) {
+    Journal* j = (Journal*)arg;
+    pthread_mutex_lock(&j->lock);
+    while (1) {
+        while (j->pending_used == 0 && !j->stopping)
+            pthread_cond_wait(&j->wake, &j->lock);
+        if (j->pending_used == 0) break;
+
+        // Take the pending records; producers refill the other buffer
+        char* batch = j->pending;
+        size_t batchCapacity = j->pending_capacity;
+        size_t length = j->pending_used;
+        uint64_t last = j->last;
+        j->pending = j->writing;
+        j->pending_capacity = j->writing_capacity;
+        j->pending_used = 0;
+        j->writing = batch;
+        j->writing_capacity = batchCapacity;
+        j->busy = true;
+        bool failed = j->failed;
+        pthread_cond_broadcast(&j->synced);
+        pthread_mutex_unlock(&j->lock);
+
+        bool ok = !failed && writeAll(j->fd, batch, length) && fdatasync(j->fd) == 0;
+        int writeError = ok ? 0 : errno;  // Before anything else can change errno
+
+        pthread_mutex_lock(&j->lock);
+        j->busy = false;
+        if (ok) {
+            j->durable = last;
+            j->syncs++;
+        } else if (!j->failed) {
+            j->failed = true;
+            printf("\n%sError: Journal write failed: %s%s\n", COLOR_RED, strerror(writeError), COLOR_RESET);
+        }
+        pthread_cond_broadcast(&j->synced);
+    }
+    pthread_mutex_unlock(&j->lock);
+    return NULL;
+}
+
+// Queues one record made of head and tail and returns its sequence
+// number, or 0 once the journal has failed
+static uint64_t appendRecord(Journal* j, const void* head, size_t headLength,
+                             const void* tail, size_t tailLength) {
+    size_t length = headLength + tailLength;
+    size_t need = sizeof(JournalRecordHeader) + length;
+
+    pthread_mutex_lock(&j->lock);
+    while (j->pending_used > 0 && j->pending_used + need > JOURNAL_BUFFER_LIMIT && !j->failed)
+        pthread_cond_wait(&j->synced, &j->lock);
+    if (j->failed) {
+        pthread_mutex_unlock(&j->lock);
+        return 0;
+    }
+    if (j->pending_used + need > j->pending_capacity) {
+        size_t capacity = j->pending_capacity ? j->pending_capacity : 65536;
+        while (capacity < j->pending_used + need) capacity *= 2;
+        j->pending = (char*)realloc(j->pending, capacity);
+        j->pending_capacity = capacity;
+    }
+
+    JournalRecordHeader header;
+    header.length = (uint32_t)length;
+    header.sequence = ++j->last;
+    header.checksum = recordChecksum(head, headLength, tail, tailLength, header.sequence);
+    char* p = j->pending + j->pending_used;
+    memcpy(p, &header, sizeof(header));
+    memcpy(p + sizeof(header), head, headLength);
+    if (tailLength > 0) memcpy(p + sizeof(header) + headLength, tail, tailLength);
+    if (j->pending_used == 0) pthread_cond_signal(&j->wake);
+    j->pending_used += need;
+    j->records++;
+    pthread_mutex_unlock(&j->lock);
+    return header.sequence;
+}
+
+// Journals the registration of a student that is about to be enqueued:
+// the student's columns plus the DOB and Aadhar of its verification record
+uint64_t journalRegistration(Journal* j, Queue* q, StudentId student, const char* dob, const char* aadhar) {
+    const StudentStore* store = &q->students;
+    uint8_t fixed[JOURNAL_FIXED_BYTES];
+    uint8_t* p = fixed;
+    *p++ = JOURNAL_REGISTER;
+    *p++ = store->categories[student];
+    int32_t rank = store->rank[student];
+    p = putBytes(p, &rank, sizeof(rank));
+    p = putString(p, store->reg_number[student]);
+    p = putString(p, STUDENT_NAME(store, student));
+    p = putString(p, dob);
+    p = putString(p, aadhar);
+    uint16_t count = store->num_preferences[student];
+    p = putBytes(p, &count, sizeof(count));
+    return appendRecord(j, fixed, (size_t)(p - fixed), STUDENT_PREFS(q, student), count * sizeof(uint16_t));
+}
+
+// Journals a preference list that is about to replace a queued student's
+uint64_t journalPreferences(Journal* j, const char* reg_number, const uint16_t* ids, int count) {
+    uint8_t fixed[JOURNAL_FIXED_BYTES];
+    uint8_t* p = fixed;
+    *p++ = JOURNAL_PREFERENCES;
+    p = putString(p, reg_number);
+    uint16_t n = (uint16_t)count;
+    p = putBytes(p, &n, sizeof(n));
+    return appendRecord(j, fixed, (size_t)(p - fixed), ids, count * sizeof(uint16_t));
+}
+
+// Waits until the record with this sequence number is on disk
+bool journalSync(Journal* j, uint64_t sequence) {
+    pthread_mutex_lock(&j->lock);
+    while (j->durable < sequence && !j->failed)
+        pthread_cond_wait(&j->synced, &j->lock);
+    bool durable = (sequence != 0 && j->durable >= sequence);
+    pthread_mutex_unlock(&j->lock);
+    return durable;
+}
+
+uint64_t journalLastSequence(Journal* j) {
+    pthread_mutex_lock(&j->lock);
+    uint64_t last = j->last;
+    pthread_mutex_unlock(&j->lock);
+    return last;
+}
+
+void journalStats(Journal* j, long* records, long* syncs) {
+    pthread_mutex_lock(&j->lock);
+    *records = j->records;
+    *syncs = j->syncs;
+    pthread_mutex_unlock(&j->lock);
+}
+
+// Starts the file over, empty, continuing after base
+static bool resetJournalFile(int fd, uint64_t base) {
+    JournalFileHeader header = { JOURNAL_MAGIC, JOURNAL_VERSION, sizeof(JournalFileHeader), base };
+    return ftruncate(fd, 0) == 0 && writeAll(fd, &header, sizeof(header)) && fdatasync(fd) == 0;
+}
+
+// Called once a snapshot holding every record up to sequence has been
+// saved over the session's snapshot file: those records are dropped.
+// Nothing is dropped if records were added after the snapshot was taken.
+bool journalCheckpoint(Journal* j, uint64_t sequence) {
+    pthread_mutex_lock(&j->lock);
+    while ((j->busy || j->pending_used > 0) && !j->failed)
+        pthread_cond_wait(&j->synced, &j->lock);
+    bool ok = !j->failed && j->last == sequence;
+    if (ok && !resetJournalFile(j->fd, sequence)) {
+        j->failed = true;
+        ok = false;
+        printf("%sError: Cannot reset the journal: %s%s\n", COLOR_RED, strerror(errno), COLOR_RESET);
+    }
+    pthread_mutex_unlock(&j->lock);
+    return ok;
+}
+
+
+// ==========================================================
+//                     OPEN AND RECOVERY
+// ==========================================================
+
+// Applies a registration the way addNewStudent does; a record that does
+// not fit the queue is dropped, as it would have been when it was made
+static bool replayRegistration(Queue* q, RecordReader* in, uint16_t* ids) {
+    uint8_t categories = 0;
+    int32_t rank = 0;
+    char reg_number[MAX_REG_LENGTH], name[MAX_NAME_LENGTH], dob[15], aadhar[15];
+    getBytes(in, &categories, sizeof(categories));
+    getBytes(in, &rank, sizeof(rank));
+    getString(in, reg_number, sizeof(reg_number));
+    getString(in, name, sizeof(name));
+    getString(in, dob, sizeof(dob));
+    getString(in, aadhar, sizeof(aadhar));
+    int count = getPreferences(in, ids);
+    if (!in->ok || in->p != in->end || rank < 1 || (categories >> seatPoolCount) != 0 ||
+        !isValidRegNumber(reg_number) || rankExists(q, rank) ||
+        findStudentByReg(reg_number) != NO_STUDENT)
+        return false;
+
+    StudentId student = allocStudent(q);
+    StudentStore* store = &q->students;
+    strcpy(store->reg_number[student], reg_number);
+    setStudentName(q, student, name);
+    store->rank[student] = rank;
+    store->flags[student] = STUDENT_VERIFIED;
+    store->categories[student] = categories;
+    setStudentPreferences(q, student, ids, count);
+    store->allocated_program[student] = PROGRAM_NOT_ALLOCATED;
+    if (!addToVerificationData(reg_number, name, dob, aadhar)) {
+        releaseStudent(q, student);
+        return false;
+    }
+    enqueue(q, student);
+    return true;
+}
+
+// Applies a preference edit the way updateStudentPreferences does
+static bool replayPreferences(Queue* q, RecordReader* in, uint16_t* ids) {
+    char reg_number[MAX_REG_LENGTH];
+    getString(in, reg_number, sizeof(reg_number));
+    int count = getPreferences(in, ids);
+    StudentId student = in->ok && in->p == in->end ? findStudentByReg(reg_number) : NO_STUDENT;
+    if (student == NO_STUDENT) return false;
+
+    setStudentPreferences(q, student, ids, count);
+    commitPreferenceUpdate(q, student);
+    return true;
+}
+
+// Walks the records after the file header, applying those after the
+// queue's sequence. Returns the end of the last good record and sets
+// *last to its sequence.
+static size_t replayRecords(Queue* q, const uint8_t* base, size_t size,
+                            uint64_t* last, JournalRecovery* recovery) {
+    const JournalFileHeader* fileHeader = (const JournalFileHeader*)base;
+    uint16_t* ids = (uint16_t*)malloc(65536 * sizeof(uint16_t));
+    uint64_t expected = fileHeader->base_sequence + 1;
+    size_t offset = sizeof(JournalFileHeader);
+
+    while (size - offset >= sizeof(JournalRecordHeader)) {
+        JournalRecordHeader header;
+        memcpy(&header, base + offset, sizeof(header));
+        const uint8_t* payload = base + offset + sizeof(header);
+        if (header.length == 0 || header.length > JOURNAL_MAX_PAYLOAD ||
+            header.length > size - offset - sizeof(header) || header.sequence != expected ||
+            recordChecksum(payload, header.length, NULL, 0, header.sequence) != header.checksum)
+            break;
+
+        if (header.sequence > q->journal_sequence) {
+            RecordReader in = { payload + 1, payload + header.length, true };
+            bool applied = false;
+            if (payload[0] == JOURNAL_REGISTER) applied = replayRegistration(q, &in, ids);
+            else if (payload[0] == JOURNAL_PREFERENCES) applied = replayPreferences(q, &in, ids);
+            if (applied) recovery->replayed++;
+            else recovery->rejected++;
+        } else {
+            recovery->skipped++;
+        }
+        offset += sizeof(header) + header.length;
+        expected++;
+    }
+    free(ids);
+    *last = expected - 1;
+    return offset;
+}
+
+static void releaseJournal(Journal* j) {
+    close(j->fd);
+    pthread_mutex_destroy(&j->lock);
+    pthread_cond_destroy(&j->wake);
+    pthread_cond_destroy(&j->synced);
+    free(j->pending);
+    free(j->writing);
+    free(j);
+}
+
+// Opens (or creates) the journal at path, replays it onto q and starts
+// the writer. Returns NULL if the file is not a journal or does not
+// continue from the queue's state.
+Journal* journalOpen(Queue* q, const char* path, JournalRecovery* recovery) {
+    memset(recovery, 0, sizeof(JournalRecovery));
+    double t0 = monotonicSeconds();
+    pthread_once(&crcOnce, buildCrcTable);
+
+    int fd = open(path, O_RDWR | O_APPEND | O_CREAT, 0644);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        printf("%sError: Cannot open journal %s: %s%s\n", COLOR_RED, path, strerror(errno), COLOR_RESET);
+        if (fd >= 0) close(fd);
+        return NULL;
+    }
+
+    uint64_t last = q->journal_sequence;
+    size_t size = (size_t)st.st_size;
+    bool fresh = (size == 0);
+    const char* error = NULL;
+    if (!fresh) {
+        void* base = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        const JournalFileHeader* header = (const JournalFileHeader*)base;
+        if (base == MAP_FAILED || size < sizeof(JournalFileHeader) || header->magic != JOURNAL_MAGIC) {
+            error = "not a journal file";
+        } else if (header->version != JOURNAL_VERSION || header->header_size != sizeof(JournalFileHeader)) {
+            error = "unsupported journal version";
+        } else if (header->base_sequence > q->journal_sequence) {
+            error = "journal starts after the snapshot; records are missing";
+        } else {
+            size_t end = replayRecords(q, (const uint8_t*)base, size, &last, recovery);
+            if (last < q->journal_sequence) {
+                // The snapshot is newer than anything in the journal
+                fresh = true;
+                last = q->journal_sequence;
+            } else if (end < size) {
+                recovery->torn_bytes = (long)(size - end);
+                if (ftruncate(fd, (off_t)end) != 0 || fdatasync(fd) != 0)
+                    error = strerror(errno);
+            }
+        }
+        if (base != MAP_FAILED) munmap(base, size);
+    }
+    if (error == NULL && fresh && !resetJournalFile(fd, last))
+        error = strerror(errno);
+    if (error != NULL) {
+        printf("%sError: %s: %s%s\n", COLOR_RED, path, error, COLOR_RESET);
+        close(fd);
+        return NULL;
+    }
+
+    Journal* j = (Journal*)calloc(1, sizeof(Journal));
+    j->fd = fd;
+    j->last = j->durable = last;
+    pthread_mutex_init(&j->lock, NULL);
+    pthread_cond_init(&j->wake, NULL);
+    pthread_cond_init(&j->synced, NULL);
+    if (pthread_create(&j->writer, NULL, writerMain, j) != 0) {
+        printf("%sError: Cannot start the journal writer%s\n", COLOR_RED, COLOR_RESET);
+        releaseJournal(j);
+        return NULL;
+    }
+    recovery->seconds = monotonicSeconds() - t0;
+    return j;
+}
+
+// Writes out and syncs whatever is pending, then closes the file
+void journalClose(Journal* j) {
+    if (j == NULL) return;
+
+    pthread_mutex_lock(&j->lock);
+    j->stopping = true;
+    pthread_cond_signal(&j->wake);
+    pthread_mutex_unlock(&j->lock);
+    pthread_join(j->writer, NULL);
+    releaseJournal(j);
+}
@@ -0,0 +1,190 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "enhanced_ds.h"
+
+// ==========================================================
+//   HOT-PATH METRICS
+//
+//   Counters are bumped in place with relaxed atomic adds; no
+//   counter shares a cache line with another, so threads that
+//   count different things do not slow each other down. A
+//   histogram keeps a count, sum and maximum and one bucket per
+//   power of two, so recording is a bit scan and three adds.
+//   Loops that record a value per item fill a MetricBlock on
+//   their own and merge it once at the end. Percentiles are
+//   read off the buckets, so they are upper bounds within a
+//   factor of two.
+// ==========================================================
+
+typedef struct {
+    _Atomic uint64_t count;
+    _Atomic uint64_t sum;
+    _Atomic uint64_t max;
+    _Atomic uint64_t buckets[METRIC_BUCKETS];
+} SharedHistogram;
+
+MetricSlot metricCounters[METRIC_COUNTER_COUNT];
+static SharedHistogram histograms[METRIC_HISTOGRAM_COUNT];
+
+static const char* counterNames[METRIC_COUNTER_COUNT] = {
+    "enqueues", "rank_bitmap_lookups", "rank_tree_lookups", "verify_passed", "verify_failed",
+    "claim_checks", "allocation_runs", "preference_probes", "seats_exhausted", "displacements",
+    "allocated", "not_allocated", "not_eligible", "cleanups"
+};
+
+static const struct {
+    const char* name;
+    const char* unit;
+} histogramInfo[METRIC_HISTOGRAM_COUNT] = {
+    { "enqueue", "ns" },
+    { "bulk_enqueue", "ns" },
+    { "rank_tree_lookup", "ns" },
+    { "claim_check", "ns" },
+    { "allocation", "ns" },
+    { "probes_per_student", "probes" },
+    { "cleanup", "ns" }
+};
+
+uint64_t metricNow(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int bucketOf(uint64_t value) {
+    int bucket = (value == 0) ? 0 : 64 - __builtin_clzll(value);
+    return bucket < METRIC_BUCKETS ? bucket : METRIC_BUCKETS - 1;
+}
+
+static void raiseMax(_Atomic uint64_t* max, uint64_t value) {
+    uint64_t seen = atomic_load_explicit(max, memory_order_relaxed);
+    while (value > seen &&
+           !atomic_compare_exchange_weak_explicit(max, &seen, value, memory_order_relaxed,
+                                                  memory_order_relaxed))
+        ;
+}
+
+void metricRecord(MetricHistogram histogram, uint64_t value) {
+    SharedHistogram* h = &histograms[histogram];
+    atomic_fetch_add_explicit(&h->count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->sum, value, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->buckets[bucketOf(value)], 1, memory_order_relaxed);
+    raiseMax(&h->max, value);
+}
+
+void metricBlockRecord(MetricBlock* block, uint64_t value) {
+    block->count++;
+    block->sum += value;
+    if (value > block->max) block->max = value;
+    block->buckets[bucketOf(value)]++;
+}
+
+void metricMerge(MetricHistogram histogram, const MetricBlock* block) {
+    if (block->count == 0) return;
+    SharedHistogram* h = &histograms[histogram];
+    atomic_fetch_add_explicit(&h->count, block->count, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->sum, block->sum, memory_order_relaxed);
+    for (int b = 0; b < METRIC_BUCKETS; b++)
+        if (block->buckets[b] != 0)
+            atomic_fetch_add_explicit(&h->buckets[b], block->buckets[b], memory_order_relaxed);
+    raiseMax(&h->max, block->max);
+}
+
+bool metricsEnabled(void) {
+#ifndef COMEDK_NO_METRICS
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Copies a histogram out so a report sees one consistent-enough picture
+static void readHistogram(MetricHistogram histogram, MetricBlock* out) {
+    const SharedHistogram* h = &histograms[histogram];
+    out->count = atomic_load_explicit(&h->count, memory_order_relaxed);
+    out->sum = atomic_load_explicit(&h->sum, memory_order_relaxed);
+    out->max = atomic_load_explicit(&h->max, memory_order_relaxed);
+    for (int b = 0; b < METRIC_BUCKETS; b++)
+        out->buckets[b] = atomic_load_explicit(&h->buckets[b], memory_order_relaxed);
+}
+
+// Upper bound of the bucket holding the given fraction of the values,
+// capped at the largest value seen
+static uint64_t percentile(const MetricBlock* h, double fraction) {
+    if (h->count == 0) return 0;
+    uint64_t target = h->count - (uint64_t)((1.0 - fraction) * h->count);  // Rounded up
+    uint64_t seen = 0;
+    for (int b = 0; b < METRIC_BUCKETS; b++) {
+        seen += h->buckets[b];
+        if (seen >= target) {
+            uint64_t upper = (b == 0) ? 0 : (1ULL << b) - 1;
+            return upper < h->max ? upper : h->max;
+        }
+    }
+    return h->max;
+}
+
+static uint64_t counterValue(int counter) {
+    return atomic_load_explicit(&metricCounters[counter].value, memory_order_relaxed);
+}
+
+void metricsReport(void) {
+    if (!metricsEnabled()) {
+        printf("Metrics: not built in (COMEDK_NO_METRICS)\n");
+        return;
+    }
+    printf("%-22s %14s\n", "Counter", "Value");
+    for (int c = 0; c < METRIC_COUNTER_COUNT; c++)
+        printf("%-22s %14llu\n", counterNames[c], (unsigned long long)counterValue(c));
+
+    printf("\n%-22s %-7s %10s %12s %12s %12s %12s\n",
+           "Histogram", "Unit", "Count", "Mean", "p50", "p99", "Max");
+    for (int i = 0; i < METRIC_HISTOGRAM_COUNT; i++) {
+        MetricBlock h;
+        readHistogram((MetricHistogram)i, &h);
+        printf("%-22s %-7s %10llu", histogramInfo[i].name, histogramInfo[i].unit, (unsigned long long)h.count);
+        if (h.count == 0) {
+            printf(" %12s %12s %12s %12s\n", "-", "-", "-", "-");
+            continue;
+        }
+        printf(" %12.1f %12llu %12llu %12llu\n", (double)h.sum / h.count,
+               (unsigned long long)percentile(&h, 0.50), (unsigned long long)percentile(&h, 0.99),
+               (unsigned long long)h.max);
+    }
+}
+
+bool writeMetricsJson(const char* path) {
+    FILE* out = fopen(path, "w");
+    if (out == NULL) return false;
+
+    fprintf(out, "{\"enabled\":%s,\"counters\":{", metricsEnabled() ? "true" : "false");
+    for (int c = 0; c < METRIC_COUNTER_COUNT; c++)
+        fprintf(out, "%s\"%s\":%llu", c ? "," : "", counterNames[c], (unsigned long long)counterValue(c));
+    fprintf(out, "},\n \"histograms\":{");
+    for (int i = 0; i < METRIC_HISTOGRAM_COUNT; i++) {
+        MetricBlock h;
+        readHistogram((MetricHistogram)i, &h);
+        fprintf(out, "%s\n  \"%s\":{\"unit\":\"%s\",\"count\":%llu,\"sum\":%llu,\"max\":%llu,"
+                "\"p50\":%llu,\"p90\":%llu,\"p99\":%llu,\"buckets\":[",
+                i ? "," : "", histogramInfo[i].name, histogramInfo[i].unit,
+                (unsigned long long)h.count, (unsigned long long)h.sum, (unsigned long long)h.max,
+                (unsigned long long)percentile(&h, 0.50), (unsigned long long)percentile(&h, 0.90),
+                (unsigned long long)percentile(&h, 0.99));
+        // Only buckets with values; "below" is the bucket's exclusive upper bound
+        bool first = true;
+        for (int b = 0; b < METRIC_BUCKETS; b++) {
+            if (h.buckets[b] == 0) continue;
+            fprintf(out, "%s{\"below\":", first ? "" : ",");
+            if (b == METRIC_BUCKETS - 1) fprintf(out, "null");
+            else fprintf(out, "%llu", 1ULL << b);
+            fprintf(out, ",\"count\":%llu}", (unsigned long long)h.buckets[b]);
+            first = false;
+        }
+        fprintf(out, "]}");
+    }
+    fprintf(out, "\n }}\n");
+    return fclose(out) == 0;
+}
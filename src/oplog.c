@@ -0,0 +1,239 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "enhanced_ds.h"
+
+// ==========================================================
+//   BINARY OPERATION LOG
+//
+//   Producers claim a sequence number, fill the matching ring
+//   slot and publish it by storing seq + 1 in the slot. The
+//   writer thread drains published slots in order and appends
+//   them to the log file. Without a file the ring simply keeps
+//   the most recent OPLOG_CAPACITY records.
+// ==========================================================
+
+#define OPLOG_MASK        (OPLOG_CAPACITY - 1)
+#define OPLOG_WRITE_BATCH 4096
+#define OPLOG_FLUSH_MS    100
+
+typedef struct {
+    _Atomic uint64_t seq;  // Sequence + 1 once the record is published
+    OpRecord record;
+} OpSlot;
+
+struct OpLog {
+    OpSlot* ring;
+    _Atomic uint64_t head;  // Next sequence to hand out
+    _Atomic uint64_t tail;  // Next sequence the writer will flush
+    int fd;                 // -1 when the log is memory only
+    pthread_t writer;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    _Atomic bool stopping;
+};
+
+static const OpLogFileHeader fileHeader = {
+    OPLOG_MAGIC, OPLOG_VERSION, (uint32_t)sizeof(OpRecord)
+};
+
+static uint64_t realtimeNanos(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+OpLog* opLogCreate(void) {
+    OpLog* log = (OpLog*)calloc(1, sizeof(OpLog));
+    log->ring = (OpSlot*)calloc(OPLOG_CAPACITY, sizeof(OpSlot));
+    log->fd = -1;
+    pthread_mutex_init(&log->lock, NULL);
+    pthread_cond_init(&log->wake, NULL);
+    return log;
+}
+
+static bool writeAll(int fd, const void* data, size_t len) {
+    const char* p = (const char*)data;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+// Appends every published record after tail to the file
+static void drainRing(OpLog* log, OpRecord* batch) {
+    uint64_t tail = atomic_load_explicit(&log->tail, memory_order_relaxed);
+
+    while (1) {
+        int n = 0;
+        while (n < OPLOG_WRITE_BATCH) {
+            OpSlot* slot = &log->ring[(tail + n) & OPLOG_MASK];
+            if (atomic_load_explicit(&slot->seq, memory_order_acquire) != tail + n + 1)
+                break;
+            batch[n++] = slot->record;
+        }
+        if (n == 0) return;
+
+        writeAll(log->fd, batch, (size_t)n * sizeof(OpRecord));
+        tail += (uint64_t)n;
+        atomic_store_explicit(&log->tail, tail, memory_order_release);
+    }
+}
+
+static void* writerMain(void* arg) {
+    OpLog* log = (OpLog*)arg;
+    OpRecord* batch = (OpRecord*)malloc(OPLOG_WRITE_BATCH * sizeof(OpRecord));
+
+    while (!atomic_load(&log->stopping)) {
+        drainRing(log, batch);
+
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += OPLOG_FLUSH_MS * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        pthread_mutex_lock(&log->lock);
+        if (!atomic_load(&log->stopping))
+            pthread_cond_timedwait(&log->wake, &log->lock, &deadline);
+        pthread_mutex_unlock(&log->lock);
+    }
+    drainRing(log, batch);
+    free(batch);
+    return NULL;
+}
+
+bool opLogOpenFile(OpLog* log, const char* path) {
+    if (log->fd >= 0) return false;
+
+    int fd = open(path, O_WRONLY | O_APPEND | O_CREAT, 0644);
+    if (fd < 0) return false;
+
+    // New files start with a header so the dump tool can check the format
+    if (lseek(fd, 0, SEEK_END) == 0 && !writeAll(fd, &fileHeader, sizeof(fileHeader))) {
+        close(fd);
+        return false;
+    }
+
+    // Only records logged from now on go to the file
+    atomic_store(&log->tail, atomic_load(&log->head));
+    log->fd = fd;
+    if (pthread_create(&log->writer, NULL, writerMain, log) != 0) {
+        close(fd);
+        log->fd = -1;
+        return false;
+    }
+    return true;
+}
+
+void opLogAppend(OpLog* log, uint8_t op, int32_t rank, int32_t program_id) {
+    uint64_t seq = atomic_fetch_add_explicit(&log->head, 1, memory_order_relaxed);
+
+    if (log->fd >= 0) {
+        // Ring full: hand the writer a nudge and wait for space
+        while (seq - atomic_load_explicit(&log->tail, memory_order_acquire) >= OPLOG_CAPACITY) {
+            pthread_cond_signal(&log->wake);
+            sched_yield();
+        }
+    }
+
+    OpSlot* slot = &log->ring[seq & OPLOG_MASK];
+    atomic_store_explicit(&slot->seq, 0, memory_order_relaxed);
+    slot->record.timestamp_ns = realtimeNanos();
+    slot->record.rank = rank;
+    slot->record.program_id = program_id;
+    slot->record.op = op;
+    memset(slot->record.reserved, 0, sizeof(slot->record.reserved));
+    atomic_store_explicit(&slot->seq, seq + 1, memory_order_release);
+
+    if (log->fd >= 0 && (seq & (OPLOG_CAPACITY / 2 - 1)) == 0)
+        pthread_cond_signal(&log->wake);
+}
+
+// Copies up to max of the newest records into out, newest first
+int opLogRecent(OpLog* log, OpRecord* out, int max) {
+    uint64_t head = atomic_load_explicit(&log->head, memory_order_acquire);
+    int n = 0;
+
+    for (uint64_t seq = head; seq > 0 && n < max && head - seq < OPLOG_CAPACITY; seq--) {
+        OpSlot* slot = &log->ring[(seq - 1) & OPLOG_MASK];
+        if (atomic_load_explicit(&slot->seq, memory_order_acquire) != seq)
+            continue;  // Not published yet or already overwritten
+        OpRecord copy = slot->record;
+        if (atomic_load_explicit(&slot->seq, memory_order_acquire) != seq)
+            continue;
+        out[n++] = copy;
+    }
+    return n;
+}
+
+uint64_t opLogCount(OpLog* log) {
+    return atomic_load(&log->head);
+}
+
+void opLogDestroy(OpLog* log) {
+    if (log == NULL) return;
+
+    if (log->fd >= 0) {
+        pthread_mutex_lock(&log->lock);
+        atomic_store(&log->stopping, true);
+        pthread_cond_signal(&log->wake);
+        pthread_mutex_unlock(&log->lock);
+        pthread_join(log->writer, NULL);
+        close(log->fd);
+    }
+    pthread_mutex_destroy(&log->lock);
+    pthread_cond_destroy(&log->wake);
+    free(log->ring);
+    free(log);
+}
+
+const char* opCodeName(uint8_t op) {
+    switch (op) {
+        case OP_QUEUE_INIT:          return "Queue initialized";
+        case OP_ENQUEUE:             return "Enqueued student";
+        case OP_ALLOCATE:            return "Allocated student";
+        case OP_NOT_ALLOCATED:       return "Student could not be allocated";
+        case OP_UPDATE_PREFERENCES:  return "Updated preferences";
+        case OP_ROUND_STARTED:       return "Started counselling round";
+        case OP_WITHDRAWN:           return "Student exited";
+        default:                     return "Unknown operation";
+    }
+}
+
+// Text form of a record: "YYYY-MM-DD HH:MM:SS.mmm <operation> rank R [program P]"
+int formatOpRecord(const OpRecord* record, char* buf, size_t len) {
+    time_t seconds = (time_t)(record->timestamp_ns / 1000000000ULL);
+    int millis = (int)(record->timestamp_ns / 1000000ULL % 1000);
+    struct tm tm;
+    localtime_r(&seconds, &tm);
+
+    char when[32];
+    strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", &tm);
+
+    if (record->op == OP_QUEUE_INIT)
+        return snprintf(buf, len, "%s.%03d %s", when, millis, opCodeName(record->op));
+    if (record->op == OP_ROUND_STARTED)
+        return snprintf(buf, len, "%s.%03d %s %d", when, millis,
+                        opCodeName(record->op), record->rank);
+    if (record->op == OP_ALLOCATE)
+        return snprintf(buf, len, "%s.%03d %s rank %d to program %d", when, millis,
+                        opCodeName(record->op), record->rank, record->program_id);
+    return snprintf(buf, len, "%s.%03d %s rank %d", when, millis,
+                    opCodeName(record->op), record->rank);
+}
@@ -0,0 +1,60 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "enhanced_ds.h"
+
+// ==========================================================
+//   OFFLINE OPERATION LOG DUMP
+//
+//   Usage: oplog_dump <oplog file> [--last N]
+//   Prints the binary records written by the operation log
+//   writer as text, oldest first.
+// ==========================================================
+
+int main(int argc, char* argv[]) {
+    long last = -1;
+    if (argc == 4 && strcmp(argv[2], "--last") == 0) {
+        last = atol(argv[3]);
+    } else if (argc != 2) {
+        printf("Usage: %s <oplog file> [--last N]\n", argv[0]);
+        return 1;
+    }
+
+    FILE* in = fopen(argv[1], "rb");
+    if (in == NULL) {
+        printf("%sError: Cannot open %s%s\n", COLOR_RED, argv[1], COLOR_RESET);
+        return 1;
+    }
+
+    OpLogFileHeader header;
+    if (fread(&header, sizeof(header), 1, in) != 1 ||
+        header.magic != OPLOG_MAGIC ||
+        header.version != OPLOG_VERSION ||
+        header.record_size != sizeof(OpRecord)) {
+        printf("%sError: %s is not an operation log (version %d)%s\n",
+               COLOR_RED, argv[1], OPLOG_VERSION, COLOR_RESET);
+        fclose(in);
+        return 1;
+    }
+
+    // Skip ahead when only the newest records are wanted
+    if (last >= 0) {
+        fseek(in, 0, SEEK_END);
+        long total = (ftell(in) - (long)sizeof(header)) / (long)sizeof(OpRecord);
+        long skip = total > last ? total - last : 0;
+        fseek(in, (long)sizeof(header) + skip * (long)sizeof(OpRecord), SEEK_SET);
+    }
+
+    OpRecord records[4096];
+    size_t n;
+    char text[128];
+    while ((n = fread(records, sizeof(OpRecord), 4096, in)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            formatOpRecord(&records[i], text, sizeof(text));
+            puts(text);
+        }
+    }
+
+    fclose(in);
+    return 0;
+}
@@ -0,0 +1,417 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "enhanced_ds.h"
+
+// ==========================================================
+//   SEAT POOL ALLOCATION
+//
+//   With several seat pools a student's options are (program,
+//   pool) pairs: preferences in order and, for one program,
+//   pools in catalog order. The outcome is serial dictatorship
+//   over those options, computed pool by pool so that the pools
+//   can be filled at the same time:
+//
+//   1. Every pool runs serial dictatorship over its own eligible
+//      students in rank order. These passes share nothing and
+//      run on the worker threads.
+//   2. A serial merge keeps each student's best option over all
+//      pools. A student holding a seat elsewhere only competes
+//      in a pool for options better than that seat, so seats
+//      they will not keep go back to the students behind them.
+//   3. Pools in which some student's best option changed run
+//      again from that student onwards, and stop once past the
+//      last such student with the same seats left as the pass
+//      before; repeat until nothing changes.
+//
+//   When nothing changes every pool holder is better ranked
+//   than anyone who wanted the seat, which only the serial
+//   outcome satisfies. Each pass is a pure function of the
+//   previous merge, so the result is the same for any number
+//   of threads. The state is kept after an allocation, and a
+//   preference edit restarts the passes from the edited
+//   student instead of from scratch.
+// ==========================================================
+
+// Result of a student in one pool: preference index and program id
+#define POOL_NO_SEAT          UINT32_MAX
+#define POOL_TAKEN(pref, pid) (((uint32_t)(pref) << 16) | (uint32_t)(pid))
+#define TAKEN_PREF(taken)     ((int)((taken) >> 16))
+#define TAKEN_PROGRAM(taken)  ((int)((taken) & 0xFFFF))
+
+// Best option of a student over all pools: preference * pools + pool
+#define NO_OPTION INT32_MAX
+
+// An edit that has not settled after this many passes is redone in full
+#define POOL_UPDATE_MAX_PASSES 64
+
+// Members whose result in a pool changed during its last pass
+typedef struct {
+    StudentId* students;
+    int count;
+    int capacity;
+} PoolChanges;
+
+struct SeatPoolRun {
+    Queue* q;
+    int pools;
+    int students;        // Store count when the run was built
+    StudentId* members;  // Eligible students of each pool, in rank order
+    int* memberStart;    // Pool k owns members[memberStart[k] .. memberStart[k + 1])
+    uint32_t* taken;     // pools x students: POOL_TAKEN or POOL_NO_SEAT
+    int32_t* best;       // Per student: best option or NO_OPTION
+    int* restart;        // Per pool: first member to re-evaluate
+    int* lastChange;     // Per pool: last member whose best option changed
+    int* seats;          // pools x programCount working seat counts
+    int* delta;          // pools x programCount: seats now - seats last pass
+    long evaluated[MAX_SEAT_POOLS];  // Members run through each pool
+    PoolChanges changes[MAX_SEAT_POOLS];
+    PoolChanges moved;   // Students whose best option changed
+    StudentId recheck;   // Merged even if none of its results changed
+    int active[MAX_SEAT_POOLS];  // Pools to run in this pass
+    int active_count;
+};
+
+static void noteChange(PoolChanges* changes, StudentId student) {
+    if (changes->count == changes->capacity) {
+        changes->capacity = changes->capacity ? changes->capacity * 2 : 1024;
+        changes->students = (StudentId*)realloc(changes->students,
+                                                changes->capacity * sizeof(StudentId));
+    }
+    changes->students[changes->count++] = student;
+}
+
+static int poolMemberCount(const SeatPoolRun* run, int k) {
+    return run->memberStart[k + 1] - run->memberStart[k];
+}
+
+// Position of the member with the given rank, or of the first one after it
+static int memberPosition(const SeatPoolRun* run, int k, int rank) {
+    const StudentId* members = run->members + run->memberStart[k];
+    const int* ranks = run->q->students.rank;
+    int lo = 0, hi = poolMemberCount(run, k);
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (ranks[members[mid]] < rank) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// One serial-dictatorship pass over a pool, from member restart[k] onwards
+static void runPoolPass(void* context, int task) {
+    SeatPoolRun* run = (SeatPoolRun*)context;
+    Queue* q = run->q;
+    const StudentStore* store = &q->students;
+    int k = run->active[task];
+    const StudentId* members = run->members + run->memberStart[k];
+    int memberCount = poolMemberCount(run, k);
+    uint32_t* taken = run->taken + (size_t)k * run->students;
+    int* seats = run->seats + (size_t)k * programCount;
+    int* delta = run->delta + (size_t)k * programCount;
+    PoolChanges* changes = &run->changes[k];
+    changes->count = 0;
+
+    // Seats left at the restart point: replay the unchanged prefix
+    memcpy(seats, poolCapacity + (size_t)k * programCount, programCount * sizeof(int));
+    for (int i = 0; i < run->restart[k]; i++) {
+        uint32_t result = taken[members[i]];
+        if (result != POOL_NO_SEAT)
+            seats[TAKEN_PROGRAM(result)]--;
+    }
+
+    memset(delta, 0, programCount * sizeof(int));
+    int differing = 0;
+    int i;
+    for (i = run->restart[k]; i < memberCount; i++) {
+        StudentId s = members[i];
+        const uint16_t* prefs = STUDENT_PREFS(q, s);
+        int limit = store->num_preferences[s];
+
+        // Held elsewhere: only options better than that seat count here
+        int32_t held = run->best[s];
+        if (held != NO_OPTION && held % run->pools != k) {
+            int bound = held / run->pools + (k < held % run->pools ? 1 : 0);
+            if (bound < limit) limit = bound;
+        }
+
+        uint32_t result = POOL_NO_SEAT;
+        for (int j = 0; j < limit; j++) {
+            if (seats[prefs[j]] > 0) {
+                seats[prefs[j]]--;
+                result = POOL_TAKEN(j, prefs[j]);
+                break;
+            }
+        }
+
+        uint32_t previous = taken[s];
+        if (result != previous) {
+            taken[s] = result;
+            noteChange(changes, s);
+            if (previous != POOL_NO_SEAT) {
+                int p = TAKEN_PROGRAM(previous);
+                differing += (delta[p] == 0) - (delta[p] == -1);
+                delta[p]++;
+            }
+            if (result != POOL_NO_SEAT) {
+                int p = TAKEN_PROGRAM(result);
+                differing += (delta[p] == 0) - (delta[p] == 1);
+                delta[p]--;
+            }
+        }
+
+        // Same seats as the last pass and no later changes: the rest stands
+        if (differing == 0 && i >= run->lastChange[k]) {
+            i++;
+            break;
+        }
+    }
+    run->evaluated[k] += i - run->restart[k];
+}
+
+// Recomputes one student's best option; widens the per-pool rank range to
+// re-run when it changed
+static void mergeStudent(SeatPoolRun* run, StudentId s, int* firstRank, int* lastRank,
+                         int* changed) {
+    const StudentStore* store = &run->q->students;
+    int pools = run->pools;
+    uint8_t categories = store->categories[s];
+    int32_t option = NO_OPTION;
+    for (int k = 0; k < pools; k++) {
+        if (!(categories & (1u << k))) continue;
+        uint32_t result = run->taken[(size_t)k * run->students + s];
+        if (result != POOL_NO_SEAT && TAKEN_PREF(result) * pools + k < option)
+            option = TAKEN_PREF(result) * pools + k;
+    }
+    if (option == run->best[s]) return;  // Also skips repeats
+
+    run->best[s] = option;
+    noteChange(&run->moved, s);
+    (*changed)++;
+    int rank = store->rank[s];
+    for (int k = 0; k < pools; k++) {
+        if (!(categories & (1u << k))) continue;
+        if (rank < firstRank[k]) firstRank[k] = rank;
+        if (rank > lastRank[k]) lastRank[k] = rank;
+    }
+}
+
+// Updates the best option of every student whose result changed in the
+// last pass and marks where each pool must re-run. Returns the number of
+// students whose best option changed.
+static int mergePools(SeatPoolRun* run) {
+    int firstRank[MAX_SEAT_POOLS], lastRank[MAX_SEAT_POOLS];
+    int changed = 0;
+
+    for (int k = 0; k < run->pools; k++) {
+        firstRank[k] = INT32_MAX;
+        lastRank[k] = -1;
+    }
+
+    for (int c = 0; c < run->active_count; c++) {
+        const PoolChanges* changes = &run->changes[run->active[c]];
+        for (int i = 0; i < changes->count; i++)
+            mergeStudent(run, changes->students[i], firstRank, lastRank, &changed);
+    }
+    if (run->recheck != NO_STUDENT) {
+        mergeStudent(run, run->recheck, firstRank, lastRank, &changed);
+        run->recheck = NO_STUDENT;
+    }
+
+    for (int k = 0; k < run->pools; k++) {
+        bool moved = (lastRank[k] >= 0);
+        run->restart[k] = moved ? memberPosition(run, k, firstRank[k]) : poolMemberCount(run, k);
+        run->lastChange[k] = moved ? memberPosition(run, k, lastRank[k]) : -1;
+    }
+    return changed;
+}
+
+// Runs passes until nothing changes. Returns the number of passes, or -1
+// if maxPasses were not enough.
+static int settlePools(SeatPoolRun* run, int maxPasses) {
+    int passes = 0;
+    while (1) {
+        run->active_count = 0;
+        for (int k = 0; k < run->pools; k++)
+            if (run->restart[k] < poolMemberCount(run, k))
+                run->active[run->active_count++] = k;
+        if (run->active_count == 0) return passes;
+        if (passes == maxPasses) return -1;
+
+        runParallel(runPoolPass, run, run->active_count);
+        passes++;
+        if (mergePools(run) == 0) return passes;
+    }
+}
+
+static SeatPoolRun* buildPoolRun(Queue* q) {
+    StudentStore* store = &q->students;
+    int pools = seatPoolCount;
+    SeatPoolRun* run = (SeatPoolRun*)calloc(1, sizeof(SeatPoolRun));
+    run->q = q;
+    run->pools = pools;
+    run->students = store->count;
+    run->recheck = NO_STUDENT;
+
+    // Bucket the verified students by pool, keeping rank order
+    run->memberStart = (int*)calloc(pools + 1, sizeof(int));
+    int memberTotal = 0;
+    for (StudentId s = q->front; s != NO_STUDENT; s = store->next[s]) {
+        if (!(store->flags[s] & STUDENT_VERIFIED)) continue;
+        store->categories[s] |= POOL_GENERAL;
+        for (int k = 0; k < pools; k++)
+            if (store->categories[s] & (1u << k)) {
+                run->memberStart[k + 1]++;
+                memberTotal++;
+            }
+    }
+    for (int k = 0; k < pools; k++)
+        run->memberStart[k + 1] += run->memberStart[k];
+
+    run->members = (StudentId*)malloc((memberTotal ? memberTotal : 1) * sizeof(StudentId));
+    int fill[MAX_SEAT_POOLS];
+    memcpy(fill, run->memberStart, pools * sizeof(int));
+    for (StudentId s = q->front; s != NO_STUDENT; s = store->next[s]) {
+        if (!(store->flags[s] & STUDENT_VERIFIED)) continue;
+        for (int k = 0; k < pools; k++)
+            if (store->categories[s] & (1u << k))
+                run->members[fill[k]++] = s;
+    }
+
+    size_t students = run->students ? run->students : 1;
+    run->taken = (uint32_t*)malloc((size_t)pools * students * sizeof(uint32_t));
+    memset(run->taken, 0xFF, (size_t)pools * students * sizeof(uint32_t));
+    run->best = (int32_t*)malloc(students * sizeof(int32_t));
+    for (size_t i = 0; i < students; i++) run->best[i] = NO_OPTION;
+
+    // The first pass covers every member of every pool
+    run->restart = (int*)calloc(pools, sizeof(int));
+    run->lastChange = (int*)malloc(pools * sizeof(int));
+    for (int k = 0; k < pools; k++)
+        run->lastChange[k] = poolMemberCount(run, k);
+    run->seats = (int*)malloc((size_t)pools * programCount * sizeof(int));
+    run->delta = (int*)malloc((size_t)pools * programCount * sizeof(int));
+    return run;
+}
+
+void releaseSeatPools(SeatPoolRun* run) {
+    if (run == NULL) return;
+    free(run->members);
+    free(run->memberStart);
+    free(run->taken);
+    free(run->best);
+    free(run->restart);
+    free(run->lastChange);
+    free(run->seats);
+    free(run->delta);
+    for (int k = 0; k < run->pools; k++)
+        free(run->changes[k].students);
+    free(run->moved.students);
+    free(run);
+}
+
+// Seat a student's best option stands for, or PROGRAM_NOT_ALLOCATED
+static int bestProgram(const SeatPoolRun* run, StudentId s, int* pool) {
+    int32_t option = run->best[s];
+    *pool = 0;
+    if (option == NO_OPTION) return PROGRAM_NOT_ALLOCATED;
+    *pool = option % run->pools;
+    return STUDENT_PREFS(run->q, s)[option / run->pools];
+}
+
+// Allocates every queued student across the seat pools and leaves the seats
+// left in poolSeats and programSeats. The pool state is kept in the queue's
+// AllocationState for later edits. Returns the number of passes needed.
+int allocateSeatPools(Queue* q) {
+    StudentStore* store = &q->students;
+    releaseSeatPools(q->allocation->pools);
+    SeatPoolRun* run = buildPoolRun(q);
+    q->allocation->pools = run;
+    int passes = settlePools(run, INT32_MAX);
+    run->moved.count = 0;
+
+    // Write back the results and the seats they leave
+    memcpy(poolSeats, poolCapacity, (size_t)run->pools * programCount * sizeof(int));
+    for (StudentId s = q->front; s != NO_STUDENT; s = store->next[s]) {
+        int pool = 0;
+        int program_id = (store->flags[s] & STUDENT_VERIFIED) ? bestProgram(run, s, &pool)
+                                                              : PROGRAM_NOT_ELIGIBLE;
+        store->allocated_program[s] = program_id;
+        store->allocated_pool[s] = (uint8_t)pool;
+        if (program_id >= 0)
+            poolSeats[(size_t)pool * programCount + program_id]--;
+    }
+    for (int p = 0; p < programCount; p++) {
+        programSeats[p] = 0;
+        for (int k = 0; k < run->pools; k++)
+            programSeats[p] += poolSeats[(size_t)k * programCount + p];
+    }
+    return passes;
+}
+
+// Re-settles the pools after the preferences of one queued student changed,
+// starting from the previous outcome. Outcomes that move are applied to the
+// seat counts and logged. Returns the number of pool entries re-evaluated,
+// or -1 if there is no pooled allocation to update.
+int reallocateSeatPools(Queue* q, StudentId changed) {
+    SeatPoolRun* run = q->allocation->pools;
+    StudentStore* store = &q->students;
+    if (run == NULL || changed >= run->students)
+        return -1;
+    if (!(store->flags[changed] & STUDENT_VERIFIED))
+        return 0;
+
+    // The student's old results point into the old list: start over for
+    // them in every pool they belong to, and nowhere else
+    for (int k = 0; k < run->pools; k++) {
+        run->evaluated[k] = 0;
+        run->restart[k] = poolMemberCount(run, k);
+        run->lastChange[k] = -1;
+        if (store->categories[changed] & (1u << k)) {
+            run->restart[k] = memberPosition(run, k, store->rank[changed]);
+            run->lastChange[k] = run->restart[k];
+        }
+    }
+    run->best[changed] = NO_OPTION;
+    run->recheck = changed;
+    run->moved.count = 0;
+    noteChange(&run->moved, changed);
+
+    // Settling from a previous outcome has no pass bound; redo in full if slow
+    if (settlePools(run, POOL_UPDATE_MAX_PASSES) < 0) {
+        allocateSeatPools(q);
+        for (StudentId s = q->front; s != NO_STUDENT; s = store->next[s])
+            logAllocation(q, s);
+        buildCutoffs(q);
+        return store->live;
+    }
+
+    long evaluated = 0;
+    for (int k = 0; k < run->pools; k++) evaluated += run->evaluated[k];
+
+    // allocated_program still names the seat held before the edit
+    for (int i = 0; i < run->moved.count; i++) {
+        StudentId s = run->moved.students[i];
+        int pool;
+        int program_id = bestProgram(run, s, &pool);
+        int previous = store->allocated_program[s];
+        if (program_id == previous && pool == store->allocated_pool[s])
+            continue;  // Listed twice, or back where it started
+
+        if (previous >= 0) {
+            poolSeats[(size_t)store->allocated_pool[s] * programCount + previous]++;
+            programSeats[previous]++;
+        }
+        if (program_id >= 0) {
+            poolSeats[(size_t)pool * programCount + program_id]--;
+            programSeats[program_id]--;
+        }
+        noteCutoffMove(q, store->rank[s], previous, store->allocated_pool[s], program_id, pool);
+        store->allocated_program[s] = program_id;
+        store->allocated_pool[s] = (uint8_t)pool;
+        logAllocation(q, s);
+    }
+    run->moved.count = 0;
+    applyCutoffMoves(q);
+    return (int)evaluated;
+}
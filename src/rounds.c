@@ -0,0 +1,503 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "enhanced_ds.h"
+
+// ==========================================================
+//   MULTI-ROUND COUNSELLING
+//
+//   Round 1 is the ordinary allocation. Once a response is
+//   recorded or the next round is run, its results become the
+//   round 1 snapshot and the queue switches to round mode:
+//     - an exit hands the seat back, an accept freezes the
+//       student, everyone else floats
+//     - a round only moves students into free seats, so a held
+//       seat is never taken away (upgrade-only)
+//     - each program keeps a rank-ordered interest list, and a
+//       round repeatedly moves the best-ranked student who can
+//       use a free seat, so only students near freed seats are
+//       ever looked at. Programs with free seats sit in a heap
+//       keyed by the rank at the head of their list.
+// ==========================================================
+
+static void* growArray(void* data, int* capacity, size_t itemSize) {
+    *capacity = *capacity ? *capacity * 2 : 16;
+    return realloc(data, (size_t)*capacity * itemSize);
+}
+
+// Position of the held program in the preference list; num_preferences if
+// the student holds nothing or holds a program no longer listed
+static int heldPreferenceIndex(const Queue* q, StudentId s) {
+    const StudentStore* store = &q->students;
+    int count = store->num_preferences[s];
+    int held = store->allocated_program[s];
+    if (held >= 0) {
+        const uint16_t* prefs = STUDENT_PREFS(q, s);
+        for (int i = 0; i < count; i++)
+            if (prefs[i] == held)
+                return i;
+    }
+    return count;
+}
+
+// True if a free seat in program would be an improvement for s. Once false
+// it stays false for the same preference list: students only move up,
+// accept or exit.
+static bool canMoveInto(const Queue* q, StudentId s, int program_id) {
+    const StudentStore* store = &q->students;
+    if (store->round_status[s] != ROUND_FLOAT || !(store->flags[s] & STUDENT_VERIFIED))
+        return false;
+    const uint16_t* prefs = STUDENT_PREFS(q, s);
+    int held = heldPreferenceIndex(q, s);
+    for (int i = 0; i < held; i++)
+        if (prefs[i] == program_id)
+            return true;
+    return false;
+}
+
+static void appendInterest(InterestList* list, StudentId s) {
+    if (list->count == list->capacity)
+        list->students = growArray(list->students, &list->capacity, sizeof(StudentId));
+    list->students[list->count++] = s;
+}
+
+static void recordChange(RoundSnapshot* snap, StudentId s, int from, int to) {
+    if (snap->change_count == snap->change_capacity)
+        snap->changes = growArray(snap->changes, &snap->change_capacity, sizeof(RoundChange));
+    RoundChange* change = &snap->changes[snap->change_count++];
+    change->student = s;
+    change->from_program = from;
+    change->to_program = to;
+}
+
+static RoundSnapshot* beginSnapshot(RoundState* state) {
+    if (state->round_count == state->round_capacity)
+        state->rounds = growArray(state->rounds, &state->round_capacity, sizeof(RoundSnapshot));
+    RoundSnapshot* snap = &state->rounds[state->round_count++];
+    memset(snap, 0, sizeof(RoundSnapshot));
+    snap->number = state->round_count;
+    snap->seats = (int*)malloc(programCount * sizeof(int));
+    return snap;
+}
+
+// Min-heap of open programs. An entry packs (head rank, program id). A
+// program has one live entry, recorded in heap_rank; pushing a new key
+// leaves the old entry behind, and it is dropped when it reaches the top.
+static void heapPush(RoundState* state, int rank, int program_id) {
+    if (state->heap_rank[program_id] == rank) return;  // Already queued
+    state->heap_rank[program_id] = rank;
+    if (state->heap_count == state->heap_capacity)
+        state->heap = growArray(state->heap, &state->heap_capacity, sizeof(int64_t));
+    int64_t key = ((int64_t)rank << 16) | program_id;
+    int i = state->heap_count++;
+    while (i > 0 && state->heap[(i - 1) / 2] > key) {
+        state->heap[i] = state->heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    state->heap[i] = key;
+}
+
+static int64_t heapPop(RoundState* state) {
+    int64_t top = state->heap[0];
+    int64_t last = state->heap[--state->heap_count];
+    int i = 0;
+    while (1) {
+        int child = 2 * i + 1;
+        if (child >= state->heap_count) break;
+        if (child + 1 < state->heap_count && state->heap[child + 1] < state->heap[child])
+            child++;
+        if (state->heap[child] >= last) break;
+        state->heap[i] = state->heap[child];
+        i = child;
+    }
+    if (state->heap_count > 0) state->heap[i] = last;
+    return top;
+}
+
+// Turns the current allocation into round 1 and builds the interest lists
+static RoundState* ensureRounds(Queue* q) {
+    if (q->rounds != NULL) return q->rounds;
+    if (seatPoolCount > 1) {
+        printf("%sError: Counselling rounds are not available with seat pools.%s\n",
+               COLOR_RED, COLOR_RESET);
+        return NULL;
+    }
+    if (q->allocation->valid && q->allocation->engine == ALLOCATION_DEFERRED) {
+        printf("%sError: Counselling rounds need the serial allotment, not deferred acceptance.%s\n",
+               COLOR_RED, COLOR_RESET);
+        return NULL;
+    }
+    if (!q->allocation->valid) {
+        printf("%sError: Run the seat allotment before starting counselling rounds.%s\n",
+               COLOR_RED, COLOR_RESET);
+        return NULL;
+    }
+
+    RoundState* state = (RoundState*)calloc(1, sizeof(RoundState));
+    state->interest = (InterestList*)calloc(programCount, sizeof(InterestList));
+    state->heap_rank = (int*)malloc(programCount * sizeof(int));
+    RoundSnapshot* first = beginSnapshot(state);
+    StudentStore* store = &q->students;
+    for (StudentId s = q->front; s != NO_STUDENT; s = store->next[s]) {
+        const uint16_t* prefs = STUDENT_PREFS(q, s);
+        for (int i = 0; i < store->num_preferences[s]; i++)
+            appendInterest(&state->interest[prefs[i]], s);
+        if (store->allocated_program[s] >= 0) {
+            recordChange(first, s, PROGRAM_NOT_ALLOCATED, store->allocated_program[s]);
+            first->placed++;
+        }
+        first->touched++;
+    }
+    memcpy(first->seats, programSeats, programCount * sizeof(int));
+    first->seconds = q->allocation->seconds;
+
+    // Checkpoints describe round 1 only; later changes wait for a round
+    q->allocation->valid = false;
+    q->rounds = state;
+    return state;
+}
+
+const char* roundResponseName(RoundResponse response) {
+    switch (response) {
+        case ROUND_ACCEPT: return "Accepted";
+        case ROUND_EXIT:   return "Exited";
+        default:           return "Floating";
+    }
+}
+
+// Responses are final: a student who accepted or exited cannot respond again.
+// Returns false if the response cannot be recorded.
+bool recordRoundResponse(Queue* q, StudentId student, RoundResponse response) {
+    RoundState* state = ensureRounds(q);
+    StudentStore* store = &q->students;
+    if (state == NULL || store->round_status[student] != ROUND_FLOAT)
+        return false;
+    if (response == ROUND_FLOAT)
+        return true;
+    if (response == ROUND_ACCEPT && store->allocated_program[student] < 0)
+        return false;
+
+    store->round_status[student] = (uint8_t)response;
+    if (state->response_count == state->response_capacity)
+        state->responses = growArray(state->responses, &state->response_capacity,
+                                     sizeof(PendingResponse));
+    state->responses[state->response_count].student = student;
+    state->responses[state->response_count].response = response;
+    state->response_count++;
+    return true;
+}
+
+// Called for students enqueued or edited while rounds are running; they join
+// the interest lists at the start of the next round
+void noteRoundChange(Queue* q, StudentId student) {
+    RoundState* state = q->rounds;
+    if (state == NULL) return;
+    if (state->changed_count == state->changed_capacity)
+        state->changed = growArray(state->changed, &state->changed_capacity, sizeof(StudentId));
+    state->changed[state->changed_count++] = student;
+}
+
+static int compareKeys(const void* a, const void* b) {
+    int64_t x = *(const int64_t*)a;
+    int64_t y = *(const int64_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Sorts ids by rank through packed (rank, id) keys
+static void sortByRank(const StudentStore* store, StudentId* ids, int count) {
+    int64_t* keys = (int64_t*)malloc(count * sizeof(int64_t));
+    for (int i = 0; i < count; i++)
+        keys[i] = ((int64_t)store->rank[ids[i]] << 32) | (uint32_t)ids[i];
+    qsort(keys, count, sizeof(int64_t), compareKeys);
+    for (int i = 0; i < count; i++)
+        ids[i] = (StudentId)(keys[i] & 0xFFFFFFFF);
+    free(keys);
+}
+
+// Merges the changed students into every interest list they now belong to.
+// Stale entries left by an edit fail canMoveInto and are skipped.
+static void mergeChanged(Queue* q, RoundState* state) {
+    if (state->changed_count == 0) return;
+    const StudentStore* store = &q->students;
+    sortByRank(store, state->changed, state->changed_count);
+
+    // Bucket the changed students by program, keeping rank order
+    int* bucketStart = (int*)calloc(programCount + 1, sizeof(int));
+    int total = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        int* fill = (pass == 0) ? bucketStart : (int*)calloc(programCount, sizeof(int));
+        for (int i = 0; i < state->changed_count; i++) {
+            StudentId s = state->changed[i];
+            if (i > 0 && s == state->changed[i - 1]) continue;
+            const uint16_t* prefs = STUDENT_PREFS(q, s);
+            for (int j = 0; j < store->num_preferences[s]; j++) {
+                int p = prefs[j];
+                bool repeated = false;
+                for (int k = 0; k < j && !repeated; k++) repeated = (prefs[k] == p);
+                if (repeated) continue;
+                if (pass == 0) fill[p + 1]++;
+                else state->changed[state->changed_count + bucketStart[p] + fill[p]++] = s;
+            }
+        }
+        if (pass == 0) {
+            for (int p = 0; p < programCount; p++) bucketStart[p + 1] += bucketStart[p];
+            total = bucketStart[programCount];
+            while (state->changed_capacity < state->changed_count + total)
+                state->changed = growArray(state->changed, &state->changed_capacity, sizeof(StudentId));
+        } else {
+            free(fill);
+        }
+    }
+
+    StudentId* buckets = state->changed + state->changed_count;
+    for (int p = 0; p < programCount; p++) {
+        int k = bucketStart[p + 1] - bucketStart[p];
+        if (k == 0) continue;
+        StudentId* incoming = buckets + bucketStart[p];
+
+        // Merge from the back so the list is never copied aside
+        InterestList* list = &state->interest[p];
+        while (list->capacity < list->count + k)
+            list->students = growArray(list->students, &list->capacity, sizeof(StudentId));
+        int i = list->count - 1, j = k - 1, w = list->count + k - 1;
+        while (j >= 0) {
+            if (i >= 0 && store->rank[list->students[i]] > store->rank[incoming[j]])
+                list->students[w--] = list->students[i--];
+            else
+                list->students[w--] = incoming[j--];
+        }
+        list->count += k;
+        if (w + 1 < list->cursor) list->cursor = w + 1;
+    }
+    free(bucketStart);
+    state->changed_count = 0;
+}
+
+// Best-ranked student who could use a seat in this program, or NO_STUDENT
+static StudentId interestHead(const Queue* q, InterestList* list, int program_id) {
+    while (list->cursor < list->count &&
+           !canMoveInto(q, list->students[list->cursor], program_id))
+        list->cursor++;
+    return list->cursor < list->count ? list->students[list->cursor] : NO_STUDENT;
+}
+
+static void openProgram(Queue* q, RoundState* state, int program_id) {
+    if (programSeats[program_id] <= 0) return;
+    StudentId head = interestHead(q, &state->interest[program_id], program_id);
+    if (head != NO_STUDENT) heapPush(state, q->students.rank[head], program_id);
+}
+
+const RoundSnapshot* runNextRound(Queue* q) {
+    RoundState* state = ensureRounds(q);
+    if (state == NULL) return NULL;
+
+    double t0 = monotonicSeconds();
+    StudentStore* store = &q->students;
+    RoundSnapshot* snap = beginSnapshot(state);
+    opLogAppend(q->operation_log, OP_ROUND_STARTED, snap->number, PROGRAM_NOT_ALLOCATED);
+
+    // Seats given up since the last round go back into the pool
+    for (int i = 0; i < state->response_count; i++) {
+        StudentId s = state->responses[i].student;
+        if (state->responses[i].response == ROUND_ACCEPT) {
+            snap->accepts++;
+            continue;
+        }
+        int held = store->allocated_program[s];
+        if (held >= 0) {
+            programSeats[held]++;
+            recordChange(snap, s, held, PROGRAM_NOT_ALLOCATED);
+            noteCutoffMove(q, store->rank[s], held, 0, PROGRAM_NOT_ALLOCATED, 0);
+        }
+        store->allocated_program[s] = PROGRAM_NOT_ALLOCATED;
+        opLogAppend(q->operation_log, OP_WITHDRAWN, store->rank[s], PROGRAM_NOT_ALLOCATED);
+        snap->exits++;
+    }
+    state->response_count = 0;
+    applyCutoffMoves(q);
+    mergeChanged(q, state);
+
+    state->heap_count = 0;
+    for (int p = 0; p < programCount; p++) {
+        state->heap_rank[p] = -1;
+        openProgram(q, state, p);
+    }
+
+    // Move the best-ranked student who can use any free seat, until no free
+    // seat is wanted. Each move frees the student's old seat, which may
+    // pull in someone ranked better or worse.
+    while (state->heap_count > 0) {
+        int64_t top = heapPop(state);
+        int rank = (int)(top >> 16);
+        int p = (int)(top & 0xFFFF);
+        if (state->heap_rank[p] != rank) continue;  // Superseded entry
+        state->heap_rank[p] = -1;
+        if (programSeats[p] <= 0) continue;
+        StudentId next = interestHead(q, &state->interest[p], p);
+        if (next == NO_STUDENT) continue;
+        if (store->rank[next] != rank) {
+            heapPush(state, store->rank[next], p);
+            continue;
+        }
+
+        const uint16_t* prefs = STUDENT_PREFS(q, next);
+        int held = heldPreferenceIndex(q, next);
+        int previous = store->allocated_program[next];
+        snap->touched++;
+        for (int i = 0; i < held; i++) {
+            int program_id = prefs[i];
+            if (programSeats[program_id] > 0) {
+                programSeats[program_id]--;
+                if (previous >= 0) programSeats[previous]++;
+                store->allocated_program[next] = program_id;
+                recordChange(snap, next, previous, program_id);
+                noteCutoffMove(q, rank, previous, 0, program_id, 0);
+                applyCutoffMoves(q);
+                opLogAppend(q->operation_log, OP_ALLOCATE, rank, program_id);
+                if (previous >= 0) snap->upgrades++;
+                else snap->placed++;
+                break;
+            }
+        }
+        openProgram(q, state, p);
+        if (previous >= 0) openProgram(q, state, previous);
+    }
+
+    memcpy(snap->seats, programSeats, programCount * sizeof(int));
+    snap->seconds = monotonicSeconds() - t0;
+    return snap;
+}
+
+// Drops all round state; the next allocation starts a fresh round 1
+void discardRounds(Queue* q) {
+    RoundState* state = q->rounds;
+    if (state == NULL) return;
+
+    StudentStore* store = &q->students;
+    for (StudentId s = q->front; s != NO_STUDENT; s = store->next[s])
+        store->round_status[s] = ROUND_FLOAT;
+    for (int i = 0; i < state->round_count; i++) {
+        free(state->rounds[i].changes);
+        free(state->rounds[i].seats);
+    }
+    for (int p = 0; p < programCount; p++)
+        free(state->interest[p].students);
+    free(state->interest);
+    free(state->heap);
+    free(state->heap_rank);
+    free(state->rounds);
+    free(state->responses);
+    free(state->changed);
+    free(state);
+    q->rounds = NULL;
+}
+
+void displayRoundSummary(Queue* q) {
+    RoundState* state = q->rounds;
+    if (state == NULL) {
+        printf("\n%sNo counselling rounds yet: only round 1 (the seat allotment) exists.%s\n",
+               COLOR_YELLOW, COLOR_RESET);
+        return;
+    }
+
+    printf("\n%sCounselling Rounds%s\n", COLOR_BLUE, COLOR_RESET);
+    printf("==================\n");
+    printf("%-6s %10s %10s %8s %9s %7s %8s %11s\n",
+           "Round", "Time(ms)", "Touched", "Placed", "Upgrades", "Exits", "Accepts", "Seats left");
+    printf("--------------------------------------------------------------------------\n");
+    for (int i = 0; i < state->round_count; i++) {
+        RoundSnapshot* snap = &state->rounds[i];
+        int left = 0;
+        for (int p = 0; p < programCount; p++) left += snap->seats[p];
+        printf("%-6d %10.3f %10d %8d %9d %7d %8d %11d\n",
+               snap->number, snap->seconds * 1000.0, snap->touched, snap->placed,
+               snap->upgrades, snap->exits, snap->accepts, left);
+    }
+    if (state->response_count > 0)
+        printf("%d response(s) waiting for round %d\n",
+               state->response_count, state->round_count + 1);
+}
+
+static void recordResponseInteractive(Queue* q) {
+    char reg_number[MAX_REG_LENGTH];
+    printf("Enter Registration Number: ");
+    if (scanf("%9s", reg_number) != 1) return;
+    while (getchar() != '\n');
+
+    StudentStore* store = &q->students;
+    StudentId s = findStudentByReg(reg_number);
+    if (s == NO_STUDENT) {
+        printf("%sError: Student not found!%s\n", COLOR_RED, COLOR_RESET);
+        return;
+    }
+    printf("%s (rank %d): %s - %s, %s\n", STUDENT_NAME(store, s), store->rank[s],
+           programCollegeName(store->allocated_program[s]),
+           programBranchName(store->allocated_program[s]),
+           roundResponseName((RoundResponse)store->round_status[s]));
+    if (store->round_status[s] != ROUND_FLOAT) {
+        printf("%sThis student has already responded.%s\n", COLOR_YELLOW, COLOR_RESET);
+        return;
+    }
+
+    printf("Response - (A)ccept, (F)loat, (E)xit: ");
+    char choice;
+    if (scanf(" %c", &choice) != 1) return;
+    while (getchar() != '\n');
+
+    RoundResponse response;
+    switch (choice) {
+        case 'a': case 'A': response = ROUND_ACCEPT; break;
+        case 'f': case 'F': response = ROUND_FLOAT; break;
+        case 'e': case 'E': response = ROUND_EXIT; break;
+        default:
+            printf("%sInvalid response!%s\n", COLOR_RED, COLOR_RESET);
+            return;
+    }
+    if (!recordRoundResponse(q, s, response)) {
+        printf("%sError: Response not recorded (a student without a seat cannot accept).%s\n",
+               COLOR_RED, COLOR_RESET);
+        return;
+    }
+    printf("%sResponse recorded: %s%s\n", COLOR_GREEN, roundResponseName(response), COLOR_RESET);
+}
+
+void counsellingRoundsMenu(Queue* q) {
+    while (1) {
+        printf("\n%s=== Counselling Rounds ===%s\n", COLOR_YELLOW, COLOR_RESET);
+        if (q->rounds != NULL)
+            printf("Rounds completed: %d\n", q->rounds->round_count);
+        printf("1. Record Student Response\n");
+        printf("2. Run Next Round\n");
+        printf("3. Show Round Summary\n");
+        printf("4. Back\n\n");
+        printf("Enter your choice: ");
+
+        int choice;
+        int scanResult = scanf("%d", &choice);
+        while (getchar() != '\n');
+        if (scanResult != 1) continue;
+
+        switch (choice) {
+            case 1:
+                recordResponseInteractive(q);
+                break;
+            case 2: {
+                const RoundSnapshot* snap = runNextRound(q);
+                if (snap != NULL) {
+                    printf("\n%sRound %d complete: %d placed, %d upgraded, %d student(s) touched in %.3f ms.%s\n",
+                           COLOR_GREEN, snap->number, snap->placed, snap->upgrades,
+                           snap->touched, snap->seconds * 1000.0, COLOR_RESET);
+                }
+                break;
+            }
+            case 3:
+                displayRoundSummary(q);
+                break;
+            case 4:
+                return;
+            default:
+                printf("\n%sInvalid choice! Please enter a number between 1 and 4.%s\n",
+                       COLOR_RED, COLOR_RESET);
+        }
+    }
+}
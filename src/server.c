@@ -0,0 +1,990 @@
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "enhanced_ds.h"
+
+// ==========================================================
+//   REGISTRATION SERVICE
+//
+//   Serves several counters at once over a Unix domain socket.
+//   Each request is one line and gets one reply line, "OK ..."
+//   or "ERR <reason>":
+//     REGISTER reg_number,name,rank,dob,aadhar,preferences[,pools]
+//     VERIFY   reg_number,dob,aadhar
+//     UPDATE   reg_number,dob,aadhar,preferences
+//     QUERY    reg_number
+//     ALLOCATE
+//     STATS
+//   Fields are comma or tab separated with the same rules as
+//   batch input. A connection may send requests back to back;
+//   replies come in the same order.
+//
+//   One event loop thread polls the listening socket and every
+//   connection, splits input into lines and hands each line to
+//   a pool of request threads; finished replies come back over
+//   a pipe. A connection has at most one request in flight,
+//   which is what keeps its replies in order.
+//
+//   Registrations claim their reg number, Aadhar number and
+//   rank in a set split into CLAIM_STRIPES independently
+//   locked stripes, so two counters registering the same
+//   person race on one stripe lock and exactly one wins, while
+//   unrelated registrations do not touch the same lock. The
+//   queue itself is behind a reader-writer lock: VERIFY and
+//   QUERY share it, and a registration or edit holds it only
+//   while applying a change that has already passed every
+//   check. Journal syncs happen after the lock is released, so
+//   concurrent changes share one group commit.
+// ==========================================================
+
+#define SERVER_MAX_CONNECTIONS 1024
+#define SERVER_MAX_REQUEST     (1 << 20)  // Longest request line accepted
+#define SERVER_READ_CHUNK      (16 << 10)
+#define SERVER_LATENCY_SAMPLES (1 << 16)  // Latest samples kept per request type
+#define SERVER_FIELD_COUNT     6          // REGISTER fields before the optional pools
+#define CLAIM_STRIPES          64
+
+// Claim keys are the packed identifiers tagged by kind
+#define CLAIM_REG    (1ULL << 60)
+#define CLAIM_AADHAR (2ULL << 60)
+#define CLAIM_RANK   (3ULL << 60)
+
+typedef enum {
+    REQUEST_REGISTER = 0,
+    REQUEST_VERIFY,
+    REQUEST_UPDATE,
+    REQUEST_QUERY,
+    REQUEST_ALLOCATE,
+    REQUEST_STATS,
+    REQUEST_TYPES,
+    REQUEST_UNKNOWN = REQUEST_TYPES
+} RequestType;
+
+static const char* requestNames[REQUEST_TYPES] = {
+    "REGISTER", "VERIFY", "UPDATE", "QUERY", "ALLOCATE", "STATS"
+};
+
+typedef struct {
+    char* data;
+    size_t used;
+    size_t capacity;
+} TextBuffer;
+
+typedef struct Connection {
+    int fd;
+    TextBuffer in;          // Received bytes not answered yet
+    TextBuffer out;         // Replies, sent up to out_sent
+    size_t out_sent;
+    TextBuffer reply;       // Written by a request thread while busy
+    char* request;          // Line being answered, at the start of in
+    size_t request_bytes;   // Bytes of in it takes, newline included
+    double started;
+    bool busy;              // A request thread owns request and reply
+    bool eof;               // Peer sent everything it will send
+    bool dead;              // Peer gone or unwritable; dropped once idle
+    struct Connection* next;  // Job queue or done list
+} Connection;
+
+// Open-addressing set of claimed keys; 0 marks an empty slot
+typedef struct {
+    pthread_mutex_t lock;
+    uint64_t* keys;
+    int capacity;  // Power of two
+    int count;
+} ClaimStripe;
+
+typedef struct {
+    double* samples;  // Ring of SERVER_LATENCY_SAMPLES seconds
+    long count;       // Requests answered
+    long refused;     // Of which answered with ERR
+} LatencyLog;
+
+struct Server {
+    Queue* q;
+    char path[sizeof(((struct sockaddr_un*)0)->sun_path)];
+    int listen_fd;
+    int wake[2];                    // Request threads -> event loop
+    pthread_rwlock_t state;         // Queue and verification store
+    ClaimStripe claims[CLAIM_STRIPES];
+    Connection* connections[SERVER_MAX_CONNECTIONS];
+    int connection_count;
+    long accepted;                  // Under stats_lock
+    pthread_mutex_t lock;           // Jobs, done, stopping
+    pthread_cond_t work;
+    Connection* jobs;
+    Connection* jobs_tail;
+    Connection* done;
+    bool stopping;
+    pthread_t loop;
+    bool loop_started;
+    pthread_t* threads;
+    int thread_count;
+    pthread_mutex_t stats_lock;
+    LatencyLog latency[REQUEST_TYPES];
+};
+
+
+// ==========================================================
+//   BUFFERS
+// ==========================================================
+static void bufferReserve(TextBuffer* b, size_t extra) {
+    if (b->used + extra <= b->capacity) return;
+    size_t capacity = b->capacity ? b->capacity * 2 : 256;
+    while (capacity < b->used + extra) capacity *= 2;
+    b->data = (char*)realloc(b->data, capacity);
+    b->capacity = capacity;
+}
+
+static void bufferAppend(TextBuffer* b, const char* data, size_t len) {
+    bufferReserve(b, len);
+    memcpy(b->data + b->used, data, len);
+    b->used += len;
+}
+
+static void bufferPrintf(TextBuffer* b, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+
+    bufferReserve(b, (size_t)len + 1);
+    va_start(args, format);
+    vsnprintf(b->data + b->used, (size_t)len + 1, format, args);
+    va_end(args);
+    b->used += len;
+}
+
+
+// ==========================================================
+//   STRIPED CLAIM SET
+// ==========================================================
+static uint64_t claimHash(uint64_t key) {
+    return key * 0x9E3779B97F4A7C15ULL;
+}
+
+static ClaimStripe* claimStripe(Server* s, uint64_t hash) {
+    return &s->claims[hash >> 58];  // Top 6 bits pick one of 64 stripes
+}
+
+// Called with the stripe lock held
+static bool stripeInsert(ClaimStripe* stripe, uint64_t key, uint64_t hash) {
+    if ((stripe->count + 1) * 10 > stripe->capacity * 7) {
+        int capacity = stripe->capacity ? stripe->capacity * 2 : 64;
+        uint64_t* keys = (uint64_t*)calloc(capacity, sizeof(uint64_t));
+        for (int i = 0; i < stripe->capacity; i++) {
+            uint64_t k = stripe->keys[i];
+            if (k == 0) continue;
+            uint32_t j = (uint32_t)(claimHash(k) >> 26) & (uint32_t)(capacity - 1);
+            while (keys[j] != 0) j = (j + 1) & (uint32_t)(capacity - 1);
+            keys[j] = k;
+        }
+        free(stripe->keys);
+        stripe->keys = keys;
+        stripe->capacity = capacity;
+    }
+
+    uint32_t mask = (uint32_t)stripe->capacity - 1;
+    for (uint32_t i = (uint32_t)(hash >> 26) & mask; ; i = (i + 1) & mask) {
+        if (stripe->keys[i] == key) return false;
+        if (stripe->keys[i] == 0) {
+            stripe->keys[i] = key;
+            stripe->count++;
+            return true;
+        }
+    }
+}
+
+// Takes key for the caller; false if someone already holds it
+static bool claimKey(Server* s, uint64_t key) {
+    uint64_t hash = claimHash(key);
+    ClaimStripe* stripe = claimStripe(s, hash);
+    pthread_mutex_lock(&stripe->lock);
+    bool claimed = stripeInsert(stripe, key, hash);
+    pthread_mutex_unlock(&stripe->lock);
+    return claimed;
+}
+
+// Gives back a claim of a registration that did not go through. Later
+// keys of the probe run are shifted back so lookups never stop early.
+static void releaseClaim(Server* s, uint64_t key) {
+    uint64_t hash = claimHash(key);
+    ClaimStripe* stripe = claimStripe(s, hash);
+    pthread_mutex_lock(&stripe->lock);
+
+    uint32_t mask = (uint32_t)stripe->capacity - 1;
+    uint32_t hole = (uint32_t)(hash >> 26) & mask;
+    while (stripe->keys[hole] != key) {
+        if (stripe->keys[hole] == 0) {
+            pthread_mutex_unlock(&stripe->lock);
+            return;
+        }
+        hole = (hole + 1) & mask;
+    }
+    for (uint32_t i = (hole + 1) & mask; stripe->keys[i] != 0; i = (i + 1) & mask) {
+        uint32_t home = (uint32_t)(claimHash(stripe->keys[i]) >> 26) & mask;
+        // Move the key into the hole unless its home lies in (hole, i]
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            stripe->keys[hole] = stripe->keys[i];
+            hole = i;
+        }
+    }
+    stripe->keys[hole] = 0;
+    stripe->count--;
+    pthread_mutex_unlock(&stripe->lock);
+}
+
+// Everything already registered is claimed before the first request
+static void seedClaims(Server* s) {
+    for (int i = 0; i < verificationDataCount; i++) {
+        claimKey(s, CLAIM_REG | packRegNumber(verificationData[i].reg_number));
+        claimKey(s, CLAIM_AADHAR | packAadhar(verificationData[i].aadhar));
+    }
+    const StudentStore* store = &s->q->students;
+    for (StudentId st = s->q->front; st != NO_STUDENT; st = store->next[st]) {
+        claimKey(s, CLAIM_REG | packRegNumber(store->reg_number[st]));
+        claimKey(s, CLAIM_RANK | (uint64_t)(uint32_t)store->rank[st]);
+    }
+}
+
+
+// ==========================================================
+//   REQUESTS
+// ==========================================================
+// Acknowledges a change once its journal record is on disk
+static void replyJournaled(Server* s, TextBuffer* reply, uint64_t sequence, const char* text) {
+    Journal* journal = s->q->journal;
+    if (journal != NULL && !journalSync(journal, sequence))
+        bufferPrintf(reply, "OK %s (journal write failed, kept in memory only)\n", text);
+    else
+        bufferPrintf(reply, "OK %s\n", text);
+}
+
+static void appendPreferences(TextBuffer* reply, const uint16_t* ids, int count) {
+    for (int i = 0; i < count; i++)
+        bufferPrintf(reply, "%s%d", i > 0 ? ";" : "", ids[i] + 1);
+}
+
+// Each handler writes its reply, or returns why the request was refused
+static const char* handleRegister(Server* s, char* args, char delim, TextBuffer* reply, uint16_t* prefs) {
+    char* fields[SERVER_FIELD_COUNT + 2];
+    int count = splitFields(args, delim, fields, SERVER_FIELD_COUNT + 1);
+    if (count != SERVER_FIELD_COUNT && count != SERVER_FIELD_COUNT + 1)
+        return "expected 6 or 7 fields";
+    if (!isValidRegNumber(fields[0]))
+        return "invalid registration number";
+    if (fields[1][0] == '\0' || strlen(fields[1]) >= MAX_NAME_LENGTH)
+        return "invalid name";
+
+    int rank;
+    if (!parseRank(fields[2], &rank))
+        return "invalid rank";
+    if (!isValidDOB(fields[3]))
+        return "invalid date of birth";
+    if (!isValidAadhar(fields[4]))
+        return "invalid Aadhar number";
+
+    uint8_t categories = POOL_GENERAL;
+    if (count > SERVER_FIELD_COUNT && !parsePoolList(fields[SERVER_FIELD_COUNT], &categories))
+        return "unknown seat pool";
+    int prefCount;
+    const char* prefError = parsePreferences(fields[5], prefs, &prefCount);
+    if (prefError != NULL)
+        return prefError;
+
+    // Claimed in a fixed order; a refusal gives back what was taken
+    uint64_t keys[3] = {
+        CLAIM_REG | packRegNumber(fields[0]),
+        CLAIM_AADHAR | packAadhar(fields[4]),
+        CLAIM_RANK | (uint64_t)(uint32_t)rank
+    };
+    static const char* duplicates[3] = {
+        "duplicate registration number", "duplicate Aadhar number", "duplicate rank"
+    };
+    for (int i = 0; i < 3; i++) {
+        if (claimKey(s, keys[i])) continue;
+        for (int k = 0; k < i; k++) releaseClaim(s, keys[k]);
+        return duplicates[i];
+    }
+
+    Queue* q = s->q;
+    pthread_rwlock_wrlock(&s->state);
+    StudentId student = allocStudent(q);
+    StudentStore* store = &q->students;
+    setStudentPreferences(q, student, prefs, prefCount);
+    strcpy(store->reg_number[student], fields[0]);
+    setStudentName(q, student, fields[1]);
+    store->rank[student] = rank;
+    store->flags[student] = STUDENT_VERIFIED;
+    store->categories[student] = categories;
+    store->allocated_program[student] = PROGRAM_NOT_ALLOCATED;
+    store->next[student] = NO_STUDENT;
+    uint64_t sequence = 0;
+    if (q->journal != NULL)
+        sequence = journalRegistration(q->journal, q, student, fields[3], fields[4]);
+    bool added = addToVerificationData(fields[0], fields[1], fields[3], fields[4]);
+    if (added)
+        enqueue(q, student);
+    else
+        releaseStudent(q, student);
+    pthread_rwlock_unlock(&s->state);
+
+    if (!added) {
+        for (int k = 0; k < 3; k++) releaseClaim(s, keys[k]);
+        return "could not store the verification record";
+    }
+    char text[64];
+    snprintf(text, sizeof(text), "registered %s", fields[0]);
+    replyJournaled(s, reply, sequence, text);
+    return NULL;
+}
+
+static const char* verifyFailure(VerifyResult result) {
+    switch (result) {
+        case VERIFY_UNKNOWN_REG:     return "unknown registration number";
+        case VERIFY_DOB_MISMATCH:    return "date of birth does not match";
+        case VERIFY_AADHAR_MISMATCH: return "Aadhar number does not match";
+        default:                     return NULL;
+    }
+}
+
+static const char* handleVerify(Server* s, char* args, char delim, TextBuffer* reply) {
+    char* fields[4];
+    if (splitFields(args, delim, fields, 3) != 3)
+        return "expected reg_number, dob, aadhar";
+
+    pthread_rwlock_rdlock(&s->state);
+    VerifyResult result = checkVerificationClaim(fields[0], fields[1], fields[2]);
+    pthread_rwlock_unlock(&s->state);
+
+    if (result != VERIFY_OK)
+        return verifyFailure(result);
+    bufferPrintf(reply, "OK verified %s\n", fields[0]);
+    return NULL;
+}
+
+static const char* handleUpdate(Server* s, char* args, char delim, TextBuffer* reply, uint16_t* prefs) {
+    char* fields[5];
+    if (splitFields(args, delim, fields, 4) != 4)
+        return "expected reg_number, dob, aadhar, preferences";
+    int prefCount;
+    const char* prefError = parsePreferences(fields[3], prefs, &prefCount);
+    if (prefError != NULL)
+        return prefError;
+
+    Queue* q = s->q;
+    pthread_rwlock_wrlock(&s->state);
+    VerifyResult result = checkVerificationClaim(fields[0], fields[1], fields[2]);
+    StudentId student = (result == VERIFY_OK) ? findStudentByReg(fields[0]) : NO_STUDENT;
+    uint64_t sequence = 0;
+    int evaluated = -1;
+    if (student != NO_STUDENT) {
+        if (q->journal != NULL)
+            sequence = journalPreferences(q->journal, fields[0], prefs, prefCount);
+        setStudentPreferences(q, student, prefs, prefCount);
+        evaluated = commitPreferenceUpdate(q, student);
+    }
+    pthread_rwlock_unlock(&s->state);
+
+    if (result != VERIFY_OK)
+        return verifyFailure(result);
+    if (student == NO_STUDENT)
+        return "student is not in the queue";
+
+    char text[64];
+    if (evaluated >= 0)
+        snprintf(text, sizeof(text), "updated %s, %d student(s) re-evaluated", fields[0], evaluated);
+    else
+        snprintf(text, sizeof(text), "updated %s", fields[0]);
+    replyJournaled(s, reply, sequence, text);
+    return NULL;
+}
+
+// reg_number,"name",rank,college,branch[,pool],preferences; the seat
+// reads Pending while the queue has changed since the last allocation
+static const char* handleQuery(Server* s, char* args, TextBuffer* reply) {
+    char* reg_number = args;
+    if (!isValidRegNumber(reg_number))
+        return "invalid registration number";
+
+    Queue* q = s->q;
+    pthread_rwlock_rdlock(&s->state);
+    StudentId student = findStudentByReg(reg_number);
+    if (student != NO_STUDENT) {
+        const StudentStore* store = &q->students;
+        bool pending = !q->allocation->valid;
+        int program_id = pending ? PROGRAM_NOT_ALLOCATED : store->allocated_program[student];
+        const char* college = pending ? "Pending" : programCollegeName(program_id);
+        const char* quote = (strchr(college, ',') != NULL) ? "\"" : "";
+        bufferPrintf(reply, "OK %s,\"%s\",%d,%s%s%s,%s,", store->reg_number[student],
+                     STUDENT_NAME(store, student), store->rank[student],
+                     quote, college, quote, programBranchName(program_id));
+        if (seatPoolCount > 1)
+            bufferPrintf(reply, "%s,", program_id >= 0 ? seatPoolName(store->allocated_pool[student]) : "");
+        appendPreferences(reply, STUDENT_PREFS(q, student), store->num_preferences[student]);
+        bufferAppend(reply, "\n", 1);
+    }
+    pthread_rwlock_unlock(&s->state);
+
+    return (student == NO_STUDENT) ? "student is not in the queue" : NULL;
+}
+
+static void handleAllocate(Server* s, TextBuffer* reply) {
+    pthread_rwlock_wrlock(&s->state);
+    processAllocation(s->q);
+    int students = s->q->students.live;
+    double seconds = s->q->allocation->seconds;
+    pthread_rwlock_unlock(&s->state);
+    bufferPrintf(reply, "OK allocated %d students in %.1f ms\n", students, seconds * 1000.0);
+}
+
+static int compareDoubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Sorted copy of the latest samples of one request type; returns how many
+static int latencySamples(Server* s, RequestType type, double** out, long* count, long* refused) {
+    LatencyLog* log = &s->latency[type];
+    pthread_mutex_lock(&s->stats_lock);
+    *count = log->count;
+    *refused = log->refused;
+    int n = (log->count < SERVER_LATENCY_SAMPLES) ? (int)log->count : SERVER_LATENCY_SAMPLES;
+    *out = (double*)malloc((n > 0 ? n : 1) * sizeof(double));
+    memcpy(*out, log->samples, n * sizeof(double));
+    pthread_mutex_unlock(&s->stats_lock);
+
+    qsort(*out, n, sizeof(double), compareDoubles);
+    return n;
+}
+
+// Percentile of a sorted sample, in microseconds
+static double percentileUs(const double* sorted, int n, int percent) {
+    return (n > 0) ? sorted[(long)n * percent / 100] * 1e6 : 0.0;
+}
+
+static void handleStats(Server* s, TextBuffer* reply) {
+    pthread_rwlock_rdlock(&s->state);
+    int students = s->q->students.live;
+    pthread_rwlock_unlock(&s->state);
+
+    bufferPrintf(reply, "OK students=%d", students);
+    for (int t = 0; t < REQUEST_TYPES; t++) {
+        double* sorted;
+        long count, refused;
+        int n = latencySamples(s, (RequestType)t, &sorted, &count, &refused);
+        bufferPrintf(reply, " %s=%ld/%.0f/%.0f", requestNames[t], count,
+                     percentileUs(sorted, n, 50), percentileUs(sorted, n, 99));
+        free(sorted);
+    }
+    bufferAppend(reply, "\n", 1);
+}
+
+// Answers one request line into reply; returns its type
+static RequestType answerRequest(Server* s, char* line, TextBuffer* reply, uint16_t* prefs) {
+    char* args = line;
+    while (*args != '\0' && *args != ' ' && *args != '\t') args++;
+    if (*args != '\0') *args++ = '\0';
+    while (*args == ' ' || *args == '\t') args++;
+    char delim = (strchr(args, '\t') != NULL) ? '\t' : ',';
+
+    RequestType type = REQUEST_UNKNOWN;
+    for (int t = 0; t < REQUEST_TYPES; t++)
+        if (strcasecmp(line, requestNames[t]) == 0) type = (RequestType)t;
+
+    const char* error = NULL;
+    switch (type) {
+        case REQUEST_REGISTER: error = handleRegister(s, args, delim, reply, prefs); break;
+        case REQUEST_VERIFY:   error = handleVerify(s, args, delim, reply); break;
+        case REQUEST_UPDATE:   error = handleUpdate(s, args, delim, reply, prefs); break;
+        case REQUEST_QUERY:    error = handleQuery(s, args, reply); break;
+        case REQUEST_ALLOCATE: handleAllocate(s, reply); break;
+        case REQUEST_STATS:    handleStats(s, reply); break;
+        default:               error = "unknown request"; break;
+    }
+    if (error != NULL)
+        bufferPrintf(reply, "ERR %s\n", error);
+    return type;
+}
+
+static void recordLatency(Server* s, RequestType type, double seconds, bool refused) {
+    if (type == REQUEST_UNKNOWN) return;
+    LatencyLog* log = &s->latency[type];
+    pthread_mutex_lock(&s->stats_lock);
+    log->samples[log->count & (SERVER_LATENCY_SAMPLES - 1)] = seconds;
+    log->count++;
+    if (refused) log->refused++;
+    pthread_mutex_unlock(&s->stats_lock);
+}
+
+static void* requestMain(void* arg) {
+    Server* s = (Server*)arg;
+    uint16_t* prefs = (uint16_t*)malloc(MAX_PREFERENCES * sizeof(uint16_t));
+
+    pthread_mutex_lock(&s->lock);
+    while (1) {
+        while (s->jobs == NULL && !s->stopping)
+            pthread_cond_wait(&s->work, &s->lock);
+        if (s->stopping) break;
+        Connection* c = s->jobs;
+        s->jobs = c->next;
+        if (s->jobs == NULL) s->jobs_tail = NULL;
+        pthread_mutex_unlock(&s->lock);
+
+        RequestType type = answerRequest(s, c->request, &c->reply, prefs);
+        recordLatency(s, type, monotonicSeconds() - c->started, c->reply.data[0] == 'E');
+
+        pthread_mutex_lock(&s->lock);
+        c->next = s->done;
+        s->done = c;
+        char byte = 0;
+        if (write(s->wake[1], &byte, 1) < 0) {
+            // The pipe is full, so the loop is already due to wake up
+        }
+    }
+    pthread_mutex_unlock(&s->lock);
+    free(prefs);
+    return NULL;
+}
+
+
+// ==========================================================
+//   EVENT LOOP
+// ==========================================================
+static bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+static void closeConnection(Connection* c) {
+    close(c->fd);
+    free(c->in.data);
+    free(c->out.data);
+    free(c->reply.data);
+    free(c);
+}
+
+static void readConnection(Connection* c) {
+    bufferReserve(&c->in, SERVER_READ_CHUNK);
+    ssize_t got = read(c->fd, c->in.data + c->in.used, c->in.capacity - c->in.used);
+    if (got > 0)
+        c->in.used += (size_t)got;
+    else if (got == 0)
+        c->eof = true;
+    else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+        c->dead = true;
+}
+
+static void flushConnection(Connection* c) {
+    while (c->out_sent < c->out.used && !c->dead) {
+        ssize_t sent = write(c->fd, c->out.data + c->out_sent, c->out.used - c->out_sent);
+        if (sent > 0) {
+            c->out_sent += (size_t)sent;
+        } else if (sent < 0 && errno == EINTR) {
+            continue;
+        } else {
+            if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK) c->dead = true;
+            return;
+        }
+    }
+    c->out.used = c->out_sent = 0;
+}
+
+// Hands the next complete line of an idle connection to the request threads
+static void dispatchRequest(Server* s, Connection* c) {
+    while (!c->busy && !c->dead) {
+        char* newline = (char*)memchr(c->in.data, '\n', c->in.used);
+        if (newline == NULL) {
+            if (c->in.used > SERVER_MAX_REQUEST) {
+                bufferPrintf(&c->out, "ERR request too long\n");
+                c->in.used = 0;
+                c->eof = true;  // Nothing more is read from it
+            }
+            return;
+        }
+
+        size_t bytes = (size_t)(newline - c->in.data) + 1;
+        *newline = '\0';
+        if (newline > c->in.data && newline[-1] == '\r') newline[-1] = '\0';
+        char* line = c->in.data;
+        while (*line == ' ' || *line == '\t') line++;
+        if (*line == '\0') {
+            // Blank lines get no reply
+            memmove(c->in.data, c->in.data + bytes, c->in.used - bytes);
+            c->in.used -= bytes;
+            continue;
+        }
+
+        c->busy = true;
+        c->request = line;
+        c->request_bytes = bytes;
+        c->reply.used = 0;
+        c->started = monotonicSeconds();
+        c->next = NULL;
+        pthread_mutex_lock(&s->lock);
+        if (s->jobs_tail != NULL) s->jobs_tail->next = c;
+        else s->jobs = c;
+        s->jobs_tail = c;
+        pthread_cond_signal(&s->work);
+        pthread_mutex_unlock(&s->lock);
+    }
+}
+
+static void finishRequest(Connection* c) {
+    bufferAppend(&c->out, c->reply.data, c->reply.used);
+    memmove(c->in.data, c->in.data + c->request_bytes, c->in.used - c->request_bytes);
+    c->in.used -= c->request_bytes;
+    c->busy = false;
+}
+
+static bool connectionFinished(const Connection* c) {
+    if (c->busy) return false;
+    if (c->dead) return true;
+    return c->eof && c->out_sent == c->out.used && memchr(c->in.data, '\n', c->in.used) == NULL;
+}
+
+static void acceptConnections(Server* s) {
+    while (1) {
+        int fd = accept(s->listen_fd, NULL, NULL);
+        if (fd < 0) return;  // EAGAIN once the backlog is empty
+        if (s->connection_count == SERVER_MAX_CONNECTIONS || !setNonBlocking(fd)) {
+            close(fd);
+            continue;
+        }
+        Connection* c = (Connection*)calloc(1, sizeof(Connection));
+        c->fd = fd;
+        s->connections[s->connection_count++] = c;
+        pthread_mutex_lock(&s->stats_lock);
+        s->accepted++;
+        pthread_mutex_unlock(&s->stats_lock);
+    }
+}
+
+static void* eventLoop(void* arg) {
+    Server* s = (Server*)arg;
+    struct pollfd* fds = (struct pollfd*)malloc((SERVER_MAX_CONNECTIONS + 2) * sizeof(struct pollfd));
+
+    while (1) {
+        fds[0].fd = s->listen_fd;
+        fds[0].events = POLLIN;
+        fds[1].fd = s->wake[0];
+        fds[1].events = POLLIN;
+        int watched = s->connection_count;
+        for (int i = 0; i < watched; i++) {
+            Connection* c = s->connections[i];
+            bool unsent = (c->out_sent < c->out.used);
+            fds[i + 2].fd = c->dead ? -1 : c->fd;
+            fds[i + 2].events = (short)((!c->busy && !c->eof ? POLLIN : 0) | (unsent ? POLLOUT : 0));
+            fds[i + 2].revents = 0;
+        }
+        if (poll(fds, watched + 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        // Replies finished by the request threads
+        if (fds[1].revents & POLLIN) {
+            char drain[256];
+            while (read(s->wake[0], drain, sizeof(drain)) > 0) {}
+        }
+        pthread_mutex_lock(&s->lock);
+        Connection* done = s->done;
+        s->done = NULL;
+        bool stopping = s->stopping;
+        pthread_mutex_unlock(&s->lock);
+        if (stopping) break;
+        for (; done != NULL; done = done->next)
+            finishRequest(done);
+
+        for (int i = 0; i < watched; i++) {
+            Connection* c = s->connections[i];
+            short revents = fds[i + 2].revents;
+            if (revents & POLLIN) readConnection(c);
+            else if (revents & (POLLHUP | POLLERR)) c->dead = true;
+        }
+
+        // Dispatch, send and drop; removal swaps in the last connection
+        for (int i = s->connection_count - 1; i >= 0; i--) {
+            Connection* c = s->connections[i];
+            dispatchRequest(s, c);
+            flushConnection(c);
+            if (connectionFinished(c)) {
+                closeConnection(c);
+                s->connections[i] = s->connections[--s->connection_count];
+            }
+        }
+
+        if (fds[0].revents & POLLIN) acceptConnections(s);
+    }
+    free(fds);
+    return NULL;
+}
+
+
+// ==========================================================
+//   START / STOP
+// ==========================================================
+// Binds path, replacing a socket file nobody is listening on
+static int listenOn(const char* path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+        if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0) {
+            printf("%sError: Another service is already listening on %s%s\n",
+                   COLOR_RED, path, COLOR_RESET);
+            close(fd);
+            return -1;
+        }
+        unlink(path);
+        close(fd);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+    }
+
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(fd, SOMAXCONN) != 0 || !setNonBlocking(fd)) {
+        printf("%sError: Cannot listen on %s: %s%s\n", COLOR_RED, path, strerror(errno), COLOR_RESET);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Starts serving q on a Unix socket at socketPath with threads request
+// threads (0 = one per worker thread). The caller must not touch q again
+// until serverStop.
+Server* serverStart(Queue* q, const char* socketPath, int threads) {
+    if (strlen(socketPath) >= sizeof(((struct sockaddr_un*)0)->sun_path)) {
+        printf("%sError: Socket path %s is too long%s\n", COLOR_RED, socketPath, COLOR_RESET);
+        return NULL;
+    }
+
+    // A client that disconnects early must not take the process down
+    signal(SIGPIPE, SIG_IGN);
+    int listen_fd = listenOn(socketPath);
+    if (listen_fd < 0) return NULL;
+
+    Server* s = (Server*)calloc(1, sizeof(Server));
+    s->q = q;
+    strcpy(s->path, socketPath);
+    s->listen_fd = listen_fd;
+    if (pipe(s->wake) != 0 || !setNonBlocking(s->wake[0]) || !setNonBlocking(s->wake[1])) {
+        printf("%sError: Cannot create the wakeup pipe%s\n", COLOR_RED, COLOR_RESET);
+        close(listen_fd);
+        unlink(socketPath);
+        free(s);
+        return NULL;
+    }
+
+    pthread_rwlockattr_t attr;
+    pthread_rwlockattr_init(&attr);
+#ifdef __GLIBC__
+    // Registrations must not wait behind an endless stream of readers
+    pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+    pthread_rwlock_init(&s->state, &attr);
+    pthread_rwlockattr_destroy(&attr);
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->work, NULL);
+    pthread_mutex_init(&s->stats_lock, NULL);
+    for (int i = 0; i < CLAIM_STRIPES; i++)
+        pthread_mutex_init(&s->claims[i].lock, NULL);
+    for (int t = 0; t < REQUEST_TYPES; t++)
+        s->latency[t].samples = (double*)malloc(SERVER_LATENCY_SAMPLES * sizeof(double));
+
+    // Lookups build the verification indexes on first use; do that now,
+    // before readers share them
+    HashIndexImage reg, aadhar;
+    verificationIndexImages(&reg, &aadhar);
+    seedClaims(s);
+
+    if (threads <= 0) threads = workerThreadCount();
+    if (threads > MAX_WORKER_THREADS) threads = MAX_WORKER_THREADS;
+    s->threads = (pthread_t*)malloc(threads * sizeof(pthread_t));
+    for (int i = 0; i < threads; i++) {
+        if (pthread_create(&s->threads[s->thread_count], NULL, requestMain, s) != 0)
+            break;  // Serve with the threads we have
+        s->thread_count++;
+    }
+    s->loop_started = (s->thread_count > 0 && pthread_create(&s->loop, NULL, eventLoop, s) == 0);
+    if (!s->loop_started) {
+        printf("%sError: Cannot start the service threads%s\n", COLOR_RED, COLOR_RESET);
+        serverStop(s);
+        return NULL;
+    }
+    return s;
+}
+
+int serverThreadCount(Server* s) {
+    return s->thread_count;
+}
+
+void serverReport(Server* s) {
+    printf("\n%sRegistration Service%s\n", COLOR_BLUE, COLOR_RESET);
+    printf("====================\n");
+    pthread_mutex_lock(&s->stats_lock);
+    long accepted = s->accepted;
+    pthread_mutex_unlock(&s->stats_lock);
+    printf("Connections      : %ld\n", accepted);
+    printf("%-10s %10s %10s %10s %10s\n", "Request", "Answered", "Refused", "p50 us", "p99 us");
+    for (int t = 0; t < REQUEST_TYPES; t++) {
+        double* sorted;
+        long count, refused;
+        int n = latencySamples(s, (RequestType)t, &sorted, &count, &refused);
+        if (count > 0)
+            printf("%-10s %10ld %10ld %10.1f %10.1f\n", requestNames[t], count, refused,
+                   percentileUs(sorted, n, 50), percentileUs(sorted, n, 99));
+        free(sorted);
+    }
+}
+
+// Stops the threads and closes every connection. Requests still queued
+// get no reply; a change that was already applied stays applied.
+void serverStop(Server* s) {
+    if (s == NULL) return;
+    pthread_mutex_lock(&s->lock);
+    s->stopping = true;
+    pthread_cond_broadcast(&s->work);
+    pthread_mutex_unlock(&s->lock);
+    char byte = 0;
+    if (write(s->wake[1], &byte, 1) < 0) {
+        // Already due to wake up
+    }
+    if (s->loop_started) pthread_join(s->loop, NULL);
+    for (int i = 0; i < s->thread_count; i++)
+        pthread_join(s->threads[i], NULL);
+
+    for (int i = 0; i < s->connection_count; i++)
+        closeConnection(s->connections[i]);
+    close(s->listen_fd);
+    close(s->wake[0]);
+    close(s->wake[1]);
+    unlink(s->path);
+
+    for (int i = 0; i < CLAIM_STRIPES; i++) {
+        free(s->claims[i].keys);
+        pthread_mutex_destroy(&s->claims[i].lock);
+    }
+    for (int t = 0; t < REQUEST_TYPES; t++)
+        free(s->latency[t].samples);
+    pthread_rwlock_destroy(&s->state);
+    pthread_mutex_destroy(&s->lock);
+    pthread_cond_destroy(&s->work);
+    pthread_mutex_destroy(&s->stats_lock);
+    free(s->threads);
+    free(s);
+}
+
+
+// ==========================================================
+//   SERVE MODE
+// ==========================================================
+int runServeMode(const ServeOptions* options) {
+    // SIGINT and SIGTERM are taken by sigwait below; block them before any
+    // thread starts so none of them is killed by one
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+    setWorkerThreads(options->threads);
+    setAllocationEngine(options->engine);
+
+    // An existing snapshot brings its own catalog, seats and students
+    bool resume = (options->snapshotPath != NULL && access(options->snapshotPath, F_OK) == 0);
+    if (resume && options->catalogPath != NULL) {
+        printf("%sError: --catalog only applies to a new session, %s already has one%s\n",
+               COLOR_RED, options->snapshotPath, COLOR_RESET);
+        return 1;
+    }
+
+    Queue* q = NULL;
+    if (resume) {
+        q = loadSnapshot(options->snapshotPath);
+        if (q == NULL) return 1;
+    } else if (options->catalogPath != NULL) {
+        if (!loadCatalog(options->catalogPath)) return 1;
+        initializeColleges(0);
+    } else {
+        initializeColleges(options->seats);
+    }
+
+    MAX_PREFERENCES = (options->maxPreferences > 0) ? options->maxPreferences : programCount;
+    if (MAX_PREFERENCES > programCount) {
+        printf("%sError: --max-prefs must be between 1 and %d%s\n",
+               COLOR_RED, programCount, COLOR_RESET);
+        if (q != NULL) cleanupQueue(q);
+        return 1;
+    }
+
+    if (q == NULL) {
+        q = createQueue();
+        preregisterSeedStudents(q);
+    }
+    if (options->oplogPath != NULL && !opLogOpenFile(q->operation_log, options->oplogPath)) {
+        printf("%sWarning: Cannot open operation log %s, keeping it in memory only%s\n",
+               COLOR_YELLOW, options->oplogPath, COLOR_RESET);
+    }
+    if (options->journalPath != NULL) {
+        JournalRecovery recovery;
+        q->journal = journalOpen(q, options->journalPath, &recovery);
+        if (q->journal == NULL) {
+            cleanupQueue(q);
+            return 1;
+        }
+        printf("%sJournal %s replayed: %ld change(s) applied, %ld rejected, %ld torn byte(s) dropped%s\n",
+               COLOR_GREEN, options->journalPath, recovery.replayed, recovery.rejected,
+               recovery.torn_bytes, COLOR_RESET);
+    }
+
+    int students = q->students.live;
+    Server* server = serverStart(q, options->socketPath, 0);
+    if (server == NULL) {
+        cleanupQueue(q);
+        return 1;
+    }
+    printf("%sServing %d students on %s with %d request thread(s); Ctrl-C stops%s\n",
+           COLOR_GREEN, students, options->socketPath, serverThreadCount(server), COLOR_RESET);
+    fflush(stdout);
+
+    int received = 0;
+    sigwait(&signals, &received);
+    printf("\n%sStopping...%s\n", COLOR_YELLOW, COLOR_RESET);
+    serverReport(server);
+    serverStop(server);
+    int status = 0;
+    if (options->snapshotPath != NULL) {
+        uint64_t sequence = (q->journal != NULL) ? journalLastSequence(q->journal) : 0;
+        if (!saveSnapshot(q, options->snapshotPath)) {
+            status = 1;
+        } else {
+            printf("%sSnapshot saved to %s%s\n", COLOR_GREEN, options->snapshotPath, COLOR_RESET);
+            if (q->journal != NULL)
+                journalCheckpoint(q->journal, sequence);
+        }
+    }
+    cleanupQueue(q);
+    if (options->metricsPath != NULL && !writeMetricsJson(options->metricsPath)) {
+        printf("%sError: Cannot write metrics file %s%s\n", COLOR_RED, options->metricsPath, COLOR_RESET);
+        status = 1;
+    }
+    return status;
+}
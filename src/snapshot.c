@@ -0,0 +1,536 @@
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "enhanced_ds.h"
+
+// ==========================================================
+//   STATE SNAPSHOT
+//
+//   One file holds a whole session: the catalog and seat
+//   matrix, the verification store and its hash indexes, the
+//   student columns and preference runs, the rank buckets and
+//   bitmap and, for an up-to-date single-pool allotment, its
+//   checkpoints. Each array is a section at a 64-byte aligned
+//   offset from the start of the file, listed in the header.
+//   Nothing in the file is a pointer, so it can be mapped at
+//   any address.
+//
+//   Loading maps the file copy-on-write and points every array
+//   at its section. There is no parsing and no per-record
+//   allocation, and only the pages that are used get read.
+//   Writes go to private pages and never reach the file. An
+//   array moves out of the mapping, copied once, the first
+//   time it has to grow; freeing one that is still mapped does
+//   nothing.
+//
+//   Saving writes <path>.tmp, syncs it and renames it over
+//   <path>, so after a crash the file is either the old
+//   snapshot or the new one, never a mix. A session loaded
+//   from <path> can save back to it: the replaced file stays
+//   mapped until the process exits. The header also notes the
+//   last journal record the snapshot holds (journal.c), so a
+//   replay knows where to pick up.
+//
+//   Not kept: the counselling round history and seat pool runs
+//   (after rounds, or with seat pools, the seats reopen as they
+//   stand and the allotment has to be run again before edits)
+//   and the co-preference matrix. The AVL rank tree and the
+//   matrix are rebuilt from the queue the first time they are
+//   needed; until then the bitmap answers every rank in its
+//   range.
+// ==========================================================
+
+#define SNAPSHOT_ALIGN 64
+
+enum {
+    SECTION_COLLEGES,
+    SECTION_BRANCHES,
+    SECTION_PROGRAMS,
+    SECTION_PROGRAM_CAPACITY,
+    SECTION_PROGRAM_SEATS,
+    SECTION_POOL_CAPACITY,
+    SECTION_POOL_SEATS,
+    SECTION_VERIFICATION,
+    SECTION_REG_INDEX,
+    SECTION_AADHAR_INDEX,
+    SECTION_RANK,
+    SECTION_ALLOCATED_PROGRAM,
+    SECTION_PREF_OFFSET,
+    SECTION_NUM_PREFERENCES,
+    SECTION_FLAGS,
+    SECTION_ROUND_STATUS,
+    SECTION_CATEGORIES,
+    SECTION_ALLOCATED_POOL,
+    SECTION_NEXT,
+    SECTION_REG_NUMBER,
+    SECTION_NAME,
+    SECTION_NAMES,
+    SECTION_PREFERENCES,
+    SECTION_RANK_PAGE_INDEX,  // Page number per directory entry, -1 if none
+    SECTION_RANK_PAGES,
+    SECTION_RANK_BITMAP,
+    SECTION_CHECKPOINT_RANKS,
+    SECTION_CHECKPOINT_SEATS,
+    SECTION_COUNT
+};
+
+typedef struct {
+    uint64_t offset;  // From the start of the file
+    uint64_t length;  // Bytes
+} SnapshotSection;
+
+typedef struct {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t file_size;
+    // Record sizes, so a file written by a build with another layout is refused
+    uint32_t student_data_size;
+    uint32_t index_entry_size;
+    uint32_t college_size;
+    uint32_t rank_page_size;
+    // Catalog
+    int32_t college_count;
+    int32_t branch_count;
+    int32_t program_count;
+    int32_t seat_pool_count;
+    char seat_pool_names[MAX_SEAT_POOLS][POOL_NAME_LENGTH];
+    // Verification store
+    int32_t verification_count;
+    int32_t reg_index_capacity;
+    int32_t reg_index_count;
+    int32_t aadhar_index_capacity;
+    int32_t aadhar_index_count;
+    // Students and queue
+    int32_t student_count;
+    int32_t student_live;
+    int32_t free_list;
+    int32_t front;
+    uint64_t names_used;
+    uint64_t names_stale;
+    uint64_t preferences_used;
+    uint64_t preferences_stale;
+    int32_t rank_page_count;  // Length of the page directory
+    int32_t rank_pages;       // Pages present
+    int64_t bitmap_limit;
+    int32_t rank_count;
+    // Allotment
+    int32_t checkpoint_count;  // 0 unless the allotment is kept
+    double allocation_seconds;
+    uint64_t journal_sequence;  // Last journal record the snapshot holds
+    SnapshotSection sections[SECTION_COUNT];
+} SnapshotHeader;
+
+// The mapping of the loaded snapshot; one per process
+static char* mappedBase = NULL;
+static size_t mappedSize = 0;
+
+static bool isMapped(const void* array) {
+    return mappedBase != NULL && (const char*)array >= mappedBase &&
+           (const char*)array < mappedBase + mappedSize;
+}
+
+// realloc for arrays that may still live in the mapping: those are copied
+// out (used bytes) instead of being resized in place
+void* snapshotRealloc(void* array, size_t used, size_t size) {
+    if (!isMapped(array)) return realloc(array, size);
+    void* copy = malloc(size);
+    if (copy != NULL) memcpy(copy, array, used < size ? used : size);
+    return copy;
+}
+
+void snapshotFree(void* array) {
+    if (!isMapped(array)) free(array);
+}
+
+// Unmaps the loaded snapshot. The queue, catalog and verification store it
+// installed point into the mapping, so this is for a process done with all
+// of them.
+void releaseSnapshot(void) {
+    if (mappedBase == NULL) return;
+    munmap(mappedBase, mappedSize);
+    mappedBase = NULL;
+    mappedSize = 0;
+}
+
+
+// ==========================================================
+//                        SAVING
+// ==========================================================
+
+typedef struct {
+    FILE* file;
+    uint64_t offset;
+    SnapshotHeader* header;
+    bool failed;
+    int error;  // errno of the first failed write
+} SnapshotWriter;
+
+static void writeBytes(SnapshotWriter* w, const void* data, size_t length) {
+    if (length > 0 && fwrite(data, 1, length, w->file) != length && !w->failed) {
+        w->failed = true;
+        w->error = errno;
+    }
+    w->offset += length;
+}
+
+static void padSection(SnapshotWriter* w) {
+    static const char zeros[SNAPSHOT_ALIGN];
+    writeBytes(w, zeros, (SNAPSHOT_ALIGN - w->offset % SNAPSHOT_ALIGN) % SNAPSHOT_ALIGN);
+}
+
+// A section is opened, filled with one or more writeBytes calls and closed
+static void openSection(SnapshotWriter* w, int section) {
+    padSection(w);
+    w->header->sections[section].offset = w->offset;
+}
+
+static void closeSection(SnapshotWriter* w, int section) {
+    w->header->sections[section].length = w->offset - w->header->sections[section].offset;
+}
+
+static void writeSection(SnapshotWriter* w, int section, const void* data, size_t length) {
+    openSection(w, section);
+    writeBytes(w, data, length);
+    closeSection(w, section);
+}
+
+// Makes the rename itself durable; not every file system supports it
+static void syncParentDirectory(const char* path) {
+    const char* slash = strrchr(path, '/');
+    char* dir = (slash == NULL) ? strdup(".") : strndup(path, slash == path ? 1 : (size_t)(slash - path));
+    int fd = open(dir, O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+    free(dir);
+}
+
+static void fillHeader(Queue* q, SnapshotHeader* h, const HashIndexImage* reg,
+                       const HashIndexImage* aadhar, bool keepAllotment) {
+    const StudentStore* store = &q->students;
+    memset(h, 0, sizeof(SnapshotHeader));
+    h->magic = SNAPSHOT_MAGIC;
+    h->version = SNAPSHOT_VERSION;
+    h->header_size = sizeof(SnapshotHeader);
+    h->student_data_size = sizeof(StudentData);
+    h->index_entry_size = (uint32_t)reg->entry_size;
+    h->college_size = sizeof(College);
+    h->rank_page_size = sizeof(RankPage);
+
+    h->college_count = collegeCount;
+    h->branch_count = branchCount;
+    h->program_count = programCount;
+    h->seat_pool_count = seatPoolCount;
+    memcpy(h->seat_pool_names, seatPoolNames, sizeof(seatPoolNames));
+
+    h->verification_count = verificationDataCount;
+    h->reg_index_capacity = reg->capacity;
+    h->reg_index_count = reg->count;
+    h->aadhar_index_capacity = aadhar->capacity;
+    h->aadhar_index_count = aadhar->count;
+
+    h->student_count = store->count;
+    h->student_live = store->live;
+    h->free_list = store->free_list;
+    h->front = q->front;
+    h->names_used = store->names_used;
+    h->names_stale = store->names_stale;
+    h->preferences_used = q->preferences.used;
+    h->preferences_stale = q->preferences.stale;
+    h->rank_page_count = q->rank_slots->page_count;
+    for (int i = 0; i < q->rank_slots->page_count; i++)
+        if (q->rank_slots->pages[i] != NULL) h->rank_pages++;
+    h->bitmap_limit = q->rank_tree->bitmap_limit;
+    h->rank_count = q->rank_tree->count;
+
+    h->checkpoint_count = keepAllotment ? q->allocation->count : 0;
+    h->allocation_seconds = q->allocation->seconds;
+    h->journal_sequence = (q->journal != NULL) ? journalLastSequence(q->journal) : q->journal_sequence;
+}
+
+// Writes the session to path atomically; the in-memory state is unchanged
+bool saveSnapshot(Queue* q, const char* path) {
+    char* tmpPath = (char*)malloc(strlen(path) + 5);
+    sprintf(tmpPath, "%s.tmp", path);
+    FILE* file = fopen(tmpPath, "wb");
+    if (file == NULL) {
+        printf("%sError: Cannot write snapshot %s: %s%s\n", COLOR_RED, tmpPath, strerror(errno), COLOR_RESET);
+        free(tmpPath);
+        return false;
+    }
+    setvbuf(file, NULL, _IOFBF, 1 << 20);
+
+    HashIndexImage reg, aadhar;
+    verificationIndexImages(&reg, &aadhar);
+    bool keepAllotment = q->allocation->valid && q->rounds == NULL && seatPoolCount == 1 &&
+                         q->allocation->engine == ALLOCATION_SERIAL;
+    SnapshotHeader header;
+    fillHeader(q, &header, &reg, &aadhar, keepAllotment);
+
+    const StudentStore* store = &q->students;
+    size_t n = (size_t)store->count;
+    size_t slots = (size_t)seatPoolCount * programCount;
+    SnapshotWriter w = { file, 0, &header, false, 0 };
+    writeBytes(&w, &header, sizeof(SnapshotHeader));  // Rewritten once the offsets are known
+
+    writeSection(&w, SECTION_COLLEGES, colleges, collegeCount * sizeof(College));
+    writeSection(&w, SECTION_BRANCHES, branches, branchCount * sizeof(Branch));
+    writeSection(&w, SECTION_PROGRAMS, programs, programCount * sizeof(Program));
+    writeSection(&w, SECTION_PROGRAM_CAPACITY, programCapacity, programCount * sizeof(int));
+    writeSection(&w, SECTION_PROGRAM_SEATS, programSeats, programCount * sizeof(int));
+    if (poolCapacity != NULL) {
+        writeSection(&w, SECTION_POOL_CAPACITY, poolCapacity, slots * sizeof(int));
+        writeSection(&w, SECTION_POOL_SEATS, poolSeats, slots * sizeof(int));
+    }
+
+    writeSection(&w, SECTION_VERIFICATION, verificationData, verificationDataCount * sizeof(StudentData));
+    writeSection(&w, SECTION_REG_INDEX, reg.entries, reg.capacity * reg.entry_size);
+    writeSection(&w, SECTION_AADHAR_INDEX, aadhar.entries, aadhar.capacity * aadhar.entry_size);
+
+    writeSection(&w, SECTION_RANK, store->rank, n * sizeof(int));
+    writeSection(&w, SECTION_ALLOCATED_PROGRAM, store->allocated_program, n * sizeof(int));
+    writeSection(&w, SECTION_PREF_OFFSET, store->pref_offset, n * sizeof(uint32_t));
+    writeSection(&w, SECTION_NUM_PREFERENCES, store->num_preferences, n * sizeof(uint16_t));
+    writeSection(&w, SECTION_FLAGS, store->flags, n);
+    writeSection(&w, SECTION_ROUND_STATUS, store->round_status, n);
+    writeSection(&w, SECTION_CATEGORIES, store->categories, n);
+    writeSection(&w, SECTION_ALLOCATED_POOL, store->allocated_pool, n);
+    writeSection(&w, SECTION_NEXT, store->next, n * sizeof(StudentId));
+    writeSection(&w, SECTION_REG_NUMBER, store->reg_number, n * MAX_REG_LENGTH);
+    writeSection(&w, SECTION_NAME, store->name, n * sizeof(uint32_t));
+    writeSection(&w, SECTION_NAMES, store->names, store->names_used);
+    writeSection(&w, SECTION_PREFERENCES, q->preferences.ids, q->preferences.used * sizeof(uint16_t));
+
+    const RankBuckets* rb = q->rank_slots;
+    openSection(&w, SECTION_RANK_PAGE_INDEX);
+    for (int i = 0, page = 0; i < rb->page_count; i++) {
+        int32_t index = (rb->pages[i] != NULL) ? page++ : -1;
+        writeBytes(&w, &index, sizeof(index));
+    }
+    closeSection(&w, SECTION_RANK_PAGE_INDEX);
+    openSection(&w, SECTION_RANK_PAGES);
+    for (int i = 0; i < rb->page_count; i++)
+        if (rb->pages[i] != NULL) writeBytes(&w, rb->pages[i], sizeof(RankPage));
+    closeSection(&w, SECTION_RANK_PAGES);
+    writeSection(&w, SECTION_RANK_BITMAP, q->rank_tree->bitmap, (q->rank_tree->bitmap_limit / 64) * sizeof(uint64_t));
+
+    if (keepAllotment) {
+        const AllocationState* state = q->allocation;
+        writeSection(&w, SECTION_CHECKPOINT_RANKS, state->ranks, state->count * sizeof(int));
+        writeSection(&w, SECTION_CHECKPOINT_SEATS, state->seats, (size_t)state->count * programCount * sizeof(int));
+    }
+    padSection(&w);
+    header.file_size = w.offset;
+
+    // Each step keeps the errno of the call that failed
+    bool ok = !w.failed && fseek(file, 0, SEEK_SET) == 0 &&
+              fwrite(&header, sizeof(SnapshotHeader), 1, file) == 1 &&
+              fflush(file) == 0 && fsync(fileno(file)) == 0;
+    int error = w.failed ? w.error : (ok ? 0 : errno);
+    if (fclose(file) != 0 && ok) {
+        ok = false;
+        error = errno;
+    }
+    if (ok && rename(tmpPath, path) != 0) {
+        ok = false;
+        error = errno;
+    }
+    if (ok) {
+        syncParentDirectory(path);
+    } else {
+        printf("%sError: Cannot write snapshot %s: %s%s\n", COLOR_RED, path, strerror(error), COLOR_RESET);
+        unlink(tmpPath);
+    }
+    free(tmpPath);
+    return ok;
+}
+
+
+// ==========================================================
+//                        LOADING
+// ==========================================================
+
+// Bytes a section must hold for the counts in the header
+static uint64_t expectedLength(const SnapshotHeader* h, int section) {
+    uint64_t n = (uint64_t)h->student_count;
+    uint64_t slots = (uint64_t)h->seat_pool_count * h->program_count;
+    switch (section) {
+        case SECTION_COLLEGES:          return (uint64_t)h->college_count * sizeof(College);
+        case SECTION_BRANCHES:          return (uint64_t)h->branch_count * sizeof(Branch);
+        case SECTION_PROGRAMS:          return (uint64_t)h->program_count * sizeof(Program);
+        case SECTION_PROGRAM_CAPACITY:
+        case SECTION_PROGRAM_SEATS:     return (uint64_t)h->program_count * sizeof(int);
+        case SECTION_POOL_CAPACITY:
+        case SECTION_POOL_SEATS:        return h->seat_pool_count > 1 ? slots * sizeof(int) : 0;
+        case SECTION_VERIFICATION:      return (uint64_t)h->verification_count * sizeof(StudentData);
+        case SECTION_REG_INDEX:         return (uint64_t)h->reg_index_capacity * h->index_entry_size;
+        case SECTION_AADHAR_INDEX:      return (uint64_t)h->aadhar_index_capacity * h->index_entry_size;
+        case SECTION_RANK:
+        case SECTION_ALLOCATED_PROGRAM: return n * sizeof(int);
+        case SECTION_PREF_OFFSET:       return n * sizeof(uint32_t);
+        case SECTION_NUM_PREFERENCES:   return n * sizeof(uint16_t);
+        case SECTION_FLAGS:
+        case SECTION_ROUND_STATUS:
+        case SECTION_CATEGORIES:
+        case SECTION_ALLOCATED_POOL:    return n;
+        case SECTION_NEXT:              return n * sizeof(StudentId);
+        case SECTION_REG_NUMBER:        return n * MAX_REG_LENGTH;
+        case SECTION_NAME:              return n * sizeof(uint32_t);
+        case SECTION_NAMES:             return h->names_used;
+        case SECTION_PREFERENCES:       return h->preferences_used * sizeof(uint16_t);
+        case SECTION_RANK_PAGE_INDEX:   return (uint64_t)h->rank_page_count * sizeof(int32_t);
+        case SECTION_RANK_PAGES:        return (uint64_t)h->rank_pages * sizeof(RankPage);
+        case SECTION_RANK_BITMAP:       return (uint64_t)(h->bitmap_limit / 64) * sizeof(uint64_t);
+        case SECTION_CHECKPOINT_RANKS:  return (uint64_t)h->checkpoint_count * sizeof(int);
+        case SECTION_CHECKPOINT_SEATS:  return (uint64_t)h->checkpoint_count * h->program_count * sizeof(int);
+    }
+    return 0;
+}
+
+// Checks the header and that every section fits the file and the counts.
+// The records themselves are trusted, as the file was written by saveSnapshot.
+static const char* checkSnapshot(const char* base, size_t size) {
+    if (size < sizeof(SnapshotHeader)) return "not a snapshot file";
+    const SnapshotHeader* h = (const SnapshotHeader*)base;
+    if (h->magic != SNAPSHOT_MAGIC) return "not a snapshot file";
+    if (h->version != SNAPSHOT_VERSION) return "unsupported snapshot version";
+    if (h->header_size != sizeof(SnapshotHeader) || h->student_data_size != sizeof(StudentData) ||
+        h->college_size != sizeof(College) || h->rank_page_size != sizeof(RankPage))
+        return "snapshot was written by an incompatible build";
+    if (h->file_size != size) return "snapshot is truncated";
+    if (h->program_count < 1 || h->program_count > MAX_PROGRAMS || h->college_count < 1 ||
+        h->branch_count < 1 || h->seat_pool_count < 1 || h->seat_pool_count > MAX_SEAT_POOLS ||
+        h->student_count < 0 || h->verification_count < 0 || h->rank_page_count < 0 ||
+        h->rank_pages < 0 || h->rank_pages > h->rank_page_count || h->bitmap_limit < 0 ||
+        h->checkpoint_count < 0 || h->reg_index_capacity < 0 || h->aadhar_index_capacity < 0 ||
+        (h->front < -1 || h->front >= h->student_count))
+        return "snapshot header is corrupt";
+
+    for (int i = 0; i < SECTION_COUNT; i++) {
+        const SnapshotSection* section = &h->sections[i];
+        if (section->length != expectedLength(h, i)) return "snapshot section has the wrong size";
+        if (section->length == 0) continue;
+        if (section->offset % SNAPSHOT_ALIGN != 0 || section->offset > size ||
+            section->length > size - section->offset)
+            return "snapshot section lies outside the file";
+    }
+    return NULL;
+}
+
+static void* sectionData(const SnapshotHeader* h, int section) {
+    if (h->sections[section].length == 0) return NULL;
+    return mappedBase + h->sections[section].offset;
+}
+
+// Maps path and builds a queue over it; also installs the snapshot's
+// catalog and verification store. Returns NULL if the file is unusable.
+Queue* loadSnapshot(const char* path) {
+    if (mappedBase != NULL) {
+        printf("%sError: A snapshot is already loaded%s\n", COLOR_RED, COLOR_RESET);
+        return NULL;
+    }
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("%sError: Cannot open snapshot %s: %s%s\n", COLOR_RED, path, strerror(errno), COLOR_RESET);
+        return NULL;
+    }
+    struct stat st;
+    void* base = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+        base = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    const char* error = (base == MAP_FAILED) ? "not a snapshot file" : checkSnapshot((const char*)base, (size_t)st.st_size);
+    if (error != NULL) {
+        printf("%sError: %s: %s%s\n", COLOR_RED, path, error, COLOR_RESET);
+        if (base != MAP_FAILED) munmap(base, (size_t)st.st_size);
+        return NULL;
+    }
+    mappedBase = (char*)base;
+    mappedSize = (size_t)st.st_size;
+    const SnapshotHeader* h = (const SnapshotHeader*)base;
+
+    // Catalog and seat matrix
+    releaseCatalog();
+    colleges = (College*)sectionData(h, SECTION_COLLEGES);
+    collegeCount = h->college_count;
+    branches = (Branch*)sectionData(h, SECTION_BRANCHES);
+    branchCount = h->branch_count;
+    programs = (Program*)sectionData(h, SECTION_PROGRAMS);
+    programCount = h->program_count;
+    programCapacity = (int*)sectionData(h, SECTION_PROGRAM_CAPACITY);
+    programSeats = (int*)sectionData(h, SECTION_PROGRAM_SEATS);
+    seatPoolCount = h->seat_pool_count;
+    memcpy(seatPoolNames, h->seat_pool_names, sizeof(seatPoolNames));
+    poolCapacity = (int*)sectionData(h, SECTION_POOL_CAPACITY);
+    poolSeats = (int*)sectionData(h, SECTION_POOL_SEATS);
+
+    HashIndexImage reg = { sectionData(h, SECTION_REG_INDEX), h->reg_index_capacity,
+                           h->reg_index_count, h->index_entry_size };
+    HashIndexImage aadhar = { sectionData(h, SECTION_AADHAR_INDEX), h->aadhar_index_capacity,
+                              h->aadhar_index_count, h->index_entry_size };
+    adoptVerificationData((StudentData*)sectionData(h, SECTION_VERIFICATION), h->verification_count,
+                          &reg, &aadhar);
+
+    // Student columns and preference runs
+    Queue* q = createQueue();
+    StudentStore* store = &q->students;
+    studentStoreRelease(store);
+    store->rank = (int*)sectionData(h, SECTION_RANK);
+    store->allocated_program = (int*)sectionData(h, SECTION_ALLOCATED_PROGRAM);
+    store->pref_offset = (uint32_t*)sectionData(h, SECTION_PREF_OFFSET);
+    store->num_preferences = (uint16_t*)sectionData(h, SECTION_NUM_PREFERENCES);
+    store->flags = (uint8_t*)sectionData(h, SECTION_FLAGS);
+    store->round_status = (uint8_t*)sectionData(h, SECTION_ROUND_STATUS);
+    store->categories = (uint8_t*)sectionData(h, SECTION_CATEGORIES);
+    store->allocated_pool = (uint8_t*)sectionData(h, SECTION_ALLOCATED_POOL);
+    store->next = (StudentId*)sectionData(h, SECTION_NEXT);
+    store->reg_number = (char (*)[MAX_REG_LENGTH])sectionData(h, SECTION_REG_NUMBER);
+    store->name = (uint32_t*)sectionData(h, SECTION_NAME);
+    store->names = (char*)sectionData(h, SECTION_NAMES);
+    store->names_used = store->names_capacity = h->names_used;
+    store->names_stale = h->names_stale;
+    store->count = store->capacity = h->student_count;
+    store->live = h->student_live;
+    store->free_list = h->free_list;
+    q->preferences.ids = (uint16_t*)sectionData(h, SECTION_PREFERENCES);
+    q->preferences.used = q->preferences.capacity = h->preferences_used;
+    q->preferences.stale = h->preferences_stale;
+    q->front = h->front;
+    q->journal_sequence = h->journal_sequence;
+
+    // Rank buckets: only the page directory is allocated
+    RankBuckets* rb = q->rank_slots;
+    const int32_t* pageIndex = (const int32_t*)sectionData(h, SECTION_RANK_PAGE_INDEX);
+    RankPage* pages = (RankPage*)sectionData(h, SECTION_RANK_PAGES);
+    rb->page_count = h->rank_page_count;
+    rb->pages = (RankPage**)malloc((rb->page_count ? rb->page_count : 1) * sizeof(RankPage*));
+    for (int i = 0; i < rb->page_count; i++)
+        rb->pages[i] = (pageIndex[i] >= 0 && pageIndex[i] < h->rank_pages) ? &pages[pageIndex[i]] : NULL;
+
+    RankIndex* index = q->rank_tree;
+    index->bitmap = (uint64_t*)sectionData(h, SECTION_RANK_BITMAP);
+    index->bitmap_limit = h->bitmap_limit;
+    index->count = h->rank_count;
+    index->tree_pending = (q->front != NO_STUDENT);
+    q->co_preferences->pending = true;
+
+    // An allotment that was current when saved stays current
+    AllocationState* state = q->allocation;
+    if (h->checkpoint_count > 0) {
+        state->ranks = (int*)sectionData(h, SECTION_CHECKPOINT_RANKS);
+        state->seats = (int*)sectionData(h, SECTION_CHECKPOINT_SEATS);
+        state->count = state->capacity = h->checkpoint_count;
+        state->seconds = h->allocation_seconds;
+        state->valid = true;
+        buildCutoffs(q);
+    }
+    return q;
+}
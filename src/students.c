@@ -0,0 +1,218 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "enhanced_ds.h"
+
+// ==========================================================
+//   STUDENT COLUMN STORE
+//
+//   A student is an index into parallel arrays. Ids are handed
+//   out densely and released ids are reused, so the columns
+//   stay compact; growing them moves the arrays but never
+//   invalidates an id. Names are appended to one string heap
+//   instead of a fixed buffer per student.
+// ==========================================================
+
+#define STORE_HOT_BYTES (sizeof(int) * 2 + sizeof(uint32_t) + sizeof(uint16_t) + \
+                         sizeof(uint8_t) * 4 + sizeof(StudentId))
+#define STORE_COLD_BYTES (MAX_REG_LENGTH + sizeof(uint32_t))
+
+// Columns of a store loaded from a snapshot still live in the mapping
+// until they first grow
+static void* growColumn(void* column, int oldCapacity, int capacity, size_t itemSize) {
+    return snapshotRealloc(column, (size_t)oldCapacity * itemSize, (size_t)capacity * itemSize);
+}
+
+static void resizeStore(StudentStore* store, int capacity) {
+    int old = store->capacity;
+    store->rank = growColumn(store->rank, old, capacity, sizeof(int));
+    store->allocated_program = growColumn(store->allocated_program, old, capacity, sizeof(int));
+    store->pref_offset = growColumn(store->pref_offset, old, capacity, sizeof(uint32_t));
+    store->num_preferences = growColumn(store->num_preferences, old, capacity, sizeof(uint16_t));
+    store->flags = growColumn(store->flags, old, capacity, sizeof(uint8_t));
+    store->round_status = growColumn(store->round_status, old, capacity, sizeof(uint8_t));
+    store->categories = growColumn(store->categories, old, capacity, sizeof(uint8_t));
+    store->allocated_pool = growColumn(store->allocated_pool, old, capacity, sizeof(uint8_t));
+    store->next = growColumn(store->next, old, capacity, sizeof(StudentId));
+    store->reg_number = growColumn(store->reg_number, old, capacity, MAX_REG_LENGTH);
+    store->name = growColumn(store->name, old, capacity, sizeof(uint32_t));
+    store->capacity = capacity;
+}
+
+static void growStore(StudentStore* store) {
+    resizeStore(store, store->capacity ? store->capacity * 2 : STUDENT_STORE_INITIAL);
+}
+
+// Appends a NUL-terminated copy of text to the names heap
+static uint32_t appendName(StudentStore* store, const char* text, size_t length) {
+    if (store->names_used + length + 1 > store->names_capacity) {
+        size_t capacity = store->names_capacity ? store->names_capacity * 2 : 16384;
+        while (capacity < store->names_used + length + 1) capacity *= 2;
+        store->names = (char*)snapshotRealloc(store->names, store->names_used, capacity);
+        store->names_capacity = capacity;
+    }
+    uint32_t offset = (uint32_t)store->names_used;
+    memcpy(store->names + offset, text, length);
+    store->names[offset + length] = '\0';
+    store->names_used += length + 1;
+    return offset;
+}
+
+void studentStoreInit(StudentStore* store) {
+    memset(store, 0, sizeof(StudentStore));
+    store->free_list = NO_STUDENT;
+    appendName(store, "", 0);  // Offset 0 is the empty name
+}
+
+void studentStoreRelease(StudentStore* store) {
+    snapshotFree(store->rank);
+    snapshotFree(store->allocated_program);
+    snapshotFree(store->pref_offset);
+    snapshotFree(store->num_preferences);
+    snapshotFree(store->flags);
+    snapshotFree(store->round_status);
+    snapshotFree(store->categories);
+    snapshotFree(store->allocated_pool);
+    snapshotFree(store->next);
+    snapshotFree(store->reg_number);
+    snapshotFree(store->name);
+    snapshotFree(store->names);
+    memset(store, 0, sizeof(StudentStore));
+    store->free_list = NO_STUDENT;
+}
+
+// Returns a cleared record owned by the queue's store
+StudentId allocStudent(Queue* q) {
+    StudentStore* store = &q->students;
+    StudentId id;
+    if (store->free_list != NO_STUDENT) {
+        id = store->free_list;
+        store->free_list = store->next[id];
+    } else {
+        if (store->count == store->capacity) growStore(store);
+        id = store->count++;
+    }
+
+    store->rank[id] = 0;
+    store->allocated_program[id] = PROGRAM_NOT_ALLOCATED;
+    store->pref_offset[id] = 0;
+    store->num_preferences[id] = 0;
+    store->flags[id] = 0;
+    store->round_status[id] = ROUND_FLOAT;
+    store->categories[id] = POOL_GENERAL;
+    store->allocated_pool[id] = 0;
+    store->next[id] = NO_STUDENT;
+    store->reg_number[id][0] = '\0';
+    store->name[id] = 0;
+    store->live++;
+    return id;
+}
+
+// Hands back a record that was rejected before it was enqueued
+void releaseStudent(Queue* q, StudentId student) {
+    StudentStore* store = &q->students;
+    q->preferences.stale += store->num_preferences[student];
+    if (store->name[student] != 0)
+        store->names_stale += strlen(STUDENT_NAME(store, student)) + 1;
+    store->num_preferences[student] = 0;
+    store->name[student] = 0;
+    store->rank[student] = 0;  // Scans of the columns skip ids with no rank
+    store->next[student] = store->free_list;
+    store->free_list = student;
+    store->live--;
+}
+
+// A name that fits over the current one is written in place
+void setStudentName(Queue* q, StudentId student, const char* name) {
+    StudentStore* store = &q->students;
+    size_t length = strlen(name);
+    if (store->name[student] != 0) {
+        char* current = STUDENT_NAME(store, student);
+        size_t currentLength = strlen(current);
+        if (length <= currentLength) {
+            memcpy(current, name, length + 1);
+            store->names_stale += currentLength - length;
+            return;
+        }
+        store->names_stale += currentLength + 1;
+    }
+    store->name[student] = (length == 0) ? 0 : appendName(store, name, length);
+}
+
+// Gives the students in order ids 0, 1, 2, ... and every other id the
+// next ones, keeping their relative order. Preference runs and names are
+// rewritten in the new id order too, which drops their stale entries, so
+// a pass over the queue reads every column front to back. Only valid
+// while no index or list outside the store holds ids.
+void renumberStudents(Queue* q, const StudentId* order, int count) {
+    StudentStore* store = &q->students;
+    int total = store->count;
+    if (total == 0) return;
+
+    StudentId* map = (StudentId*)malloc(total * sizeof(StudentId));
+    for (int i = 0; i < total; i++) map[i] = NO_STUDENT;
+    for (int i = 0; i < count; i++) map[order[i]] = i;
+    StudentId nextId = count;
+    for (int i = 0; i < total; i++)
+        if (map[i] == NO_STUDENT) map[i] = nextId++;
+
+    StudentStore old = *store;
+    memset(store, 0, sizeof(StudentStore));
+    store->count = total;
+    store->live = old.live;
+    resizeStore(store, old.capacity);
+    appendName(store, "", 0);
+
+    PreferencePool* pool = &q->preferences;
+    uint16_t* ids = (uint16_t*)malloc((pool->capacity ? pool->capacity : 1) * sizeof(uint16_t));
+    size_t used = 0;
+
+    // Walk the new ids in order so the runs and names are laid out by id
+    StudentId* inverse = (StudentId*)malloc(total * sizeof(StudentId));
+    for (int i = 0; i < total; i++) inverse[map[i]] = i;
+    for (StudentId id = 0; id < total; id++) {
+        StudentId from = inverse[id];
+        store->rank[id] = old.rank[from];
+        store->allocated_program[id] = old.allocated_program[from];
+        store->num_preferences[id] = old.num_preferences[from];
+        store->flags[id] = old.flags[from];
+        store->round_status[id] = old.round_status[from];
+        store->categories[id] = old.categories[from];
+        store->allocated_pool[id] = old.allocated_pool[from];
+        store->next[id] = (old.next[from] == NO_STUDENT) ? NO_STUDENT : map[old.next[from]];
+        memcpy(store->reg_number[id], old.reg_number[from], MAX_REG_LENGTH);
+
+        store->pref_offset[id] = (uint32_t)used;
+        if (old.num_preferences[from] > 0) {
+            memcpy(ids + used, pool->ids + old.pref_offset[from],
+                   old.num_preferences[from] * sizeof(uint16_t));
+            used += old.num_preferences[from];
+        }
+
+        const char* name = old.names + old.name[from];
+        store->name[id] = (name[0] == '\0') ? 0 : appendName(store, name, strlen(name));
+    }
+    store->free_list = (old.free_list == NO_STUDENT) ? NO_STUDENT : map[old.free_list];
+    if (q->front != NO_STUDENT) q->front = map[q->front];
+
+    snapshotFree(pool->ids);
+    pool->ids = ids;
+    pool->used = used;
+    pool->stale = 0;
+
+    free(inverse);
+    free(map);
+    studentStoreRelease(&old);
+}
+
+// One status line: live records, reserved slots and bytes per column group
+void studentStoreReport(const StudentStore* store) {
+    double hotKb = store->capacity * (double)STORE_HOT_BYTES / 1024.0;
+    double coldKb = store->capacity * (double)STORE_COLD_BYTES / 1024.0;
+    double live = store->live > 0 ? store->live : 1;
+    printf("Student store: %d live, %d reserved; hot %.1f KB, cold %.1f KB, "
+           "names %.1f KB (%zu stale bytes), %.1f bytes/student\n",
+           store->live, store->capacity, hotKb, coldKb,
+           store->names_capacity / 1024.0, store->names_stale,
+           (hotKb + coldKb) * 1024.0 / live + (double)store->names_used / live);
+}
@@ -0,0 +1,144 @@
+#define _POSIX_C_SOURCE 200809L
+#include <string.h>
+#include <time.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include "enhanced_ds.h"
+
+// ==========================================================
+//   BULK FIELD VALIDATION
+//
+//   Registration numbers, dates of birth and Aadhar numbers are
+//   checked a block at a time. packField copies a field into a
+//   VALID_FIELD_WIDTH slot padded with NULs, which turns its
+//   length into part of its shape: with SSE2 one slot is one
+//   register, and a single compare pass checks that digits sit
+//   where digits belong and that every other byte is exactly
+//   the expected letter, separator or NUL padding. Only records
+//   that fail are looked at again to tell a bad length from a
+//   bad character. The calendar check is scalar, against a
+//   reference date taken once for the whole block.
+// ==========================================================
+
+static const char dateShape[VALID_FIELD_WIDTH]   = "99-99-9999";
+static const char aadharShape[VALID_FIELD_WIDTH] = "9999-9999-9999";
+static const char regShape[VALID_FIELD_WIDTH]    = "DC";  // Digits from 2 up to the length
+
+void packField(char* slot, const char* text) {
+    // strncpy pads with NULs; text that fills the slot has no terminator
+    // and fails every shape
+    strncpy(slot, text, VALID_FIELD_WIDTH);
+}
+
+void calendarToday(CalendarDate* today) {
+    time_t t = time(NULL);
+    struct tm now;
+    localtime_r(&t, &now);
+    today->year = now.tm_year + 1900;
+    today->month = now.tm_mon + 1;
+    today->day = now.tm_mday;
+}
+
+static int slotLength(const char* slot) {
+    const char* end = memchr(slot, '\0', VALID_FIELD_WIDTH);
+    return end != NULL ? (int)(end - slot) : VALID_FIELD_WIDTH;
+}
+
+#if defined(__SSE2__)
+// True if every byte of slot is a digit where digits is set and equals
+// literal elsewhere
+static inline bool slotMatches(const char* slot, __m128i digits, __m128i literal) {
+    __m128i bytes = _mm_loadu_si128((const __m128i*)slot);
+    __m128i offset = _mm_sub_epi8(bytes, _mm_set1_epi8('0'));
+    __m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8(9)), offset);
+    __m128i isLiteral = _mm_cmpeq_epi8(bytes, literal);
+    __m128i ok = _mm_or_si128(_mm_and_si128(digits, isDigit), _mm_andnot_si128(digits, isLiteral));
+    return _mm_movemask_epi8(ok) == 0xFFFF;
+}
+
+// Lanes holding '9' in shape take digits; the rest must match shape
+static void checkShape(const char* slots, int count, const char* shape, uint8_t* checks) {
+    __m128i pattern = _mm_loadu_si128((const __m128i*)shape);
+    __m128i digits = _mm_cmpeq_epi8(pattern, _mm_set1_epi8('9'));
+    for (int i = 0; i < count; i++)
+        checks[i] = slotMatches(slots + (size_t)i * VALID_FIELD_WIDTH, digits, pattern)
+                    ? FIELD_OK : FIELD_BAD_CHARACTER;
+}
+#else
+static void checkShape(const char* slots, int count, const char* shape, uint8_t* checks) {
+    for (int i = 0; i < count; i++) {
+        const char* slot = slots + (size_t)i * VALID_FIELD_WIDTH;
+        uint8_t check = FIELD_OK;
+        for (int k = 0; k < VALID_FIELD_WIDTH; k++) {
+            bool ok = (shape[k] == '9') ? (slot[k] >= '0' && slot[k] <= '9') : (slot[k] == shape[k]);
+            if (!ok) check = FIELD_BAD_CHARACTER;
+        }
+        checks[i] = check;
+    }
+}
+#endif
+
+// A failed shape is a length error unless the field has the right length
+static void classifyFailures(const char* slots, int count, int length, uint8_t* checks) {
+    for (int i = 0; i < count; i++)
+        if (checks[i] != FIELD_OK && slotLength(slots + (size_t)i * VALID_FIELD_WIDTH) != length)
+            checks[i] = FIELD_BAD_LENGTH;
+}
+
+void validateAadhars(const char* slots, int count, uint8_t* checks) {
+    checkShape(slots, count, aadharShape, checks);
+    classifyFailures(slots, count, 14, checks);
+}
+
+void validateDates(const char* slots, int count, const CalendarDate* today, uint8_t* checks) {
+    static const int daysInMonth[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    int todayKey = today->year * 10000 + today->month * 100 + today->day;
+
+    checkShape(slots, count, dateShape, checks);
+    classifyFailures(slots, count, 10, checks);
+    for (int i = 0; i < count; i++) {
+        if (checks[i] != FIELD_OK) continue;
+        const char* d = slots + (size_t)i * VALID_FIELD_WIDTH;
+        int day = (d[0] - '0') * 10 + (d[1] - '0');
+        int month = (d[3] - '0') * 10 + (d[4] - '0');
+        int year = (d[6] - '0') * 1000 + (d[7] - '0') * 100 + (d[8] - '0') * 10 + (d[9] - '0');
+
+        if (year < 1900 || month < 1 || month > 12) {
+            checks[i] = FIELD_BAD_DATE;
+            continue;
+        }
+        bool isLeap = (year % 4 == 0 && year % 100 != 0) || (year % 400 == 0);
+        int days = daysInMonth[month - 1] + (month == 2 && isLeap);
+        if (day < 1 || day > days)
+            checks[i] = FIELD_BAD_DATE;
+        else if (year * 10000 + month * 100 + day >= todayKey)
+            checks[i] = FIELD_NOT_PAST;  // Must be strictly before today
+    }
+}
+
+// "DC" and 3-7 digits, so the shape depends on each field's length
+void validateRegNumbers(const char* slots, int count, uint8_t* checks) {
+#if defined(__SSE2__)
+    __m128i pattern = _mm_loadu_si128((const __m128i*)regShape);
+    __m128i lane = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    __m128i afterPrefix = _mm_cmpgt_epi8(lane, _mm_set1_epi8(1));
+#endif
+    for (int i = 0; i < count; i++) {
+        const char* slot = slots + (size_t)i * VALID_FIELD_WIDTH;
+        int length = slotLength(slot);
+        if (length < 5 || length > MAX_REG_LENGTH - 1) {
+            checks[i] = FIELD_BAD_LENGTH;
+            continue;
+        }
+#if defined(__SSE2__)
+        __m128i digits = _mm_and_si128(afterPrefix, _mm_cmplt_epi8(lane, _mm_set1_epi8((char)length)));
+        checks[i] = slotMatches(slot, digits, pattern) ? FIELD_OK : FIELD_BAD_CHARACTER;
+#else
+        uint8_t check = (slot[0] == regShape[0] && slot[1] == regShape[1]) ? FIELD_OK : FIELD_BAD_CHARACTER;
+        for (int k = 2; k < length; k++)
+            if (slot[k] < '0' || slot[k] > '9') check = FIELD_BAD_CHARACTER;
+        checks[i] = check;
+#endif
+    }
+}
@@ -1,14 +1,14 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
-#include <time.h>
 #include "enhanced_ds.h"
 
 // ==========================================================
 //        GLOBAL VERIFICATION DATA (FIXED DUPLICATES)
 // ==========================================================
 
-StudentData verificationData[MAX_VERIFICATION_DATA] = {
+// Seed records; the store moves to the heap the first time it grows
+static StudentData seedData[] = {
     {"DC101", "A", "01-01-2006", "1111-1111-1111"},
     {"DC102", "B", "02-02-2006", "2222-2222-2222"},
     {"DC103", "C", "03-03-2006", "3333-3333-3333"},
@@ -16,51 +16,222 @@ StudentData verificationData[MAX_VERIFICATION_DATA] = {
     {"DC105", "E", "05-05-2006", "5555-5555-5555"}
 };
 
+StudentData* verificationData = seedData;
 int verificationDataCount = 5;
+static int verificationDataCapacity = 5;
 
 
 // ==========================================================
-//         STRICT & CORRECT DOB VALIDATION
+//       HASH INDEXES (REG NUMBER / AADHAR -> RECORD)
 // ==========================================================
-bool isValidDOB(const char* dob) {
-    if (strlen(dob) != 10) return false;
-    if (dob[2] != '-' || dob[5] != '-') return false;
 
-    // All other characters must be digits
-    for (int i = 0; i < 10; i++) {
-        if (i == 2 || i == 5) continue;
-        if (!isdigit(dob[i])) return false;
+// Open addressing with linear probing. Keys are packed integers, so a
+// probe is one 64-bit compare instead of a strcmp.
+typedef struct {
+    uint64_t key;             // 0 marks an empty slot
+    int data_index;           // Position in verificationData[], -1 if none
+    StudentId student;        // Queued student, NO_STUDENT if none
+} HashEntry;
+
+typedef struct {
+    HashEntry* entries;
+    int capacity;  // Power of two
+    int count;
+} HashIndex;
+
+static HashIndex regIndex;
+static HashIndex aadharIndex;
+
+// "DC" + 3-7 digits -> (digit count << 24) | value, so DC001 and DC0001 differ
+uint64_t packRegNumber(const char* reg_number) {
+    if (!isValidRegNumber(reg_number)) return 0;
+
+    uint64_t value = 0;
+    int digits = 0;
+    for (const char* p = reg_number + 2; *p != '\0'; p++, digits++)
+        value = value * 10 + (uint64_t)(*p - '0');
+    return ((uint64_t)digits << 24) | value;
+}
+
+// 12 Aadhar digits -> 40-bit value (+1 so that 0 stays free for empty slots)
+uint64_t packAadhar(const char* aadhar) {
+    if (!isValidAadhar(aadhar)) return 0;
+
+    uint64_t value = 0;
+    for (int i = 0; i < 14; i++) {
+        if (i == 4 || i == 9) continue;
+        value = value * 10 + (uint64_t)(aadhar[i] - '0');
     }
+    return value + 1;
+}
 
-    int day  = (dob[0] - '0') * 10 + (dob[1] - '0');
-    int month = (dob[3] - '0') * 10 + (dob[4] - '0');
-    int year = (dob[6] - '0') * 1000 + (dob[7] - '0') * 100 +
-               (dob[8] - '0') * 10 + (dob[9] - '0');
+static uint32_t hashSlot(const HashIndex* index, uint64_t key) {
+    uint64_t h = key * 0x9E3779B97F4A7C15ULL;
+    return (uint32_t)(h >> 32) & (uint32_t)(index->capacity - 1);
+}
 
-    if (year < 1900) return false;
-    if (month < 1 || month > 12) return false;
+static HashEntry* hashLookup(const HashIndex* index, uint64_t key) {
+    if (key == 0 || index->capacity == 0) return NULL;
 
-    int daysInMonth[] = {31,28,31,30,31,30,31,31,30,31,30,31};
+    uint32_t mask = (uint32_t)index->capacity - 1;
+    for (uint32_t i = hashSlot(index, key); ; i = (i + 1) & mask) {
+        HashEntry* e = &index->entries[i];
+        if (e->key == key) return e;
+        if (e->key == 0) return NULL;
+    }
+}
 
-    bool isLeap = (year % 4 == 0 && year % 100 != 0) || (year % 400 == 0);
-    if (isLeap) daysInMonth[1] = 29;
+static void hashGrow(HashIndex* index) {
+    HashEntry* old = index->entries;
+    int oldCapacity = index->capacity;
 
-    if (day < 1 || day > daysInMonth[month - 1]) return false;
+    index->capacity = oldCapacity ? oldCapacity * 2 : 64;
+    index->entries = (HashEntry*)calloc(index->capacity, sizeof(HashEntry));
 
-    // Check against today's date
-    time_t t = time(NULL);
-    struct tm now = *localtime(&t);
+    uint32_t mask = (uint32_t)index->capacity - 1;
+    for (int j = 0; j < oldCapacity; j++) {
+        if (old[j].key == 0) continue;
+        uint32_t i = hashSlot(index, old[j].key);
+        while (index->entries[i].key != 0) i = (i + 1) & mask;
+        index->entries[i] = old[j];
+    }
+    snapshotFree(old);
+}
 
-    int cDay = now.tm_mday;
-    int cMonth = now.tm_mon + 1;
-    int cYear = now.tm_year + 1900;
+// Returns the entry for key, creating an empty one if needed
+static HashEntry* hashInsert(HashIndex* index, uint64_t key) {
+    // Keep the load factor at or below 1/2
+    if ((index->count + 1) * 2 > index->capacity)
+        hashGrow(index);
+
+    uint32_t mask = (uint32_t)index->capacity - 1;
+    uint32_t i = hashSlot(index, key);
+    while (index->entries[i].key != 0) {
+        if (index->entries[i].key == key) return &index->entries[i];
+        i = (i + 1) & mask;
+    }
 
-    // DOB must be strictly *before* today
-    if (year > cYear) return false;
-    if (year == cYear && month > cMonth) return false;
-    if (year == cYear && month == cMonth && day >= cDay) return false;
+    HashEntry* e = &index->entries[i];
+    e->key = key;
+    e->data_index = -1;
+    e->student = NO_STUDENT;
+    index->count++;
+    return e;
+}
 
-    return true;
+// Backward-shift deletion keeps probe chains intact without tombstones
+static void hashRemove(HashIndex* index, uint64_t key) {
+    HashEntry* e = hashLookup(index, key);
+    if (e == NULL) return;
+
+    uint32_t mask = (uint32_t)index->capacity - 1;
+    uint32_t hole = (uint32_t)(e - index->entries);
+    uint32_t i = hole;
+    while (1) {
+        i = (i + 1) & mask;
+        HashEntry* next = &index->entries[i];
+        if (next->key == 0) break;
+
+        // Move next into the hole if its home slot is not between hole and i
+        uint32_t home = hashSlot(index, next->key);
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            index->entries[hole] = *next;
+            hole = i;
+        }
+    }
+    index->entries[hole].key = 0;
+    index->count--;
+}
+
+// The seed records are indexed on first use
+static void ensureIndexes(void) {
+    if (regIndex.capacity != 0) return;
+
+    for (int i = 0; i < verificationDataCount; i++) {
+        hashInsert(&regIndex, packRegNumber(verificationData[i].reg_number))->data_index = i;
+        hashInsert(&aadharIndex, packAadhar(verificationData[i].aadhar))->data_index = i;
+    }
+}
+
+// The store and both indexes are flat arrays of plain records, so a
+// snapshot saves them as they are and hands them back in place
+static HashIndexImage indexImage(const HashIndex* index) {
+    HashIndexImage image = { index->entries, index->capacity, index->count, sizeof(HashEntry) };
+    return image;
+}
+
+void verificationIndexImages(HashIndexImage* reg, HashIndexImage* aadhar) {
+    ensureIndexes();
+    *reg = indexImage(&regIndex);
+    *aadhar = indexImage(&aadharIndex);
+}
+
+// Takes over records and indexes saved by a snapshot; they are grown
+// (and copied out of the mapping) like any others once they fill up
+void adoptVerificationData(StudentData* data, int count,
+                           const HashIndexImage* reg, const HashIndexImage* aadhar) {
+    if (verificationData != seedData) snapshotFree(verificationData);
+    snapshotFree(regIndex.entries);
+    snapshotFree(aadharIndex.entries);
+
+    verificationData = (count > 0) ? data : seedData;
+    verificationDataCount = count;
+    verificationDataCapacity = (count > 0) ? count : 5;
+    regIndex.entries = (HashEntry*)reg->entries;
+    regIndex.capacity = reg->capacity;
+    regIndex.count = reg->count;
+    aadharIndex.entries = (HashEntry*)aadhar->entries;
+    aadharIndex.capacity = aadhar->capacity;
+    aadharIndex.count = aadhar->count;
+}
+
+// Returned records stay valid until the next addToVerificationData call
+StudentData* findVerificationByReg(const char* reg_number) {
+    ensureIndexes();
+    HashEntry* e = hashLookup(&regIndex, packRegNumber(reg_number));
+    return (e != NULL && e->data_index >= 0) ? &verificationData[e->data_index] : NULL;
+}
+
+StudentData* findVerificationByAadhar(const char* aadhar) {
+    ensureIndexes();
+    HashEntry* e = hashLookup(&aadharIndex, packAadhar(aadhar));
+    return (e != NULL && e->data_index >= 0) ? &verificationData[e->data_index] : NULL;
+}
+
+StudentId findStudentByReg(const char* reg_number) {
+    ensureIndexes();
+    HashEntry* e = hashLookup(&regIndex, packRegNumber(reg_number));
+    return e != NULL ? e->student : NO_STUDENT;
+}
+
+// Links a queued student to its registration number entry
+void indexStudent(const char* reg_number, StudentId student) {
+    uint64_t key = packRegNumber(reg_number);
+    if (key == 0) return;
+    ensureIndexes();
+    hashInsert(&regIndex, key)->student = student;
+}
+
+// Drops every student link, called when the queue owning them is freed
+void forgetIndexedStudents(void) {
+    for (int i = 0; i < regIndex.capacity; i++)
+        regIndex.entries[i].student = NO_STUDENT;
+}
+
+
+// ==========================================================
+//         STRICT & CORRECT DOB VALIDATION
+// ==========================================================
+// DD-MM-YYYY, a real calendar day from 1900 on and strictly before
+// today. Bulk imports use validateDates with one reference date.
+bool isValidDOB(const char* dob) {
+    char slot[VALID_FIELD_WIDTH];
+    CalendarDate today;
+    uint8_t check;
+    packField(slot, dob);
+    calendarToday(&today);
+    validateDates(slot, 1, &today, &check);
+    return check == FIELD_OK;
 }
 
 
@@ -68,57 +239,140 @@ bool isValidDOB(const char* dob) {
 //         STRICT AADHAR VALIDATION (XXXX-XXXX-XXXX)
 // ==========================================================
 bool isValidAadhar(const char* aadhar) {
-    if (strlen(aadhar) != 14) return false;
-    if (aadhar[4] != '-' || aadhar[9] != '-') return false;
+    char slot[VALID_FIELD_WIDTH];
+    uint8_t check;
+    packField(slot, aadhar);
+    validateAadhars(slot, 1, &check);
+    return check == FIELD_OK;
+}
 
-    for (int i = 0; i < 14; i++) {
-        if (i == 4 || i == 9) continue;
-        if (!isdigit(aadhar[i])) return false;
-    }
-    return true;
+
+// ==========================================================
+//      REGISTRATION NUMBER VALIDATION (DC + 3-7 DIGITS)
+// ==========================================================
+bool isValidRegNumber(const char* reg_number) {
+    char slot[VALID_FIELD_WIDTH];
+    uint8_t check;
+    packField(slot, reg_number);
+    validateRegNumbers(slot, 1, &check);
+    return check == FIELD_OK;
 }
 
 
 // ==========================================================
-//        ADD TO VERIFICATION DATA (UNCHANGED)
+//        ADD TO VERIFICATION DATA (GROWS ON DEMAND)
 // ==========================================================
 bool addToVerificationData(const char* reg_number,
                            const char* name,
                            const char* dob,
                            const char* aadhar)
 {
-    if (verificationDataCount >= MAX_VERIFICATION_DATA)
+    uint64_t regKey = packRegNumber(reg_number);
+    uint64_t aadharKey = packAadhar(aadhar);
+    if (regKey == 0 || aadharKey == 0)
+        return false;
+
+    ensureIndexes();
+    HashEntry* regEntry = hashLookup(&regIndex, regKey);
+    if ((regEntry != NULL && regEntry->data_index >= 0) ||
+        hashLookup(&aadharIndex, aadharKey) != NULL)
         return false;
 
+    if (verificationDataCount == verificationDataCapacity) {
+        int newCapacity = verificationDataCapacity * 2;
+        StudentData* grown;
+        if (verificationData == seedData) {
+            grown = (StudentData*)malloc(newCapacity * sizeof(StudentData));
+            if (grown != NULL)
+                memcpy(grown, seedData, sizeof(seedData));
+        } else {
+            grown = (StudentData*)snapshotRealloc(verificationData,
+                                                  verificationDataCount * sizeof(StudentData),
+                                                  newCapacity * sizeof(StudentData));
+        }
+        if (grown == NULL)
+            return false;
+        verificationData = grown;
+        verificationDataCapacity = newCapacity;
+    }
+
     strcpy(verificationData[verificationDataCount].reg_number, reg_number);
     strcpy(verificationData[verificationDataCount].name, name);
     strcpy(verificationData[verificationDataCount].dob, dob);
     strcpy(verificationData[verificationDataCount].aadhar, aadhar);
 
+    hashInsert(&regIndex, regKey)->data_index = verificationDataCount;
+    hashInsert(&aadharIndex, aadharKey)->data_index = verificationDataCount;
+
     verificationDataCount++;
     return true;
 }
 
 
+// ==========================================================
+//        REMOVE FROM VERIFICATION DATA (ROLLBACK)
+// ==========================================================
+// Undoes a registration that could not be completed. The last record
+// is moved into the freed position so the store stays dense.
+void removeFromVerificationData(const char* reg_number) {
+    ensureIndexes();
+    HashEntry* e = hashLookup(&regIndex, packRegNumber(reg_number));
+    if (e == NULL || e->data_index < 0) return;
+
+    int pos = e->data_index;
+    int last = verificationDataCount - 1;
+    hashRemove(&aadharIndex, packAadhar(verificationData[pos].aadhar));
+    if (e->student == NO_STUDENT)
+        hashRemove(&regIndex, packRegNumber(reg_number));
+    else
+        e->data_index = -1;
+
+    if (pos != last) {
+        verificationData[pos] = verificationData[last];
+        hashLookup(&regIndex, packRegNumber(verificationData[pos].reg_number))->data_index = pos;
+        hashLookup(&aadharIndex, packAadhar(verificationData[pos].aadhar))->data_index = pos;
+    }
+    verificationDataCount--;
+}
+
+
+// ==========================================================
+//          NON-INTERACTIVE CLAIM CHECK
+// ==========================================================
+// Same checks as verifyStudent, for a (reg, DOB, Aadhar) claim that
+// is already in hand
+VerifyResult checkVerificationClaim(const char* reg_number,
+                                    const char* dob,
+                                    const char* aadhar)
+{
+    METRIC_SPAN_BEGIN(check);
+    VerifyResult result = VERIFY_OK;
+    StudentData* vData = findVerificationByReg(reg_number);
+    if (!vData)
+        result = VERIFY_UNKNOWN_REG;
+    else if (!isValidDOB(dob) || strcmp(dob, vData->dob) != 0)
+        result = VERIFY_DOB_MISMATCH;
+    else if (!isValidAadhar(aadhar) || strcmp(aadhar, vData->aadhar) != 0)
+        result = VERIFY_AADHAR_MISMATCH;
+    METRIC_COUNT(METRIC_CLAIM_CHECKS);
+    METRIC_SPAN_END(check, METRIC_CLAIM_CHECK_NS);
+    return result;
+}
+
+
 // ==========================================================
 //                STUDENT VERIFICATION PROCESS
 // ==========================================================
-bool verifyStudent(Student* student) {
+bool verifyStudent(Queue* q, StudentId student) {
     printf("\n%sVerification Process%s\n", COLOR_YELLOW, COLOR_RESET);
     printf("===================\n");
 
-    StudentData* vData = NULL;
-
-    for (int i = 0; i < verificationDataCount; i++) {
-        if (strcmp(student->reg_number, verificationData[i].reg_number) == 0) {
-            vData = &verificationData[i];
-            break;
-        }
-    }
+    StudentData* vData = findVerificationByReg(q->students.reg_number[student]);
 
     if (!vData) {
         printf("%sVerification Failed! Registration number not found.%s\n",
                COLOR_RED, COLOR_RESET);
+        METRIC_COUNT(METRIC_VERIFY_FAILED);
         return false;
     }
 
@@ -129,6 +383,7 @@ bool verifyStudent(Student* student) {
     if (!isValidDOB(dob) || strcmp(dob, vData->dob) != 0) {
         printf("%sVerification Failed! Invalid Date of Birth.%s\n",
                COLOR_RED, COLOR_RESET);
+        METRIC_COUNT(METRIC_VERIFY_FAILED);
         return false;
     }
 
@@ -139,12 +394,14 @@ bool verifyStudent(Student* student) {
     if (!isValidAadhar(aadhar) || strcmp(aadhar, vData->aadhar) != 0) {
         printf("%sVerification Failed! Invalid Aadhar.%s\n",
                COLOR_RED, COLOR_RESET);
+        METRIC_COUNT(METRIC_VERIFY_FAILED);
         return false;
     }
 
     // Verification success
-    strcpy(student->name, vData->name);
+    setStudentName(q, student, vData->name);
 
     printf("\n%sVerification Successful!%s\n", COLOR_GREEN, COLOR_RESET);
+    METRIC_COUNT(METRIC_VERIFY_PASSED);
     return true;
 }
@@ -0,0 +1,383 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "enhanced_ds.h"
+
+// ==========================================================
+//   WHAT-IF SIMULATION
+//
+//   A snapshot copies the allotment in rank order: each queued
+//   student's seat pools, preference run and seat, and for every
+//   (program, pool) slot its capacity, the positions of its
+//   holders and the positions that asked for it before the seat
+//   they got and were turned away. Nothing
+//   in it changes after it is taken, so any number of simulations
+//   can read it at once while the queue itself moves on.
+//
+//   A simulation replays serial dictatorship from the edited
+//   student with the new list. Seat counts are read through from
+//   the snapshot and only the differences are written, to the
+//   simulation's own slot deltas:
+//     seats at j = capacity - holders before j (base) + diff (this run)
+//   A later student can only end up elsewhere if a slot they were
+//   turned away from has gained a seat, or the slot they hold has
+//   lost more seats than the allotment leaves over. So instead of
+//   walking every student the replay jumps to the next position
+//   that is either, re-seats that one student and recomputes,
+//   until no such position is left.
+// ==========================================================
+
+#define NO_SLOT (-1)
+
+struct AllocationSnapshot {
+    int count;               // Queued students, in rank order
+    int slots;               // programCount * pools
+    int pools;
+    uint8_t* categories;     // 0 for students not verified
+    uint32_t* pref_offset;
+    uint16_t* pref_count;
+    uint16_t* prefs;
+    int* slot;               // Seat held in the allotment, NO_SLOT if none
+    int* capacity;           // Seats per slot
+    int* holder_start;       // Holder positions of slot k: holders[holder_start[k] .. holder_start[k+1])
+    int* holders;
+    int* denied_start;       // Same for the positions the slot turned away
+    int* denied;
+    int* position;           // StudentId -> position, -1 if not queued
+    int student_ids;         // Length of position
+};
+
+void releaseAllocationSnapshot(AllocationSnapshot* snap) {
+    if (snap == NULL) return;
+    free(snap->categories);
+    free(snap->pref_offset);
+    free(snap->pref_count);
+    free(snap->prefs);
+    free(snap->slot);
+    free(snap->capacity);
+    free(snap->holder_start);
+    free(snap->holders);
+    free(snap->denied_start);
+    free(snap->denied);
+    free(snap->position);
+    free(snap);
+}
+
+// Lists every slot the student at position i tried before the seat taken;
+// all of them were full when the allotment reached that student
+static int deniedSlots(const AllocationSnapshot* snap, int i, int* out) {
+    const uint16_t* prefs = snap->prefs + snap->pref_offset[i];
+    int found = 0;
+    for (int j = 0; j < snap->pref_count[i]; j++) {
+        for (int k = 0; k < snap->pools; k++) {
+            if (!(snap->categories[i] & (1u << k))) continue;
+            int slot = k * programCount + prefs[j];
+            if (slot == snap->slot[i]) return found;
+            out[found++] = slot;
+        }
+    }
+    return found;
+}
+
+// Turns per-key counts into CSR offsets; counts[] becomes the write cursor
+static int* countsToOffsets(int* counts, int keys) {
+    int* start = (int*)malloc((keys + 1) * sizeof(int));
+    start[0] = 0;
+    for (int k = 0; k < keys; k++) {
+        start[k + 1] = start[k] + counts[k];
+        counts[k] = start[k];
+    }
+    return start;
+}
+
+// Returns NULL if there is no up-to-date serial allotment to simulate against
+AllocationSnapshot* takeAllocationSnapshot(Queue* q) {
+    if (!q->allocation->valid || q->rounds != NULL || q->allocation->engine != ALLOCATION_SERIAL)
+        return NULL;
+
+    const StudentStore* store = &q->students;
+    AllocationSnapshot* snap = (AllocationSnapshot*)calloc(1, sizeof(AllocationSnapshot));
+    int n = 0, longest = 0;
+    size_t prefTotal = 0;
+    for (StudentId s = q->front; s != NO_STUDENT; s = store->next[s]) {
+        n++;
+        prefTotal += store->num_preferences[s];
+        if (store->num_preferences[s] > longest) longest = store->num_preferences[s];
+    }
+
+    snap->count = n;
+    snap->pools = seatPoolCount;
+    snap->slots = programCount * seatPoolCount;
+    snap->categories = (uint8_t*)malloc(n ? n : 1);
+    snap->pref_offset = (uint32_t*)malloc((n ? n : 1) * sizeof(uint32_t));
+    snap->pref_count = (uint16_t*)malloc((n ? n : 1) * sizeof(uint16_t));
+    snap->prefs = (uint16_t*)malloc((prefTotal ? prefTotal : 1) * sizeof(uint16_t));
+    snap->slot = (int*)malloc((n ? n : 1) * sizeof(int));
+    snap->capacity = (int*)malloc(snap->slots * sizeof(int));
+    memcpy(snap->capacity, seatPoolCount > 1 ? poolCapacity : programCapacity, snap->slots * sizeof(int));
+    snap->student_ids = store->count;
+    snap->position = (int*)malloc((store->count ? store->count : 1) * sizeof(int));
+    for (int i = 0; i < store->count; i++) snap->position[i] = -1;
+
+    size_t used = 0;
+    int i = 0;
+    for (StudentId s = q->front; s != NO_STUDENT; s = store->next[s], i++) {
+        snap->position[s] = i;
+        snap->categories[i] = (store->flags[s] & STUDENT_VERIFIED) ? store->categories[s] : 0;
+        snap->pref_offset[i] = (uint32_t)used;
+        snap->pref_count[i] = snap->categories[i] ? store->num_preferences[s] : 0;
+        memcpy(snap->prefs + used, STUDENT_PREFS(q, s), store->num_preferences[s] * sizeof(uint16_t));
+        used += store->num_preferences[s];
+
+        int program_id = store->allocated_program[s];
+        snap->slot[i] = (program_id >= 0) ? store->allocated_pool[s] * programCount + program_id : NO_SLOT;
+    }
+
+    // Both lists are filled in position order, so each run comes out sorted
+    int* counts = (int*)calloc(snap->slots, sizeof(int));
+    int* tried = (int*)malloc(((size_t)longest * snap->pools + 1) * sizeof(int));
+    for (i = 0; i < n; i++)
+        if (snap->slot[i] != NO_SLOT) counts[snap->slot[i]]++;
+    snap->holder_start = countsToOffsets(counts, snap->slots);
+    snap->holders = (int*)malloc((snap->holder_start[snap->slots] ? snap->holder_start[snap->slots] : 1) * sizeof(int));
+    for (i = 0; i < n; i++)
+        if (snap->slot[i] != NO_SLOT) snap->holders[counts[snap->slot[i]]++] = i;
+
+    memset(counts, 0, snap->slots * sizeof(int));
+    for (i = 0; i < n; i++) {
+        int found = deniedSlots(snap, i, tried);
+        for (int j = 0; j < found; j++) counts[tried[j]]++;
+    }
+    snap->denied_start = countsToOffsets(counts, snap->slots);
+    snap->denied = (int*)malloc((snap->denied_start[snap->slots] ? snap->denied_start[snap->slots] : 1) * sizeof(int));
+    for (i = 0; i < n; i++) {
+        int found = deniedSlots(snap, i, tried);
+        for (int j = 0; j < found; j++) snap->denied[counts[tried[j]]++] = i;
+    }
+    free(tried);
+    free(counts);
+    return snap;
+}
+
+// First entry of the sorted run [from, to) greater than position
+static int firstAfter(const int* list, int from, int to, int position) {
+    while (from < to) {
+        int mid = from + (to - from) / 2;
+        if (list[mid] <= position) from = mid + 1;
+        else to = mid;
+    }
+    return from;
+}
+
+// Seats the allotment still had in the slot when position came up
+static int baseSeats(const AllocationSnapshot* snap, int slot, int position) {
+    int from = snap->holder_start[slot];
+    return snap->capacity[slot] - (firstAfter(snap->holders, from, snap->holder_start[slot + 1], position - 1) - from);
+}
+
+// Private state of one simulation; reused across the edits of a task and
+// cleared through the touched list, so resetting costs what was written
+typedef struct {
+    int* diff;         // Seats in this run minus seats in the allotment
+    uint8_t* listed;   // Slot is in touched
+    int* touched;
+    int touchedCount;
+} SimulationScratch;
+
+static void scratchInit(SimulationScratch* scratch, int slots) {
+    scratch->diff = (int*)calloc(slots, sizeof(int));
+    scratch->listed = (uint8_t*)calloc(slots, 1);
+    scratch->touched = (int*)malloc(slots * sizeof(int));
+    scratch->touchedCount = 0;
+}
+
+static void scratchRelease(SimulationScratch* scratch) {
+    free(scratch->diff);
+    free(scratch->listed);
+    free(scratch->touched);
+}
+
+static void clearDiff(SimulationScratch* scratch) {
+    for (int i = 0; i < scratch->touchedCount; i++) {
+        scratch->diff[scratch->touched[i]] = 0;
+        scratch->listed[scratch->touched[i]] = 0;
+    }
+    scratch->touchedCount = 0;
+}
+
+static void shiftDiff(SimulationScratch* scratch, int slot, int change) {
+    if (!scratch->listed[slot]) {
+        scratch->listed[slot] = 1;
+        scratch->touched[scratch->touchedCount++] = slot;
+    }
+    scratch->diff[slot] += change;
+}
+
+// Next position after j whose seat could differ from the allotment's, or
+// -1. A slot with extra seats can pull in someone the allotment turned
+// away from it; a slot with k seats fewer pushes out its
+// holders from number capacity - k on.
+static int nextEvent(const AllocationSnapshot* snap, const SimulationScratch* scratch, int j) {
+    int next = -1;
+    for (int i = 0; i < scratch->touchedCount; i++) {
+        int slot = scratch->touched[i];
+        int diff = scratch->diff[slot];
+        const int* list;
+        int from, to;
+        if (diff > 0) {
+            list = snap->denied;
+            from = snap->denied_start[slot];
+            to = snap->denied_start[slot + 1];
+        } else if (diff < 0) {
+            // Holder m found capacity - m seats, so the first one to
+            // miss out is number capacity + diff
+            list = snap->holders;
+            from = snap->holder_start[slot] + snap->capacity[slot] + diff;
+            to = snap->holder_start[slot + 1];
+        } else {
+            continue;
+        }
+        int at = firstAfter(list, from, to, j);
+        if (at < to && (next < 0 || list[at] < next)) next = list[at];
+    }
+    return next;
+}
+
+// First (preference, pool) with a seat left in this run
+static int simulateStudent(const AllocationSnapshot* snap, const SimulationScratch* scratch,
+                           int position, const uint16_t* prefs, int count) {
+    uint8_t categories = snap->categories[position];
+    for (int i = 0; i < count; i++) {
+        for (int k = 0; k < snap->pools; k++) {
+            if (!(categories & (1u << k))) continue;
+            int slot = k * programCount + prefs[i];
+            if (baseSeats(snap, slot, position) + scratch->diff[slot] > 0)
+                return slot;
+        }
+    }
+    return NO_SLOT;
+}
+
+static void simulateEdit(const AllocationSnapshot* snap, SimulationScratch* scratch,
+                         const WhatIfEdit* edit, WhatIfOutcome* outcome) {
+    memset(outcome, 0, sizeof(WhatIfOutcome));
+    outcome->program_id = outcome->previous_program = PROGRAM_NOT_ALLOCATED;
+    int start = (edit->student >= 0 && edit->student < snap->student_ids) ?
+                snap->position[edit->student] : -1;
+    if (start < 0) {
+        outcome->program_id = outcome->previous_program = PROGRAM_NOT_ELIGIBLE;
+        return;
+    }
+    if (snap->slot[start] != NO_SLOT) {
+        outcome->previous_program = snap->slot[start] % programCount;
+        outcome->previous_pool = snap->slot[start] / programCount;
+    }
+    if (snap->categories[start] == 0) {
+        outcome->program_id = outcome->previous_program = PROGRAM_NOT_ELIGIBLE;
+        return;
+    }
+
+    for (int j = start; j >= 0; j = nextEvent(snap, scratch, j)) {
+        int taken = (j == start) ?
+            simulateStudent(snap, scratch, j, edit->preferences, edit->count) :
+            simulateStudent(snap, scratch, j, snap->prefs + snap->pref_offset[j], snap->pref_count[j]);
+        int held = snap->slot[j];
+        outcome->evaluated++;
+
+        if (j == start && taken != NO_SLOT) {
+            outcome->program_id = taken % programCount;
+            outcome->pool = taken / programCount;
+        }
+        if (taken != held) {
+            if (j != start) outcome->displaced++;
+            if (held != NO_SLOT) shiftDiff(scratch, held, 1);
+            if (taken != NO_SLOT) shiftDiff(scratch, taken, -1);
+        }
+    }
+    clearDiff(scratch);
+}
+typedef struct {
+    const AllocationSnapshot* snap;
+    const WhatIfEdit* edits;
+    WhatIfOutcome* outcomes;
+    int count;
+    int tasks;
+} WhatIfJob;
+
+static void whatIfTask(void* context, int task) {
+    WhatIfJob* job = (WhatIfJob*)context;
+    int first = (int)((long)job->count * task / job->tasks);
+    int last = (int)((long)job->count * (task + 1) / job->tasks);
+    SimulationScratch scratch;
+    scratchInit(&scratch, job->snap->slots);
+    for (int i = first; i < last; i++)
+        simulateEdit(job->snap, &scratch, &job->edits[i], &job->outcomes[i]);
+    scratchRelease(&scratch);
+}
+
+// Evaluates every edit against the snapshot on the worker threads; each
+// outcome is independent of the others. Returns the time taken.
+double simulateWhatIf(const AllocationSnapshot* snap, const WhatIfEdit* edits,
+                      WhatIfOutcome* outcomes, int count) {
+    double t0 = monotonicSeconds();
+    WhatIfJob job = { snap, edits, outcomes, count, workerThreadCount() };
+    if (job.tasks > count) job.tasks = count;
+    runParallel(whatIfTask, &job, job.tasks);
+    return monotonicSeconds() - t0;
+}
+
+// Asks for a student and a new preference list and shows what the
+// allotment would give without changing it
+void whatIfInteractive(Queue* q) {
+    AllocationSnapshot* snap = takeAllocationSnapshot(q);
+    if (snap == NULL) {
+        printf("\n%sNo up-to-date serial seat allotment: run the allocation first (rounds must not have started).%s\n",
+               COLOR_YELLOW, COLOR_RESET);
+        return;
+    }
+
+    char reg_number[MAX_REG_LENGTH];
+    printf("Enter Registration Number: ");
+    int scanResult = scanf("%9s", reg_number);
+    while (getchar() != '\n');
+    StudentId student = (scanResult == 1) ? findStudentByReg(reg_number) : NO_STUDENT;
+    if (student == NO_STUDENT) {
+        printf("%sError: Student not found!%s\n", COLOR_RED, COLOR_RESET);
+        releaseAllocationSnapshot(snap);
+        return;
+    }
+
+    uint16_t* ids = (uint16_t*)malloc(MAX_PREFERENCES * sizeof(uint16_t));
+    int count = 0;
+    printf("Enter up to %d choice numbers, best first, 0 to finish:\n", MAX_PREFERENCES);
+    while (count < MAX_PREFERENCES) {
+        int choice;
+        printf("Preference %d: ", count + 1);
+        if (scanf("%d", &choice) != 1) {
+            while (getchar() != '\n');
+            continue;
+        }
+        if (choice == 0) break;
+        if (choice < 1 || choice > programCount) {
+            printf("%sError: Choose between 1 and %d%s\n", COLOR_RED, programCount, COLOR_RESET);
+            continue;
+        }
+        ids[count++] = (uint16_t)(choice - 1);
+    }
+    while (getchar() != '\n');
+
+    WhatIfEdit edit = { student, ids, count };
+    WhatIfOutcome outcome;
+    double seconds = simulateWhatIf(snap, &edit, &outcome, 1);
+
+    printf("\n%sWhat-if for %s (rank %d)%s\n", COLOR_BLUE, reg_number, q->students.rank[student], COLOR_RESET);
+    printf("Now      : %s - %s\n", programCollegeName(outcome.previous_program),
+           programBranchName(outcome.previous_program));
+    printf("Would get: %s - %s", programCollegeName(outcome.program_id), programBranchName(outcome.program_id));
+    if (seatPoolCount > 1 && outcome.program_id >= 0) printf(" (%s)", seatPoolName(outcome.pool));
+    printf("\n%d other student(s) would change seats; %d evaluated in %.3f ms. Nothing was changed.\n",
+           outcome.displaced, outcome.evaluated, seconds * 1000.0);
+
+    free(ids);
+    releaseAllocationSnapshot(snap);
+}
@@ -0,0 +1,133 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "enhanced_ds.h"
+
+// ==========================================================
+//   WORKER THREADS
+//
+//   A fixed set of threads, started on first use. runParallel
+//   hands task numbers 0..tasks-1 to the workers and to the
+//   calling thread and returns once every task has finished.
+//   Tasks must write to disjoint memory; anything that depends
+//   on order is merged by the caller afterwards, so results do
+//   not depend on the thread count. Calls do not nest.
+// ==========================================================
+
+static pthread_mutex_t workerLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t workAvailable = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t workFinished = PTHREAD_COND_INITIALIZER;
+
+static pthread_t* workers = NULL;
+static int workerCount = 0;       // Threads started, not counting the caller
+static int requestedThreads = 0;  // 0 = one per online CPU
+static bool stopping = false;
+
+// The job being run; guarded by workerLock
+static ParallelTask jobTask = NULL;
+static void* jobContext = NULL;
+static int jobTasks = 0;
+static int nextTask = 0;
+static int finishedTasks = 0;
+static unsigned generation = 0;
+
+// Called with workerLock held; runs tasks until none are left to hand out
+static void drainTasks(void) {
+    while (nextTask < jobTasks) {
+        int task = nextTask++;
+        pthread_mutex_unlock(&workerLock);
+        jobTask(jobContext, task);
+        pthread_mutex_lock(&workerLock);
+        if (++finishedTasks == jobTasks)
+            pthread_cond_broadcast(&workFinished);
+    }
+}
+
+static void* workerMain(void* arg) {
+    (void)arg;
+    unsigned seen = 0;
+    pthread_mutex_lock(&workerLock);
+    while (1) {
+        while (generation == seen && !stopping)
+            pthread_cond_wait(&workAvailable, &workerLock);
+        if (stopping) break;
+        seen = generation;
+        drainTasks();
+    }
+    pthread_mutex_unlock(&workerLock);
+    return NULL;
+}
+
+static void startWorkers(void) {
+    static bool registered = false;
+    if (workers != NULL) return;
+
+    int threads = requestedThreads;
+    if (threads <= 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = online > 0 ? (int)online : 1;
+    }
+    if (threads > MAX_WORKER_THREADS) threads = MAX_WORKER_THREADS;
+
+    stopping = false;
+    workers = (pthread_t*)malloc(threads * sizeof(pthread_t));
+    workerCount = 0;
+    for (int i = 1; i < threads; i++) {
+        if (pthread_create(&workers[workerCount], NULL, workerMain, NULL) != 0)
+            break;  // Run with the threads we have
+        workerCount++;
+    }
+    if (!registered) {
+        atexit(stopWorkers);
+        registered = true;
+    }
+}
+
+void stopWorkers(void) {
+    if (workers == NULL) return;
+    pthread_mutex_lock(&workerLock);
+    stopping = true;
+    pthread_cond_broadcast(&workAvailable);
+    pthread_mutex_unlock(&workerLock);
+    for (int i = 0; i < workerCount; i++)
+        pthread_join(workers[i], NULL);
+    free(workers);
+    workers = NULL;
+    workerCount = 0;
+}
+
+// Takes effect for the next runParallel; 0 means one thread per online CPU
+void setWorkerThreads(int threads) {
+    stopWorkers();
+    requestedThreads = threads;
+}
+
+int workerThreadCount(void) {
+    startWorkers();
+    return workerCount + 1;
+}
+
+void runParallel(ParallelTask task, void* context, int tasks) {
+    if (tasks <= 0) return;
+    startWorkers();
+    if (workerCount == 0 || tasks == 1) {
+        for (int i = 0; i < tasks; i++) task(context, i);
+        return;
+    }
+
+    pthread_mutex_lock(&workerLock);
+    jobTask = task;
+    jobContext = context;
+    jobTasks = tasks;
+    nextTask = 0;
+    finishedTasks = 0;
+    generation++;
+    pthread_cond_broadcast(&workAvailable);
+
+    drainTasks();
+    while (finishedTasks < jobTasks)
+        pthread_cond_wait(&workFinished, &workerLock);
+    pthread_mutex_unlock(&workerLock);
+}